@@ -1,10 +1,25 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <limits>
 #include <utility>
 #include <tuple>
+#include <unordered_set>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace drop{
 namespace math{
@@ -339,6 +354,11 @@ namespace math{
 				return (!index ? this->x : this->y);
 			}
 
+			inline constexpr
+			auto operator[](const int& index) const -> float {
+				return (!index ? this->x : this->y);
+			}
+
 			auto operator%=(const int& d)  -> void = delete;
 			auto operator&=(const int& d)  -> void = delete;
 			auto operator|=(const int& d)  -> void = delete;
@@ -714,6 +734,15 @@ namespace math{
 				}
 			}
 
+			inline constexpr
+			auto operator[](const int& index) const -> float {
+				switch(index){
+					case 0:  return this->x;
+					case 1:  return this->y;
+					default: return this->z;
+				}
+			}
+
 			auto operator%=(const int& d)  -> void = delete;
 			auto operator&=(const int& d)  -> void = delete;
 			auto operator|=(const int& d)  -> void = delete;
@@ -1041,6 +1070,16 @@ namespace math{
 				}
 			}
 
+			inline constexpr
+			auto operator[](const int& index) const -> float {
+				switch(index){
+					case 0:  return this->x;
+					case 1:  return this->y;
+					case 2:	 return this->z;
+					default: return this->w;
+				}
+			}
+
 			auto operator%=	(const int& d) -> void = delete;
 			auto operator&=	(const int& d) -> void = delete;
 			auto operator|=	(const int& d) -> void = delete;
@@ -1340,6 +1379,11 @@ namespace math{
 			}
 		}
 
+		inline constexpr
+		auto operator[](int index) const -> const Vector2& {
+			return (!index ? this->i : this->j);
+		}
+
 		inline constexpr
 		auto operator!=(const Matrix_2x2& other) const -> bool {
 			return !(*this==other);
@@ -1361,6 +1405,204 @@ namespace math{
    		return out;
    	}
 
+	/**
+	 *  2D affine transform: a Matrix_2x2 (columns i, j) plus a translation t.
+	 *  Points are mapped as p' = i*x + j*y + t.
+	 */
+	class Matrix_2x3 {
+		Vector2 i, j, t;
+	public:
+		inline static constexpr
+		auto identity() -> Matrix_2x3 {
+			return Matrix_2x3(1.f, 0.f, 0.f, 1.f, 0.f, 0.f);
+		}
+
+		inline static constexpr
+		auto translation(const Vector2& offset) -> Matrix_2x3 {
+			return Matrix_2x3({1.f, 0.f}, {0.f, 1.f}, offset);
+		}
+
+		inline static
+		auto rotation(float angle_deg=90.f) -> Matrix_2x3 {
+			return Matrix_2x3(Matrix_2x2::rotation(angle_deg), {0.f, 0.f});
+		}
+
+		inline static constexpr
+		auto scale(float sx, float sy) -> Matrix_2x3 {
+			return Matrix_2x3(sx, 0.f, 0.f, sy, 0.f, 0.f);
+		}
+
+		inline constexpr
+		Matrix_2x3():
+		i{1.f, 0.f}, j{0.f, 1.f}, t{0.f, 0.f}{}
+
+		inline constexpr
+		Matrix_2x3(const Vector2& i, const Vector2& j, const Vector2& t)
+		:i{i}, j{j}, t{t}{}
+
+		inline constexpr
+		Matrix_2x3(const Matrix_2x2& linear, const Vector2& t)
+		:i{linear[0]}, j{linear[1]}, t{t}{}
+
+		inline constexpr
+		Matrix_2x3(float x1, float x2, float x3, float x4, float x5, float x6):
+		i(x1, x2), j(x3, x4), t(x5, x6){}
+
+		inline constexpr
+		auto getLinear() const -> Matrix_2x2 {
+			return Matrix_2x2(i, j);
+		}
+
+		inline constexpr
+		auto getTranslation() const -> const Vector2& {
+			return this->t;
+		}
+
+		inline constexpr
+		auto determinant() const -> float {
+			return (i.getX()*j.getY()) - (i.getY()*j.getX());
+		}
+
+		inline
+		auto inverted() const -> Matrix_2x3 {
+			const auto inv_det{ 1.f/determinant() };
+			const auto ni{ Vector2( j.getY()*inv_det, -i.getY()*inv_det) };
+			const auto nj{ Vector2(-j.getX()*inv_det,  i.getX()*inv_det) };
+			return Matrix_2x3(ni, nj, Vector2(
+				-(ni.getX()*t.getX() + nj.getX()*t.getY()),
+				-(ni.getY()*t.getX() + nj.getY()*t.getY())
+			));
+		}
+
+		inline
+		auto _invert() -> Matrix_2x3& {
+			*this = inverted();
+			return *this;
+		}
+
+		inline constexpr
+		auto applyTo(const Vector2& p) const -> Vector2 {
+			return Vector2(
+				i.getX()*p.getX() + j.getX()*p.getY() + t.getX(),
+				i.getY()*p.getX() + j.getY()*p.getY() + t.getY()
+			);
+		}
+
+		inline constexpr
+		auto applyToDirection(const Vector2& d) const -> Vector2 {
+			return Vector2(
+				i.getX()*d.getX() + j.getX()*d.getY(),
+				i.getY()*d.getX() + j.getY()*d.getY()
+			);
+		}
+
+		/**
+		 *  Composes both transforms, the result applies m first and this second.
+		 */
+		inline constexpr
+		auto applyTo(const Matrix_2x3& m) const -> Matrix_2x3 {
+			return Matrix_2x3(
+				applyToDirection(m.i),
+				applyToDirection(m.j),
+				applyTo(m.t)
+			);
+		}
+
+		inline
+		auto transform_points(const Vector2* in, Vector2* out, std::size_t count)
+		const -> void {
+			const auto ix{ i.getX() }, iy{ i.getY() };
+			const auto jx{ j.getX() }, jy{ j.getY() };
+			const auto tx{ t.getX() }, ty{ t.getY() };
+			for(std::size_t n{0}; n<count; ++n){
+				const auto x{ in[n].getX() };
+				const auto y{ in[n].getY() };
+				out[n].set(ix*x + jx*y + tx, iy*x + jy*y + ty);
+			}
+		}
+
+		/**
+		 *  Structure of arrays variant of transform_points, in and out may alias.
+		 */
+		inline
+		auto transform_points(const float* xs, const float* ys,
+							  float* out_xs, float* out_ys, std::size_t count)
+		const -> void {
+			const auto ix{ i.getX() }, iy{ i.getY() };
+			const auto jx{ j.getX() }, jy{ j.getY() };
+			const auto tx{ t.getX() }, ty{ t.getY() };
+			for(std::size_t n{0}; n<count; ++n){
+				const auto x{ xs[n] };
+				const auto y{ ys[n] };
+				out_xs[n] = ix*x + jx*y + tx;
+				out_ys[n] = iy*x + jy*y + ty;
+			}
+		}
+
+		inline constexpr
+		auto operator*(const Matrix_2x3& other) const -> Matrix_2x3 {
+			return this->applyTo(other);
+		}
+
+		inline constexpr
+		auto operator*(const Vector2& p) const -> Vector2 {
+			return this->applyTo(p);
+		}
+
+		inline 
+		auto operator=(const Matrix_2x3& other) -> Matrix_2x3& {
+			this->i.set(other.i);
+			this->j.set(other.j);
+			this->t.set(other.t);
+			
+			return *this;
+		}
+
+		inline 
+		auto operator*=(const Matrix_2x3& other) -> Matrix_2x3& {
+			*this = this->applyTo(other);
+			return *this;
+		}
+
+		inline constexpr
+		auto operator==(const Matrix_2x3& other) const -> bool {
+			return (i == other.i)
+				&& (j == other.j)
+				&& (t == other.t);
+		}
+
+		inline constexpr
+		auto operator!=(const Matrix_2x3& other) const -> bool {
+			return !(*this==other);
+		}
+
+		inline constexpr
+		auto operator[](int index) const -> const Vector2& {
+			switch(index){	
+				case 0: return this->i;	
+				case 1: return this->j;
+				default: return this->t;	
+			}
+		}
+
+		friend inline
+		auto operator<<(std::ostream &out, const Matrix_2x3& m)
+		-> std::ostream&;
+	};
+
+	inline 
+	auto operator<<(std::ostream &out, const Matrix_2x3& m) 
+	-> std::ostream& {
+       	out << "[ " 	<< m.i.getX() 
+			<< " | " 	<< m.j.getX() 
+			<< " | " 	<< m.t.getX() 
+			<< " ]\n[ " << m.i.getY() 
+			<< " | " 	<< m.j.getY() 
+			<< " | " 	<< m.t.getY() 
+			<< " ]";
+   		return out;
+   	}
+
 	class Matrix_3x3 {
 		Vector3 i, j, k;
 	public:
@@ -1383,6 +1625,9 @@ namespace math{
 		Matrix_3x3(Vector3&& i, Vector3&& j, Vector3&& k)
 		:i{i}, j{j}, k{k}{}
 
+		inline constexpr
+		Matrix_3x3(const Matrix_3x3& other) = default;
+
 		inline constexpr
 		Matrix_3x3(float x1, float x2, float x3, 
 				   float x4, float x5, float x6,
@@ -1661,6 +1906,15 @@ namespace math{
 			}
 		}
 
+		inline constexpr
+		auto operator[](int index) const -> const Vector3& {
+			switch(index){	
+				case 0: return this->i;	
+				case 1: return this->j;
+				default: return this->k;	
+			}
+		}
+
 		inline 
 		auto operator=(const Matrix_3x3& other) -> Matrix_3x3&{
 			this->i.set(other.i);
@@ -2136,6 +2390,16 @@ namespace math{
 			}
 		}
 
+		inline constexpr
+		auto operator[](int index) const -> const Vector4& {
+			switch(index){	
+				case 0: 	return this->i;	
+				case 1: 	return this->j;	
+				case 2: 	return this->k;	
+				default: 	return this->l;	
+			}
+		}
+
 		inline constexpr
 		auto operator==(const Matrix_4x4& other) const -> bool {
 			return (i == other.i)
@@ -2266,234 +2530,8292 @@ namespace math{
 	}
 
 	class Rect {
-		float x, y;
-		float width, height;
+		float x_min, y_min;
+		float x_max, y_max;
 		
 	public:
+		/**
+		 *  Inverted infinite rect, merging anything into it yields that thing.
+		 */
+		inline static constexpr
+		auto empty() -> Rect {
+			return Rect(Vector2(inf, inf), Vector2(-inf, -inf));
+		}
+
 		inline constexpr
 		Rect(float x, float y, float width, float height)
-		:x{x}, y{y}, width{width}, height{height}{}
+		:x_min{ width  > 0 ? x : x+width  }, y_min{ height > 0 ? y : y+height },
+		 x_max{ width  > 0 ? x+width  : x }, y_max{ height > 0 ? y+height : y }{}
 
-		inline 
+		inline constexpr
+		Rect(const Vector2& min, const Vector2& max)
+		:x_min{min.getX()}, y_min{min.getY()}, x_max{max.getX()}, y_max{max.getY()}{}
+
+		inline constexpr
 		auto getXMin() const -> float {
-			if(width > 0) [[likely]] return x;
-			return x+width;
+			return x_min;
 		}
 
-		inline 
+		inline constexpr
 		auto getXMax() const -> float {
-			if(width > 0) [[likely]] return x+width;
-			return x;
+			return x_max;
 		}
 
-		inline 
+		inline constexpr
 		auto getYMax() const -> float {
-			if(height > 0) [[likely]] return y+height;
-			return y;
+			return y_max;
 		}
 
-		inline 
+		inline constexpr
 		auto getYMin() const -> float {
-			if(height > 0) [[likely]] return y;
-			return y+height;
+			return y_min;
 		}
-	};
-
-	class Plane3 {
-		Vector3 dir, r1, r2;
 
-	public:
 		inline constexpr
-		Plane3(const Vector3& dir, const Vector3& span1, const Vector3& span2):
-			dir{dir}, r1{span1}, r2{span2} {}
+		auto getMin() const -> Vector2 {
+			return Vector2(x_min, y_min);
+		}
 
 		inline constexpr
-		auto getNormal() const -> const Vector3 {
-			return r1.cross_prod(r2); 
+		auto getMax() const -> Vector2 {
+			return Vector2(x_max, y_max);
 		}
 
-		inline 
-		auto isParallel(const Plane3& other) -> bool {
-			return this->getNormal().cross_prod(other.getNormal()).equals( {0.f, 0.f, 0.f} );
+		inline constexpr
+		auto getWidth() const -> float {
+			return x_max - x_min;
 		}
 
-		inline
-		auto distance(const Plane3& other) -> float {
-			if(!isParallel(other)) return 0.f;
-			return fabs(this->getNormal().dot_prod(r2-r1))
-				 / this->getNormal().length();
+		inline constexpr
+		auto getHeight() const -> float {
+			return y_max - y_min;
 		}
-	};
 
-	class Line2 {
-		Vector2 a, b;
-	public:
 		inline constexpr
-		Line2(const Vector2& from, const Vector2& to)
-		:a{from}, b{to} {}
+		auto getCenter() const -> Vector2 {
+			return Vector2((x_min+x_max)*0.5f, (y_min+y_max)*0.5f);
+		}
 
 		inline constexpr
-		Line2(Vector2&& from, Vector2&& to)
-		:a{from}, b{to} {}
+		auto isEmpty() const -> bool {
+			return x_min > x_max || y_min > y_max;
+		}
 
 		inline constexpr
-		auto getFrom() const -> const Vector2& {
-			return a;
+		auto area() const -> float {
+			return getWidth()*getHeight();
 		}
 
 		inline constexpr
-		auto getTo() const -> const Vector2 {
-			return b;
+		auto perimeter() const -> float {
+			return 2.f*(getWidth()+getHeight());
 		}
 
-		inline 
-		auto intersect_fraction(const Rect& rectangle) const -> float {
-			auto fract{ Vector2(
-				((rectangle.getYMin() - a.getY())/(b.getY() - a.getY())),
-				((rectangle.getXMin() - a.getX())/(b.getX() - a.getX()))
-			)};
-			
-			return fract.getX() > fract.getY() ? fract.getX() : fract.getY();
+		inline constexpr
+		auto merged(const Rect& other) const -> Rect {
+			return Rect(
+				Vector2(std::min(x_min, other.x_min), std::min(y_min, other.y_min)),
+				Vector2(std::max(x_max, other.x_max), std::max(y_max, other.y_max))
+			);
 		}
 
 		inline constexpr
-		auto asVec2() const -> Vector2 {
-			return (b-a);
+		auto merged(const Vector2& p) const -> Rect {
+			return Rect(
+				Vector2(std::min(x_min, p.getX()), std::min(y_min, p.getY())),
+				Vector2(std::max(x_max, p.getX()), std::max(y_max, p.getY()))
+			);
 		}
 
-		inline constexpr
-		auto intersect_point(const Rect& rectangle) const -> Vector2 {
-			return a+intersect_fraction(rectangle)*asVec2();
+		inline
+		auto _merge(const Rect& other) -> Rect& {
+			x_min = std::min(x_min, other.x_min);
+			y_min = std::min(y_min, other.y_min);
+			x_max = std::max(x_max, other.x_max);
+			y_max = std::max(y_max, other.y_max);
+			return *this;
 		}
-		
+
 		inline
-		auto disctance_to(const Vector2& point) const -> float {
-			return point.subtract(a.add(a.to(point).project(asVec2()))).length();	
+		auto _merge(const Vector2& p) -> Rect& {
+			x_min = std::min(x_min, p.getX());
+			y_min = std::min(y_min, p.getY());
+			x_max = std::max(x_max, p.getX());
+			y_max = std::max(y_max, p.getY());
+			return *this;
 		}
-	};
 
-	class Line3 {
-		Vector3 a, b;
-	public:
+		/**
+		 *  The overlapping region, isEmpty() if the rects are disjoint.
+		 */
 		inline constexpr
-		Line3(const Vector3& from, const Vector3& to)
-		:a{from}, b{to} {}
+		auto intersected(const Rect& other) const -> Rect {
+			return Rect(
+				Vector2(std::max(x_min, other.x_min), std::max(y_min, other.y_min)),
+				Vector2(std::min(x_max, other.x_max), std::min(y_max, other.y_max))
+			);
+		}
 
 		inline constexpr
-		Line3(Vector3&& from, Vector3&& to)
-		:a{from}, b{to} {}
+		auto intersects(const Rect& other) const -> bool {
+			return x_min <= other.x_max && other.x_min <= x_max
+				&& y_min <= other.y_max && other.y_min <= y_max;
+		}
 
 		inline constexpr
-		auto getFrom() const -> const Vector3& {
-			return a;
+		auto contains(const Vector2& p) const -> bool {
+			return p.getX() >= x_min && p.getX() <= x_max
+				&& p.getY() >= y_min && p.getY() <= y_max;
 		}
 
 		inline constexpr
-		auto getTo() const -> const Vector3 {
-			return b;
+		auto contains(const Rect& other) const -> bool {
+			return other.x_min >= x_min && other.x_max <= x_max
+				&& other.y_min >= y_min && other.y_max <= y_max;
 		}
 
 		inline constexpr
-		auto getDir() const -> const Vector3 {
-			return (b-a);
+		auto expanded(float margin) const -> Rect {
+			return Rect(
+				Vector2(x_min-margin, y_min-margin),
+				Vector2(x_max+margin, y_max+margin)
+			);
 		}
 
 		inline constexpr
-		auto asVec3() const -> Vector3 {
-			return this->getDir();
+		auto operator==(const Rect& other) const -> bool {
+			return getMin() == other.getMin() && getMax() == other.getMax();
+		}
+
+		inline constexpr
+		auto operator!=(const Rect& other) const -> bool {
+			return !(*this==other);
 		}
 	};
 
 	inline 
-    auto lerp(const float& goal, const float& current, const float& step)-> float {
-    	auto dif{ goal - current };
-    	if(dif > step) [[likely]] return current+step;
-    	if(dif < -step) return current-step;
-    	else [[unlikely]] return goal;
-    }
+	auto operator<<(std::ostream &out, const Rect& r) 
+	-> std::ostream& {
+       	out << "[Min: " << r.getMin() << " Max: " << r.getMax() << " ]";
+   		return out;
+   	}
 
-    inline
-    auto lerp(const Vector2& goal, const Vector2& current, const float& step)-> Vector2 {
-		auto fwd{ goal-current };
-		fwd._normalize()._scale(step);
-		return current.add(fwd);
+	class AABB3 {
+		float lower[3];
+		float upper[3];
+
+	public:
+		/**
+		 *  Inverted infinite box, merging anything into it yields that thing.
+		 */
+		inline static constexpr
+		auto empty() -> AABB3 {
+			return AABB3(Vector3(inf, inf, inf), Vector3(-inf, -inf, -inf));
+		}
+
+		inline constexpr
+		AABB3(): lower{inf, inf, inf}, upper{-inf, -inf, -inf}{}
+
+		inline constexpr
+		AABB3(const Vector3& min, const Vector3& max)
+		:lower{min.getX(), min.getY(), min.getZ()},
+		 upper{max.getX(), max.getY(), max.getZ()}{}
+
+		/**
+		 *  Flat box in the z=0 plane, lets 2D data use the 3D structures.
+		 */
+		inline constexpr
+		explicit AABB3(const Rect& r)
+		:lower{r.getXMin(), r.getYMin(), 0.f},
+		 upper{r.getXMax(), r.getYMax(), 0.f}{}
+
+		inline constexpr
+		auto getMin() const -> Vector3 {
+			return Vector3(lower[0], lower[1], lower[2]);
+		}
+
+		inline constexpr
+		auto getMax() const -> Vector3 {
+			return Vector3(upper[0], upper[1], upper[2]);
+		}
+
+		inline constexpr
+		auto getMin(int axis) const -> float {
+			return lower[axis];
+		}
+
+		inline constexpr
+		auto getMax(int axis) const -> float {
+			return upper[axis];
+		}
+
+		inline constexpr
+		auto getCenter() const -> Vector3 {
+			return Vector3(
+				(lower[0]+upper[0])*0.5f,
+				(lower[1]+upper[1])*0.5f,
+				(lower[2]+upper[2])*0.5f
+			);
+		}
+
+		inline constexpr
+		auto getCenter(int axis) const -> float {
+			return (lower[axis]+upper[axis])*0.5f;
+		}
+
+		inline constexpr
+		auto getExtents() const -> Vector3 {
+			return Vector3(
+				(upper[0]-lower[0])*0.5f,
+				(upper[1]-lower[1])*0.5f,
+				(upper[2]-lower[2])*0.5f
+			);
+		}
+
+		inline constexpr
+		auto isEmpty() const -> bool {
+			return lower[0] > upper[0] || lower[1] > upper[1] || lower[2] > upper[2];
+		}
+
+		inline constexpr
+		auto surface_area() const -> float {
+			const auto dx{ upper[0]-lower[0] };
+			const auto dy{ upper[1]-lower[1] };
+			const auto dz{ upper[2]-lower[2] };
+			return 2.f*(dx*dy + dy*dz + dz*dx);
+		}
+
+		inline constexpr
+		auto volume() const -> float {
+			return (upper[0]-lower[0])*(upper[1]-lower[1])*(upper[2]-lower[2]);
+		}
+
+		inline constexpr
+		auto largest_axis() const -> int {
+			const auto dx{ upper[0]-lower[0] };
+			const auto dy{ upper[1]-lower[1] };
+			const auto dz{ upper[2]-lower[2] };
+			return (dx >= dy && dx >= dz) ? 0 : (dy >= dz ? 1 : 2);
+		}
+
+		inline constexpr
+		auto merged(const AABB3& other) const -> AABB3 {
+			return AABB3(
+				Vector3(std::min(lower[0], other.lower[0]),
+						std::min(lower[1], other.lower[1]),
+						std::min(lower[2], other.lower[2])),
+				Vector3(std::max(upper[0], other.upper[0]),
+						std::max(upper[1], other.upper[1]),
+						std::max(upper[2], other.upper[2]))
+			);
+		}
+
+		inline constexpr
+		auto merged(const Vector3& p) const -> AABB3 {
+			return AABB3(
+				Vector3(std::min(lower[0], p.getX()),
+						std::min(lower[1], p.getY()),
+						std::min(lower[2], p.getZ())),
+				Vector3(std::max(upper[0], p.getX()),
+						std::max(upper[1], p.getY()),
+						std::max(upper[2], p.getZ()))
+			);
+		}
+
+		inline
+		auto _merge(const AABB3& other) -> AABB3& {
+			for(int a{0}; a<3; ++a){
+				lower[a] = std::min(lower[a], other.lower[a]);
+				upper[a] = std::max(upper[a], other.upper[a]);
+			}
+			return *this;
+		}
+
+		inline
+		auto _merge(const Vector3& p) -> AABB3& {
+			for(int a{0}; a<3; ++a){
+				lower[a] = std::min(lower[a], p[a]);
+				upper[a] = std::max(upper[a], p[a]);
+			}
+			return *this;
+		}
+
+		/**
+		 *  The overlapping region, isEmpty() if the boxes are disjoint.
+		 */
+		inline constexpr
+		auto intersected(const AABB3& other) const -> AABB3 {
+			return AABB3(
+				Vector3(std::max(lower[0], other.lower[0]),
+						std::max(lower[1], other.lower[1]),
+						std::max(lower[2], other.lower[2])),
+				Vector3(std::min(upper[0], other.upper[0]),
+						std::min(upper[1], other.upper[1]),
+						std::min(upper[2], other.upper[2]))
+			);
+		}
+
+		inline constexpr
+		auto intersects(const AABB3& other) const -> bool {
+			return lower[0] <= other.upper[0] && other.lower[0] <= upper[0]
+				&& lower[1] <= other.upper[1] && other.lower[1] <= upper[1]
+				&& lower[2] <= other.upper[2] && other.lower[2] <= upper[2];
+		}
+
+		inline constexpr
+		auto contains(const Vector3& p) const -> bool {
+			return p.getX() >= lower[0] && p.getX() <= upper[0]
+				&& p.getY() >= lower[1] && p.getY() <= upper[1]
+				&& p.getZ() >= lower[2] && p.getZ() <= upper[2];
+		}
+
+		inline constexpr
+		auto contains(const AABB3& other) const -> bool {
+			return other.lower[0] >= lower[0] && other.upper[0] <= upper[0]
+				&& other.lower[1] >= lower[1] && other.upper[1] <= upper[1]
+				&& other.lower[2] >= lower[2] && other.upper[2] <= upper[2];
+		}
+
+		inline constexpr
+		auto expanded(float margin) const -> AABB3 {
+			return AABB3(
+				Vector3(lower[0]-margin, lower[1]-margin, lower[2]-margin),
+				Vector3(upper[0]+margin, upper[1]+margin, upper[2]+margin)
+			);
+		}
+
+		/**
+		 *  Bounds of the transformed box (Arvo's method), m is an affine
+		 *  transform with the translation in its last column.
+		 */
+		inline
+		auto transformed(const Matrix_4x4& m) const -> AABB3 {
+			float out_lower[3], out_upper[3];
+			for(int r{0}; r<3; ++r){
+				out_lower[r] = out_upper[r] = m[3][r];
+				for(int c{0}; c<3; ++c){
+					const auto a{ m[c][r]*lower[c] };
+					const auto b{ m[c][r]*upper[c] };
+					out_lower[r] += std::min(a, b);
+					out_upper[r] += std::max(a, b);
+				}
+			}
+			return AABB3(
+				Vector3(out_lower[0], out_lower[1], out_lower[2]),
+				Vector3(out_upper[0], out_upper[1], out_upper[2])
+			);
+		}
+
+		inline constexpr
+		auto operator==(const AABB3& other) const -> bool {
+			return getMin() == other.getMin() && getMax() == other.getMax();
+		}
+
+		inline constexpr
+		auto operator!=(const AABB3& other) const -> bool {
+			return !(*this==other);
+		}
+	};
+
+	inline 
+	auto operator<<(std::ostream &out, const AABB3& box) 
+	-> std::ostream& {
+       	out << "[Min: " << box.getMin() << " Max: " << box.getMax() << " ]";
+   		return out;
+   	}
+
+	/**
+	 *  Resolves a requested thread count, 0 means all hardware threads.
+	 */
+	inline
+	auto worker_count(unsigned requested=0) -> unsigned {
+		if(requested) return requested;
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/**
+	 *  Splits [0, count) into at most worker_count(thread_count) chunks of at
+	 *  least min_chunk elements and runs func(begin, end, chunk) for each.
+	 *  The calling thread takes chunk 0. Returns the number of chunks used.
+	 */
+	template<typename Func>
+	inline
+	auto parallel_for(std::size_t count, std::size_t min_chunk, Func&& func,
+					  unsigned thread_count=0) -> std::size_t {
+		if(!count) return 0;
+		min_chunk = std::max<std::size_t>(min_chunk, 1);
+		const auto chunks{ std::min<std::size_t>(
+			worker_count(thread_count), (count+min_chunk-1)/min_chunk
+		)};
+		if(chunks <= 1){
+			func(std::size_t{0}, count, std::size_t{0});
+			return 1;
+		}
+
+		const auto step{ (count+chunks-1)/chunks };
+		std::vector<std::thread> workers;
+		workers.reserve(chunks-1);
+		for(std::size_t c{1}; c<chunks; ++c){
+			const auto begin{ std::min(count, c*step) };
+			const auto end{ std::min(count, begin+step) };
+			workers.emplace_back([&func, begin, end, c]{ func(begin, end, c); });
+		}
+		func(std::size_t{0}, std::min(count, step), std::size_t{0});
+		for(auto& worker : workers) worker.join();
+		return chunks;
+	}
+
+	inline
+	auto compute_bounds(const Vector2* points, std::size_t count) -> Rect {
+		auto bounds{ Rect::empty() };
+		for(std::size_t n{0}; n<count; ++n)
+			bounds._merge(points[n]);
+		return bounds;
+	}
+
+	/**
+	 *  Four independent accumulators per axis so the min/max chains
+	 *  do not serialise on each other.
+	 */
+	inline
+	auto compute_bounds(const Vector3* points, std::size_t count) -> AABB3 {
+		float lo[3][4], hi[3][4];
+		for(int a{0}; a<3; ++a)
+			for(int l{0}; l<4; ++l){ lo[a][l] = inf; hi[a][l] = -inf; }
+
+		std::size_t n{0};
+		for(; n+4<=count; n+=4)
+			for(int l{0}; l<4; ++l){
+				const auto& p{ points[n+l] };
+				lo[0][l] = std::min(lo[0][l], p.getX()); hi[0][l] = std::max(hi[0][l], p.getX());
+				lo[1][l] = std::min(lo[1][l], p.getY()); hi[1][l] = std::max(hi[1][l], p.getY());
+				lo[2][l] = std::min(lo[2][l], p.getZ()); hi[2][l] = std::max(hi[2][l], p.getZ());
+			}
+		for(; n<count; ++n){
+			const auto& p{ points[n] };
+			lo[0][0] = std::min(lo[0][0], p.getX()); hi[0][0] = std::max(hi[0][0], p.getX());
+			lo[1][0] = std::min(lo[1][0], p.getY()); hi[1][0] = std::max(hi[1][0], p.getY());
+			lo[2][0] = std::min(lo[2][0], p.getZ()); hi[2][0] = std::max(hi[2][0], p.getZ());
+		}
+
+		float rlo[3], rhi[3];
+		for(int a{0}; a<3; ++a){
+			rlo[a] = std::min(std::min(lo[a][0], lo[a][1]), std::min(lo[a][2], lo[a][3]));
+			rhi[a] = std::max(std::max(hi[a][0], hi[a][1]), std::max(hi[a][2], hi[a][3]));
+		}
+		return AABB3(Vector3(rlo[0], rlo[1], rlo[2]), Vector3(rhi[0], rhi[1], rhi[2]));
+	}
+
+	/**
+	 *  Structure of arrays variant, the fixed width lane loop vectorises.
+	 */
+	inline
+	auto compute_bounds(const float* xs, const float* ys, const float* zs,
+						std::size_t count) -> AABB3 {
+		constexpr std::size_t lanes{ 8 };
+		const float* axes[3]{ xs, ys, zs };
+		float rlo[3], rhi[3];
+		for(int a{0}; a<3; ++a){
+			float lo[lanes], hi[lanes];
+			for(std::size_t l{0}; l<lanes; ++l){ lo[l] = inf; hi[l] = -inf; }
+
+			const auto* v{ axes[a] };
+			std::size_t n{0};
+			for(; n+lanes<=count; n+=lanes)
+				for(std::size_t l{0}; l<lanes; ++l){
+					lo[l] = v[n+l] < lo[l] ? v[n+l] : lo[l];
+					hi[l] = v[n+l] > hi[l] ? v[n+l] : hi[l];
+				}
+			for(; n<count; ++n){
+				lo[0] = std::min(lo[0], v[n]);
+				hi[0] = std::max(hi[0], v[n]);
+			}
+
+			rlo[a] = *std::min_element(lo, lo+lanes);
+			rhi[a] = *std::max_element(hi, hi+lanes);
+		}
+		return AABB3(Vector3(rlo[0], rlo[1], rlo[2]), Vector3(rhi[0], rhi[1], rhi[2]));
+	}
+
+	/**
+	 *  compute_bounds split across threads, each chunk is reduced
+	 *  independently and the partial boxes are merged at the end.
+	 */
+	inline
+	auto compute_bounds_parallel(const Vector3* points, std::size_t count,
+								 unsigned thread_count=0) -> AABB3 {
+		std::vector<AABB3> partial(worker_count(thread_count));
+		const auto chunks{ parallel_for(count, 1u << 16,
+			[&](std::size_t begin, std::size_t end, std::size_t chunk){
+				partial[chunk] = compute_bounds(points+begin, end-begin);
+			}, thread_count)
+		};
+
+		auto bounds{ AABB3::empty() };
+		for(std::size_t c{0}; c<chunks; ++c)
+			bounds._merge(partial[c]);
+		return bounds;
+	}
+
+	/**
+	 *  Writes the four transformed corners of every rect to out_corners
+	 *  (4*count entries, counter clockwise starting at the min corner).
+	 */
+	inline
+	auto transform_rects(const Matrix_2x3& m, const Rect* rects,
+						 Vector2* out_corners, std::size_t count) -> void {
+		const auto& i{ m[0] };
+		const auto& j{ m[1] };
+		const auto& t{ m[2] };
+		for(std::size_t n{0}; n<count; ++n){
+			const auto& r{ rects[n] };
+			const auto ax{ i.getX()*r.getXMin() }, ay{ i.getY()*r.getXMin() };
+			const auto bx{ i.getX()*r.getXMax() }, by{ i.getY()*r.getXMax() };
+			const auto cx{ j.getX()*r.getYMin() + t.getX() };
+			const auto cy{ j.getY()*r.getYMin() + t.getY() };
+			const auto dx{ j.getX()*r.getYMax() + t.getX() };
+			const auto dy{ j.getY()*r.getYMax() + t.getY() };
+
+			auto* corners{ out_corners + 4*n };
+			corners[0].set(ax+cx, ay+cy);
+			corners[1].set(bx+cx, by+cy);
+			corners[2].set(bx+dx, by+dy);
+			corners[3].set(ax+dx, ay+dy);
+		}
+	}
+
+	class Plane3 {
+		Vector3 dir, r1, r2;
+
+	public:
+		inline constexpr
+		Plane3(const Vector3& dir, const Vector3& span1, const Vector3& span2):
+			dir{dir}, r1{span1}, r2{span2} {}
+
+		inline constexpr
+		auto getPosition() const -> const Vector3& {
+			return dir;
+		}
+
+		inline constexpr
+		auto getNormal() const -> const Vector3 {
+			return r1.cross_prod(r2); 
+		}
+
+		inline 
+		auto isParallel(const Plane3& other) -> bool {
+			return this->getNormal().cross_prod(other.getNormal()).equals( {0.f, 0.f, 0.f} );
+		}
+
+		inline
+		auto distance(const Plane3& other) -> float {
+			if(!isParallel(other)) return 0.f;
+			return fabs(this->getNormal().dot_prod(r2-r1))
+				 / this->getNormal().length();
+		}
+	};
+
+	/**
+	 *  Shewchuk's robust predicates for the float vectors. A double filter
+	 *  with a static error bound decides the common case, the exact
+	 *  fallback sums the expanded determinant as a floating point
+	 *  expansion. Products of two floats are exact in double, which keeps
+	 *  the expansions short. orient2d splits its products and stays exact
+	 *  for any double coordinates, as the sweep's crossing points need.
+	 */
+	namespace predicate_detail {
+		static constexpr double epsilon{ 1.1102230246251565e-16 };
+		static constexpr double ccw_bound{ (3. + 16.*epsilon)*epsilon };
+		static constexpr double o3d_bound{ (7. + 56.*epsilon)*epsilon };
+		static constexpr double icc_bound{ (10. + 96.*epsilon)*epsilon };
+		static constexpr double isp_bound{ (16. + 224.*epsilon)*epsilon };
+
+		inline
+		auto fast_two_sum(double a, double b, double& x, double& y) -> void {
+			x = a+b;
+			y = b-(x-a);
+		}
+
+		inline
+		auto two_sum(double a, double b, double& x, double& y) -> void {
+			x = a+b;
+			const auto bv{ x-a };
+			const auto av{ x-bv };
+			y = (a-av) + (b-bv);
+		}
+
+		inline
+		auto two_diff(double a, double b, double& x, double& y) -> void {
+			x = a-b;
+			const auto bv{ a-x };
+			const auto av{ x+bv };
+			y = (a-av) + (bv-b);
+		}
+
+		inline
+		auto two_product(double a, double b, double& x, double& y) -> void {
+			x = a*b;
+#if defined(FP_FAST_FMA)
+			y = std::fma(a, b, -x);
+#else
+			constexpr double splitter{ 134217729. };
+			auto c{ splitter*a };
+			const auto a_hi{ c-(c-a) };
+			const auto a_lo{ a-a_hi };
+			c = splitter*b;
+			const auto b_hi{ c-(c-b) };
+			const auto b_lo{ b-b_hi };
+			y = a_lo*b_lo - (((x - a_hi*b_hi) - a_lo*b_hi) - a_hi*b_lo);
+#endif
+		}
+
+		/**
+		 *  h = e + f with zero elimination, components ordered by magnitude.
+		 */
+		inline
+		auto sum(const double* e, int e_len, const double* f, int f_len, double* h) -> int {
+			int ei{ 0 }, fi{ 0 }, hi{ 0 };
+			auto e_now{ e[0] }, f_now{ f[0] };
+			auto next_e{ [&]{ e_now = ++ei < e_len ? e[ei] : 0.; } };
+			auto next_f{ [&]{ f_now = ++fi < f_len ? f[fi] : 0.; } };
+			double q, q_new, hh;
+			if((f_now > e_now) == (f_now > -e_now)){ q = e_now; next_e(); }
+			else{ q = f_now; next_f(); }
+			if(ei < e_len && fi < f_len){
+				if((f_now > e_now) == (f_now > -e_now)){ fast_two_sum(e_now, q, q_new, hh); next_e(); }
+				else{ fast_two_sum(f_now, q, q_new, hh); next_f(); }
+				q = q_new;
+				if(hh != 0.) h[hi++] = hh;
+				while(ei < e_len && fi < f_len){
+					if((f_now > e_now) == (f_now > -e_now)){ two_sum(q, e_now, q_new, hh); next_e(); }
+					else{ two_sum(q, f_now, q_new, hh); next_f(); }
+					q = q_new;
+					if(hh != 0.) h[hi++] = hh;
+				}
+			}
+			while(ei < e_len){
+				two_sum(q, e_now, q_new, hh); next_e();
+				q = q_new;
+				if(hh != 0.) h[hi++] = hh;
+			}
+			while(fi < f_len){
+				two_sum(q, f_now, q_new, hh); next_f();
+				q = q_new;
+				if(hh != 0.) h[hi++] = hh;
+			}
+			if(q != 0. || hi == 0) h[hi++] = q;
+			return hi;
+		}
+
+		/**
+		 *  h = e*b with zero elimination, h holds up to 2*e_len components.
+		 */
+		inline
+		auto scale(const double* e, int e_len, double b, double* h) -> int {
+			int hi{ 0 };
+			double q, hh, product1, product0, s;
+			two_product(e[0], b, q, hh);
+			if(hh != 0.) h[hi++] = hh;
+			for(int n{1}; n<e_len; ++n){
+				two_product(e[n], b, product1, product0);
+				two_sum(q, product0, s, hh);
+				if(hh != 0.) h[hi++] = hh;
+				fast_two_sum(product1, s, q, hh);
+				if(hh != 0.) h[hi++] = hh;
+			}
+			if(q != 0. || hi == 0) h[hi++] = q;
+			return hi;
+		}
+
+		/**
+		 *  h = e*f for short expansions, h needs 2*e_len*f_len components.
+		 */
+		inline
+		auto multiply(const double* e, int e_len, const double* f, int f_len, double* h) -> int {
+			double part[48], acc[2][144];
+			auto len{ scale(e, e_len, f[0], acc[0]) };
+			int current{ 0 };
+			for(int n{1}; n<f_len; ++n){
+				const auto part_len{ scale(e, e_len, f[n], part) };
+				len = sum(acc[current], len, part, part_len, acc[1-current]);
+				current = 1-current;
+			}
+			for(int n{0}; n<len; ++n) h[n] = acc[current][n];
+			return len;
+		}
+
+		inline
+		auto negate(double* e, int e_len) -> void {
+			for(int n{0}; n<e_len; ++n) e[n] = -e[n];
+		}
+
+		/**
+		 *  px*qy - qx*py, both products are exact.
+		 */
+		inline
+		auto det2(const double* p, const double* q, double* h) -> int {
+			double x, y;
+			two_diff(p[0]*q[1], q[0]*p[1], x, y);
+			if(y == 0.){ h[0] = x; return 1; }
+			h[0] = y; h[1] = x;
+			return 2;
+		}
+
+		/**
+		 *  px*qy - qx*py for any doubles, the products are split with
+		 *  two_product. Up to 4 components.
+		 */
+		inline
+		auto split_det2(const double* p, const double* q, double* h) -> int {
+			double left[2], right[2];
+			two_product(p[0], q[1], left[1], left[0]);
+			two_product(-q[0], p[1], right[1], right[0]);
+			return sum(left, 2, right, 2, h);
+		}
+
+		/**
+		 *  px² + py² (+ pz²).
+		 */
+		inline
+		auto lift(const double* p, int dim, double* h) -> int {
+			double xy[2];
+			int len{ 2 };
+			two_sum(p[0]*p[0], p[1]*p[1], xy[1], xy[0]);
+			if(xy[0] == 0.){ xy[0] = xy[1]; len = 1; }
+			if(dim == 2){
+				for(int n{0}; n<len; ++n) h[n] = xy[n];
+				return len;
+			}
+			const double z{ p[2]*p[2] };
+			return sum(xy, len, &z, 1, h);
+		}
+
+		/**
+		 *  Determinant of the rows (x, y, z) of p, q, r, up to 12 components.
+		 */
+		inline
+		auto det3(const double* p, const double* q, const double* r, double* h) -> int {
+			double m[3][2], t[3][4], s[8];
+			const int m_len[3]{ det2(q, r, m[0]), det2(p, r, m[1]), det2(p, q, m[2]) };
+			const int len[3]{
+				scale(m[0], m_len[0], p[2], t[0]),
+				scale(m[1], m_len[1], -q[2], t[1]),
+				scale(m[2], m_len[2], r[2], t[2])
+			};
+			const auto s_len{ sum(t[0], len[0], t[1], len[1], s) };
+			return sum(s, s_len, t[2], len[2], h);
+		}
+
+		/**
+		 *  Determinant of the rows (x, y, lift) of p, q, r, up to 24 components.
+		 */
+		inline
+		auto lifted_det3(const double* p, const double* q, const double* r, double* h) -> int {
+			double l[3][2], m[3][2], t[3][8], s[16];
+			const int l_len[3]{ lift(p, 2, l[0]), lift(q, 2, l[1]), lift(r, 2, l[2]) };
+			const int m_len[3]{ det2(q, r, m[0]), det2(p, r, m[1]), det2(p, q, m[2]) };
+			int len[3];
+			for(int n{0}; n<3; ++n) len[n] = multiply(m[n], m_len[n], l[n], l_len[n], t[n]);
+			negate(t[1], len[1]);
+			const auto s_len{ sum(t[0], len[0], t[1], len[1], s) };
+			return sum(s, s_len, t[2], len[2], h);
+		}
+
+		/**
+		 *  Determinant of the rows (x, y, z, lift) of p, q, r, s, up to 288
+		 *  components.
+		 */
+		inline
+		auto lifted_det4(const double* p, const double* q, const double* r, const double* s,
+						 double* h) -> int {
+			const double* rows[4]{ p, q, r, s };
+			double l[3], d[12], t[72], acc[2][288];
+			int len{ 0 }, current{ 0 };
+			for(int n{0}; n<4; ++n){
+				const double* others[3];
+				for(int k{0}, o{0}; k<4; ++k) if(k != n) others[o++] = rows[k];
+				const auto l_len{ lift(rows[n], 3, l) };
+				const auto d_len{ det3(others[0], others[1], others[2], d) };
+				const auto t_len{ multiply(d, d_len, l, l_len, t) };
+				if(n%2 == 0) negate(t, t_len);
+				if(n == 0){
+					for(int k{0}; k<t_len; ++k) acc[0][k] = t[k];
+					len = t_len;
+					continue;
+				}
+				len = sum(acc[current], len, t, t_len, acc[1-current]);
+				current = 1-current;
+			}
+			for(int k{0}; k<len; ++k) h[k] = acc[current][k];
+			return len;
+		}
+
+		/**
+		 *  Sums the alternating cofactors det(rows without i) of a
+		 *  homogeneous determinant, the sign of the first term is given.
+		 */
+		template<int Rows, int Capacity, typename Minor>
+		inline
+		auto cofactor_sum(const double* const* rows, bool first_negative, Minor&& minor_of) -> double {
+			double part[Capacity], acc[2][Rows*Capacity];
+			int len{ 0 }, current{ 0 };
+			for(int n{0}; n<Rows; ++n){
+				const double* others[Rows-1];
+				for(int k{0}, o{0}; k<Rows; ++k) if(k != n) others[o++] = rows[k];
+				const auto part_len{ minor_of(others, part) };
+				if((n%2 == 0) == first_negative) negate(part, part_len);
+				if(n == 0){
+					for(int k{0}; k<part_len; ++k) acc[0][k] = part[k];
+					len = part_len;
+					continue;
+				}
+				len = sum(acc[current], len, part, part_len, acc[1-current]);
+				current = 1-current;
+			}
+			return acc[current][len-1];
+		}
+
+		inline
+		auto orient2d_exact(const double* a, const double* b, const double* c) -> double {
+			const double* rows[3]{ a, b, c };
+			return cofactor_sum<3, 4>(rows, false, [](const double* const* o, double* h){
+				return split_det2(o[0], o[1], h);
+			});
+		}
+
+		inline
+		auto orient3d_exact(const double* a, const double* b, const double* c, const double* d) -> double {
+			const double* rows[4]{ a, b, c, d };
+			return cofactor_sum<4, 12>(rows, true, [](const double* const* o, double* h){
+				return det3(o[0], o[1], o[2], h);
+			});
+		}
+
+		inline
+		auto incircle_exact(const double* a, const double* b, const double* c, const double* d) -> double {
+			const double* rows[4]{ a, b, c, d };
+			return cofactor_sum<4, 24>(rows, true, [](const double* const* o, double* h){
+				return lifted_det3(o[0], o[1], o[2], h);
+			});
+		}
+
+		inline
+		auto insphere_exact(const double* a, const double* b, const double* c, const double* d,
+							const double* e) -> double {
+			const double* rows[5]{ a, b, c, d, e };
+			return cofactor_sum<5, 288>(rows, false, [](const double* const* o, double* h){
+				return lifted_det4(o[0], o[1], o[2], o[3], h);
+			});
+		}
+
+		/**
+		 *  orient2d on double coordinates, for points that are not floats
+		 *  such as computed crossings.
+		 */
+		inline
+		auto orient2d(const double* a, const double* b, const double* c) -> double {
+			const double left{ (a[0]-c[0])*(b[1]-c[1]) };
+			const double right{ (a[1]-c[1])*(b[0]-c[0]) };
+			const auto det{ left-right };
+			double det_sum;
+			if(left > 0.){
+				if(right <= 0.) return det;
+				det_sum = left+right;
+			}
+			else if(left < 0.){
+				if(right >= 0.) return det;
+				det_sum = -left-right;
+			}
+			else return det;
+			if(det >= ccw_bound*det_sum || -det >= ccw_bound*det_sum) return det;
+			return orient2d_exact(a, b, c);
+		}
+	}
+
+	/**
+	 *  Positive if a, b, c turn counterclockwise, negative if clockwise and
+	 *  exactly zero if they are collinear.
+	 */
+	inline
+	auto orient2d(const Vector2& a, const Vector2& b, const Vector2& c) -> double {
+		const double pa[2]{ a.getX(), a.getY() }, pb[2]{ b.getX(), b.getY() }, pc[2]{ c.getX(), c.getY() };
+		return predicate_detail::orient2d(pa, pb, pc);
+	}
+
+	/**
+	 *  Positive if d lies below the plane through a, b, c, where they
+	 *  appear counterclockwise seen from above. Zero if coplanar.
+	 */
+	inline
+	auto orient3d(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d) -> double {
+		const double adx{ double(a.getX())-d.getX() }, ady{ double(a.getY())-d.getY() }, adz{ double(a.getZ())-d.getZ() };
+		const double bdx{ double(b.getX())-d.getX() }, bdy{ double(b.getY())-d.getY() }, bdz{ double(b.getZ())-d.getZ() };
+		const double cdx{ double(c.getX())-d.getX() }, cdy{ double(c.getY())-d.getY() }, cdz{ double(c.getZ())-d.getZ() };
+		const auto bdxcdy{ bdx*cdy }, cdxbdy{ cdx*bdy };
+		const auto cdxady{ cdx*ady }, adxcdy{ adx*cdy };
+		const auto adxbdy{ adx*bdy }, bdxady{ bdx*ady };
+		const auto det{ adz*(bdxcdy-cdxbdy) + bdz*(cdxady-adxcdy) + cdz*(adxbdy-bdxady) };
+		const auto permanent{ (std::fabs(bdxcdy)+std::fabs(cdxbdy))*std::fabs(adz)
+							+ (std::fabs(cdxady)+std::fabs(adxcdy))*std::fabs(bdz)
+							+ (std::fabs(adxbdy)+std::fabs(bdxady))*std::fabs(cdz) };
+		const auto bound{ predicate_detail::o3d_bound*permanent };
+		if(det > bound || -det > bound) return det;
+
+		const double pa[3]{ a.getX(), a.getY(), a.getZ() }, pb[3]{ b.getX(), b.getY(), b.getZ() };
+		const double pc[3]{ c.getX(), c.getY(), c.getZ() }, pd[3]{ d.getX(), d.getY(), d.getZ() };
+		return predicate_detail::orient3d_exact(pa, pb, pc, pd);
+	}
+
+	/**
+	 *  Positive if d lies inside the circle through a, b, c (counterclockwise),
+	 *  negative outside and zero on it.
+	 */
+	inline
+	auto incircle(const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d) -> double {
+		const double adx{ double(a.getX())-d.getX() }, ady{ double(a.getY())-d.getY() };
+		const double bdx{ double(b.getX())-d.getX() }, bdy{ double(b.getY())-d.getY() };
+		const double cdx{ double(c.getX())-d.getX() }, cdy{ double(c.getY())-d.getY() };
+		const auto bdxcdy{ bdx*cdy }, cdxbdy{ cdx*bdy }, a_lift{ adx*adx + ady*ady };
+		const auto cdxady{ cdx*ady }, adxcdy{ adx*cdy }, b_lift{ bdx*bdx + bdy*bdy };
+		const auto adxbdy{ adx*bdy }, bdxady{ bdx*ady }, c_lift{ cdx*cdx + cdy*cdy };
+		const auto det{ a_lift*(bdxcdy-cdxbdy) + b_lift*(cdxady-adxcdy) + c_lift*(adxbdy-bdxady) };
+		const auto permanent{ (std::fabs(bdxcdy)+std::fabs(cdxbdy))*a_lift
+							+ (std::fabs(cdxady)+std::fabs(adxcdy))*b_lift
+							+ (std::fabs(adxbdy)+std::fabs(bdxady))*c_lift };
+		const auto bound{ predicate_detail::icc_bound*permanent };
+		if(det > bound || -det > bound) return det;
+
+		// nearby points, as on grids, have float sized offsets whose products are exact
+		const auto narrow{ [](double v){ return double(float(v)) == v; } };
+		if(narrow(adx) && narrow(ady) && narrow(bdx) && narrow(bdy) && narrow(cdx) && narrow(cdy)){
+			const double ad[2]{ adx, ady }, bd[2]{ bdx, bdy }, cd[2]{ cdx, cdy };
+			double h[24];
+			return h[predicate_detail::lifted_det3(ad, bd, cd, h)-1];
+		}
+
+		const double pa[2]{ a.getX(), a.getY() }, pb[2]{ b.getX(), b.getY() };
+		const double pc[2]{ c.getX(), c.getY() }, pd[2]{ d.getX(), d.getY() };
+		return predicate_detail::incircle_exact(pa, pb, pc, pd);
+	}
+
+	/**
+	 *  Positive if e lies inside the sphere through a, b, c, d, which must
+	 *  have orient3d(a, b, c, d) > 0. Zero if cospherical.
+	 */
+	inline
+	auto insphere(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d,
+				  const Vector3& e) -> double {
+		const double aex{ double(a.getX())-e.getX() }, aey{ double(a.getY())-e.getY() }, aez{ double(a.getZ())-e.getZ() };
+		const double bex{ double(b.getX())-e.getX() }, bey{ double(b.getY())-e.getY() }, bez{ double(b.getZ())-e.getZ() };
+		const double cex{ double(c.getX())-e.getX() }, cey{ double(c.getY())-e.getY() }, cez{ double(c.getZ())-e.getZ() };
+		const double dex{ double(d.getX())-e.getX() }, dey{ double(d.getY())-e.getY() }, dez{ double(d.getZ())-e.getZ() };
+
+		const auto aexbey{ aex*bey }, bexaey{ bex*aey };
+		const auto bexcey{ bex*cey }, cexbey{ cex*bey };
+		const auto cexdey{ cex*dey }, dexcey{ dex*cey };
+		const auto dexaey{ dex*aey }, aexdey{ aex*dey };
+		const auto aexcey{ aex*cey }, cexaey{ cex*aey };
+		const auto bexdey{ bex*dey }, dexbey{ dex*bey };
+		const auto ab{ aexbey-bexaey }, bc{ bexcey-cexbey }, cd{ cexdey-dexcey };
+		const auto da{ dexaey-aexdey }, ac{ aexcey-cexaey }, bd{ bexdey-dexbey };
+
+		const auto abc{ aez*bc - bez*ac + cez*ab };
+		const auto bcd{ bez*cd - cez*bd + dez*bc };
+		const auto cda{ cez*da + dez*ac + aez*cd };
+		const auto dab{ dez*ab + aez*bd + bez*da };
+		const auto a_lift{ aex*aex + aey*aey + aez*aez };
+		const auto b_lift{ bex*bex + bey*bey + bez*bez };
+		const auto c_lift{ cex*cex + cey*cey + cez*cez };
+		const auto d_lift{ dex*dex + dey*dey + dez*dez };
+		const auto det{ (d_lift*abc - c_lift*dab) + (b_lift*cda - a_lift*bcd) };
+
+		const auto p{ [](double v){ return std::fabs(v); } };
+		const auto permanent{
+			((p(cexdey)+p(dexcey))*p(bez) + (p(dexbey)+p(bexdey))*p(cez) + (p(bexcey)+p(cexbey))*p(dez))*a_lift
+		  + ((p(dexaey)+p(aexdey))*p(cez) + (p(aexcey)+p(cexaey))*p(dez) + (p(cexdey)+p(dexcey))*p(aez))*b_lift
+		  + ((p(aexbey)+p(bexaey))*p(dez) + (p(bexdey)+p(dexbey))*p(aez) + (p(dexaey)+p(aexdey))*p(bez))*c_lift
+		  + ((p(bexcey)+p(cexbey))*p(aez) + (p(cexaey)+p(aexcey))*p(bez) + (p(aexbey)+p(bexaey))*p(cez))*d_lift };
+		const auto bound{ predicate_detail::isp_bound*permanent };
+		if(det > bound || -det > bound) return det;
+
+		const double pa[3]{ a.getX(), a.getY(), a.getZ() }, pb[3]{ b.getX(), b.getY(), b.getZ() };
+		const double pc[3]{ c.getX(), c.getY(), c.getZ() }, pd[3]{ d.getX(), d.getY(), d.getZ() };
+		const double pe[3]{ e.getX(), e.getY(), e.getZ() };
+		return predicate_detail::insphere_exact(pa, pb, pc, pd, pe);
+	}
+
+	namespace segment_detail {
+		inline
+		auto sign(double v) -> int {
+			return (v > 0.) - (v < 0.);
+		}
+
+		/**
+		 *  p is known to be collinear with a-b, checks it lies within.
+		 */
+		inline
+		auto within(const Vector2& a, const Vector2& b, const Vector2& p) -> bool {
+			return std::min(a.getX(), b.getX()) <= p.getX() && p.getX() <= std::max(a.getX(), b.getX())
+				&& std::min(a.getY(), b.getY()) <= p.getY() && p.getY() <= std::max(a.getY(), b.getY());
+		}
+	}
+
+	class Line2 {
+		Vector2 a, b;
+	public:
+		inline constexpr
+		Line2(const Vector2& from, const Vector2& to)
+		:a{from}, b{to} {}
+
+		inline constexpr
+		Line2(Vector2&& from, Vector2&& to)
+		:a{from}, b{to} {}
+
+		inline constexpr
+		auto getFrom() const -> const Vector2& {
+			return a;
+		}
+
+		inline constexpr
+		auto getTo() const -> const Vector2 {
+			return b;
+		}
+
+		/**
+		 *  Liang–Barsky, the part of the segment inside the rectangle spans
+		 *  the fractions [enter, exit]. False if the segment misses it.
+		 */
+		inline
+		auto clip_fractions(const Rect& rectangle, float& enter, float& exit) const -> bool {
+			if(rectangle.isEmpty()) return false;
+			const float lower[2]{ rectangle.getXMin(), rectangle.getYMin() };
+			const float upper[2]{ rectangle.getXMax(), rectangle.getYMax() };
+			enter = 0.f;
+			exit = 1.f;
+			for(int axis{0}; axis<2; ++axis){
+				const auto d{ b[axis]-a[axis] };
+				if(d == 0.f){
+					if(a[axis] < lower[axis] || a[axis] > upper[axis]) return false;
+					continue;
+				}
+				const auto inv{ 1.f/d };
+				const auto t0{ (lower[axis]-a[axis])*inv };
+				const auto t1{ (upper[axis]-a[axis])*inv };
+				enter = std::max(enter, std::min(t0, t1));
+				exit  = std::min(exit,  std::max(t0, t1));
+			}
+			return enter <= exit;
+		}
+
+		/**
+		 *  Entry fraction into the rectangle, 0 if the segment starts inside
+		 *  and inf if it misses.
+		 */
+		inline
+		auto intersect_fraction(const Rect& rectangle) const -> float {
+			float enter, exit;
+			return clip_fractions(rectangle, enter, exit) ? enter : inf;
+		}
+
+		/**
+		 *  The part of the segment inside the rectangle, false if there is
+		 *  none and out is left untouched.
+		 */
+		inline
+		auto clip(const Rect& rectangle, Line2& out) const -> bool {
+			float enter, exit;
+			if(!clip_fractions(rectangle, enter, exit)) return false;
+			const auto d{ b-a };
+			out = Line2(enter > 0.f ? a+enter*d : a, exit < 1.f ? a+exit*d : b);
+			return true;
+		}
+
+		inline constexpr
+		auto asVec2() const -> Vector2 {
+			return (b-a);
+		}
+
+		/**
+		 *  Closed segment test, touching endpoints and collinear overlaps
+		 *  count as intersections.
+		 */
+		inline
+		auto intersects(const Line2& other) const -> bool {
+			using namespace segment_detail;
+			const auto& c{ other.a };
+			const auto& d{ other.b };
+			const auto o1{ sign(orient2d(a, b, c)) }, o2{ sign(orient2d(a, b, d)) };
+			const auto o3{ sign(orient2d(c, d, a)) }, o4{ sign(orient2d(c, d, b)) };
+			if(o1*o2 < 0 && o3*o4 < 0) return true;
+			return (!o1 && within(a, b, c)) || (!o2 && within(a, b, d))
+				|| (!o3 && within(c, d, a)) || (!o4 && within(c, d, b));
+		}
+
+		/**
+		 *  Fraction along this segment of the first point shared with other,
+		 *  inf if they are disjoint.
+		 */
+		inline
+		auto intersect_fraction(const Line2& other) const -> float {
+			if(!intersects(other)) return inf;
+			const auto dx{ double(b.getX())-a.getX() }, dy{ double(b.getY())-a.getY() };
+			const auto ex{ double(other.b.getX())-other.a.getX() }, ey{ double(other.b.getY())-other.a.getY() };
+			const auto rx{ double(other.a.getX())-a.getX() }, ry{ double(other.a.getY())-a.getY() };
+			const auto denom{ dx*ey - dy*ex };
+			const auto dd{ dx*dx + dy*dy };
+			if(dd == 0.) return 0.f;
+
+			if(denom != 0.){
+				const auto t{ (rx*ey - ry*ex)/denom };
+				return static_cast<float>(std::min(std::max(t, 0.), 1.));
+			}
+			// collinear overlap, start of the shared part
+			const auto t0{ (rx*dx + ry*dy)/dd };
+			const auto t1{ ((double(other.b.getX())-a.getX())*dx + (double(other.b.getY())-a.getY())*dy)/dd };
+			return static_cast<float>(std::min(std::max(std::min(t0, t1), 0.), 1.));
+		}
+
+		inline
+		auto intersect_point(const Line2& other) const -> Vector2 {
+			return a+intersect_fraction(other)*asVec2();
+		}
+
+		inline constexpr
+		auto intersect_point(const Rect& rectangle) const -> Vector2 {
+			return a+intersect_fraction(rectangle)*asVec2();
+		}
+		
+		inline
+		auto disctance_to(const Vector2& point) const -> float {
+			return point.subtract(a.add(a.to(point).project(asVec2()))).length();	
+		}
+	};
+
+	class Line3 {
+		Vector3 a, b;
+	public:
+		inline constexpr
+		Line3(const Vector3& from, const Vector3& to)
+		:a{from}, b{to} {}
+
+		inline constexpr
+		Line3(Vector3&& from, Vector3&& to)
+		:a{from}, b{to} {}
+
+		inline constexpr
+		auto getFrom() const -> const Vector3& {
+			return a;
+		}
+
+		inline constexpr
+		auto getTo() const -> const Vector3 {
+			return b;
+		}
+
+		inline constexpr
+		auto getDir() const -> const Vector3 {
+			return (b-a);
+		}
+
+		inline constexpr
+		auto asVec3() const -> Vector3 {
+			return this->getDir();
+		}
+
+		/**
+		 *  Möller–Trumbore test against the triangle v0, v1, v2 (either side).
+		 *  Returns the fraction along the segment, or inf if it misses.
+		 */
+		inline
+		auto intersect_fraction(const Vector3& v0, const Vector3& v1, const Vector3& v2) const
+		-> float {
+			const auto d{ getDir() };
+			const auto e1{ v1-v0 };
+			const auto e2{ v2-v0 };
+			const auto p{ d.cross_prod(e2) };
+			const auto det{ e1.dot_prod(p) };
+			// det scales with the segment and triangle, only exactly parallel is skipped
+			if(det == 0.f) return inf;
+
+			const auto inv{ 1.f/det };
+			const auto s{ a-v0 };
+			const auto u{ s.dot_prod(p)*inv };
+			if(u < 0.f || u > 1.f) return inf;
+			const auto q{ s.cross_prod(e1) };
+			const auto v{ d.dot_prod(q)*inv };
+			if(v < 0.f || u+v > 1.f) return inf;
+			const auto t{ e2.dot_prod(q)*inv };
+			return t >= 0.f && t <= 1.f ? t : inf;
+		}
+
+		inline
+		auto intersect_point(const Vector3& v0, const Vector3& v1, const Vector3& v2) const
+		-> Vector3 {
+			return a + getDir()*intersect_fraction(v0, v1, v2);
+		}
+
+		/**
+		 *  Entry fraction into the box, 0 if the segment starts inside and
+		 *  inf if it misses.
+		 */
+		inline
+		auto intersect_fraction(const AABB3& box) const -> float {
+			const auto d{ getDir() };
+			auto t_enter{ 0.f };
+			auto t_exit{ 1.f };
+			for(int axis{0}; axis<3; ++axis){
+				if(d[axis] == 0.f){
+					if(a[axis] < box.getMin(axis) || a[axis] > box.getMax(axis)) return inf;
+					continue;
+				}
+				const auto inv{ 1.f/d[axis] };
+				const auto t0{ (box.getMin(axis)-a[axis])*inv };
+				const auto t1{ (box.getMax(axis)-a[axis])*inv };
+				t_enter = std::max(t_enter, std::min(t0, t1));
+				t_exit  = std::min(t_exit,  std::max(t0, t1));
+			}
+			return t_enter <= t_exit ? t_enter : inf;
+		}
+
+		/**
+		 *  Fraction of the point on the segment closest to p, in [0, 1].
+		 */
+		inline
+		auto closest_fraction(const Vector3& p) const -> float {
+			const auto d{ getDir() };
+			const auto dd{ d.dot_prod(d) };
+			if(dd <= 0.f) return 0.f;
+			return std::min(std::max((p-a).dot_prod(d)/dd, 0.f), 1.f);
+		}
+
+		inline
+		auto closest_point(const Vector3& p) const -> Vector3 {
+			return a + getDir()*closest_fraction(p);
+		}
+
+		inline
+		auto squared_distance(const Vector3& p) const -> float {
+			return (closest_point(p)-p).squared_length();
+		}
+
+		/**
+		 *  Closest points of two segments (Ericson, RTCD 5.1.9), s and t are
+		 *  their fractions along this and other. Returns the squared distance.
+		 */
+		inline
+		auto closest_points(const Line3& other, float& s, float& t) const -> float {
+			constexpr auto eps{ std::numeric_limits<float>::epsilon() };
+			auto clamp01{ [](float v){ return std::min(std::max(v, 0.f), 1.f); } };
+			const auto d1{ getDir() };
+			const auto d2{ other.getDir() };
+			const auto r{ a-other.a };
+			const auto sq1{ d1.dot_prod(d1) };
+			const auto sq2{ d2.dot_prod(d2) };
+			const auto f{ d2.dot_prod(r) };
+
+			if(sq1 <= eps && sq2 <= eps){ s = 0.f; t = 0.f; }
+			else if(sq1 <= eps){ s = 0.f; t = clamp01(f/sq2); }
+			else{
+				const auto c{ d1.dot_prod(r) };
+				if(sq2 <= eps){ t = 0.f; s = clamp01(-c/sq1); }
+				else{
+					const auto b{ d1.dot_prod(d2) };
+					const auto denom{ sq1*sq2 - b*b };
+					s = denom > 0.f ? clamp01((b*f - c*sq2)/denom) : 0.f;
+					t = (b*s + f)/sq2;
+					if(t < 0.f){ t = 0.f; s = clamp01(-c/sq1); }
+					else if(t > 1.f){ t = 1.f; s = clamp01((b-c)/sq1); }
+				}
+			}
+			return ((a + d1*s) - (other.a + d2*t)).squared_length();
+		}
+
+		inline
+		auto squared_distance(const Line3& other) const -> float {
+			float s, t;
+			return closest_points(other, s, t);
+		}
+	};
+
+	inline 
+    auto lerp(const float& goal, const float& current, const float& step)-> float {
+    	auto dif{ goal - current };
+    	if(dif > step) [[likely]] return current+step;
+    	if(dif < -step) return current-step;
+    	else [[unlikely]] return goal;
+    }
+
+    inline
+    auto lerp(const Vector2& goal, const Vector2& current, const float& step)-> Vector2 {
+		auto fwd{ goal-current };
+		fwd._normalize()._scale(step);
+		return current.add(fwd);
+    }
+
+    inline 
+    auto lerp(const Vector3& goal, const Vector3& current, const float& step)-> Vector3 {
+		auto fwd{ goal-current };
+		fwd._normalize()._scale(step);
+		return current.add(fwd); 
+    }
+
+	/**
+	 *  Quadratic Bezier in Bernstein form. Point is float, Vector2 or Vector3.
+	 */
+	template<typename Point>
+	inline
+	auto quadratic_bezier(const Point& p0, const Point& p1, const Point& p2, float t) -> Point {
+		const auto u{ 1.f-t };
+		return p0*(u*u) + p1*(2.f*u*t) + p2*(t*t);
+	}
+
+	template<typename Point>
+	inline
+	auto quadratic_bezier_derivative(const Point& p0, const Point& p1, const Point& p2, float t) -> Point {
+		return (p1-p0)*(2.f*(1.f-t)) + (p2-p1)*(2.f*t);
+	}
+
+	template<typename Point>
+	inline
+	auto cubic_bezier(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float t) -> Point {
+		const auto u{ 1.f-t };
+		return p0*(u*u*u) + p1*(3.f*u*u*t) + p2*(3.f*u*t*t) + p3*(t*t*t);
+	}
+
+	template<typename Point>
+	inline
+	auto cubic_bezier_derivative(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float t) -> Point {
+		const auto u{ 1.f-t };
+		return (p1-p0)*(3.f*u*u) + (p2-p1)*(6.f*u*t) + (p3-p2)*(3.f*t*t);
+	}
+
+	template<typename Point>
+	inline
+	auto cubic_bezier_second_derivative(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float t) -> Point {
+		return (p2-p1*2.f+p0)*(6.f*(1.f-t)) + (p3-p2*2.f+p1)*(6.f*t);
+	}
+
+	/**
+	 *  Cubic Hermite segment from p0 to p1 with tangents m0 and m1.
+	 */
+	template<typename Point>
+	inline
+	auto hermite(const Point& p0, const Point& m0, const Point& p1, const Point& m1, float t) -> Point {
+		const auto t2{ t*t }, t3{ t2*t };
+		return p0*(2.f*t3-3.f*t2+1.f) + m0*(t3-2.f*t2+t) + p1*(3.f*t2-2.f*t3) + m1*(t3-t2);
+	}
+
+	template<typename Point>
+	inline
+	auto hermite_derivative(const Point& p0, const Point& m0, const Point& p1, const Point& m1, float t) -> Point {
+		const auto t2{ t*t };
+		return (p0-p1)*(6.f*t2-6.f*t) + m0*(3.f*t2-4.f*t+1.f) + m1*(3.f*t2-2.f*t);
+	}
+
+	/**
+	 *  Uniform Catmull-Rom segment between p1 and p2.
+	 */
+	template<typename Point>
+	inline
+	auto catmull_rom(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float t) -> Point {
+		return hermite(p1, (p2-p0)*.5f, p2, (p3-p1)*.5f, t);
+	}
+
+	template<typename Point>
+	inline
+	auto catmull_rom_derivative(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float t) -> Point {
+		return hermite_derivative(p1, (p2-p0)*.5f, p2, (p3-p1)*.5f, t);
+	}
+
+	/**
+	 *  Bezier control points tracing the same cubic, so Hermite and
+	 *  Catmull-Rom segments can go through the batched evaluators.
+	 */
+	template<typename Point>
+	inline
+	auto hermite_to_bezier(const Point& p0, const Point& m0, const Point& p1, const Point& m1, Point* control) -> void {
+		control[0] = p0;
+		control[1] = p0 + m0*(1.f/3.f);
+		control[2] = p1 - m1*(1.f/3.f);
+		control[3] = p1;
+	}
+
+	template<typename Point>
+	inline
+	auto catmull_rom_to_bezier(const Point& p0, const Point& p1, const Point& p2, const Point& p3, Point* control) -> void {
+		hermite_to_bezier(p1, (p2-p0)*.5f, p2, (p3-p1)*.5f, control);
+	}
+
+	namespace curve_detail {
+		/**
+		 *  Horner evaluation of up to 32 cubics in power basis, one per lane.
+		 *  coeff[k][a] holds the t^k coefficient of axis a.
+		 */
+		template<int Dim>
+		inline
+		auto cubic_lanes(const float (&coeff)[4][Dim][32], const float* t, std::size_t lanes,
+						 float (&position)[Dim][32], float (&tangent)[Dim][32]) -> void {
+			for(int a{0}; a<Dim; ++a)
+				for(std::size_t l{0}; l<lanes; ++l){
+					const auto s{ t[l] };
+					position[a][l] = ((coeff[3][a][l]*s + coeff[2][a][l])*s + coeff[1][a][l])*s + coeff[0][a][l];
+					tangent[a][l] = (3.f*coeff[3][a][l]*s + 2.f*coeff[2][a][l])*s + coeff[1][a][l];
+				}
+		}
+
+		template<int Dim, typename Point>
+		inline
+		auto power_basis(const Point* control, float (&coeff)[4][Dim][32], std::size_t l) -> void {
+			for(int a{0}; a<Dim; ++a){
+				const auto p0{ control[0][a] }, p1{ control[1][a] }, p2{ control[2][a] }, p3{ control[3][a] };
+				coeff[0][a][l] = p0;
+				coeff[1][a][l] = 3.f*(p1-p0);
+				coeff[2][a][l] = 3.f*(p0-2.f*p1+p2);
+				coeff[3][a][l] = p3-p0+3.f*(p1-p2);
+			}
+		}
+
+		/**
+		 *  Shared driver, control(n) gives the four control points of the
+		 *  curve evaluated at t[n]. With Single every n is the same curve
+		 *  and its coefficients are filled in once per chunk.
+		 */
+		template<int Dim, bool Single, typename Point, typename Control>
+		inline
+		auto cubic_batch(Control control, const float* t, std::size_t count, Point* out, Point* tangents,
+						 unsigned thread_count) -> void {
+			parallel_for((count+31)/32, 64, [&](std::size_t begin, std::size_t end, std::size_t){
+				float coeff[4][Dim][32], position[Dim][32], tangent[Dim][32];
+				if(Single)
+					for(std::size_t l{0}; l<32; ++l) power_basis<Dim>(control(0), coeff, l);
+				for(auto word{begin}; word<end; ++word){
+					const auto base{ word*32 };
+					const auto lanes{ std::min<std::size_t>(32, count-base) };
+					if(!Single)
+						for(std::size_t l{0}; l<lanes; ++l) power_basis<Dim>(control(base+l), coeff, l);
+					cubic_lanes<Dim>(coeff, t+base, lanes, position, tangent);
+					for(std::size_t l{0}; l<lanes; ++l)
+						for(int a{0}; a<Dim; ++a){
+							out[base+l][a] = position[a][l];
+							if(tangents) tangents[base+l][a] = tangent[a][l];
+						}
+				}
+			}, thread_count);
+		}
+	}
+
+	/**
+	 *  Evaluates count cubic Beziers, curve n has control points
+	 *  control[4n..4n+3] and is evaluated at t[n]. tangents may be null.
+	 */
+	inline
+	auto cubic_bezier_batch(const Vector2* control, const float* t, std::size_t count, Vector2* out,
+							Vector2* tangents=nullptr, unsigned thread_count=0) -> void {
+		curve_detail::cubic_batch<2, false>([control](std::size_t n){ return control+4*n; },
+									 t, count, out, tangents, thread_count);
+	}
+
+	inline
+	auto cubic_bezier_batch(const Vector3* control, const float* t, std::size_t count, Vector3* out,
+							Vector3* tangents=nullptr, unsigned thread_count=0) -> void {
+		curve_detail::cubic_batch<3, false>([control](std::size_t n){ return control+4*n; },
+									 t, count, out, tangents, thread_count);
+	}
+
+	/**
+	 *  One curve at count parameters.
+	 */
+	inline
+	auto cubic_bezier_batch(const Vector2& p0, const Vector2& p1, const Vector2& p2, const Vector2& p3,
+							const float* t, std::size_t count, Vector2* out, Vector2* tangents=nullptr,
+							unsigned thread_count=0) -> void {
+		const Vector2 control[4]{ p0, p1, p2, p3 };
+		curve_detail::cubic_batch<2, true>([&control](std::size_t){ return control; },
+									 t, count, out, tangents, thread_count);
+	}
+
+	inline
+	auto cubic_bezier_batch(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3,
+							const float* t, std::size_t count, Vector3* out, Vector3* tangents=nullptr,
+							unsigned thread_count=0) -> void {
+		const Vector3 control[4]{ p0, p1, p2, p3 };
+		curve_detail::cubic_batch<3, true>([&control](std::size_t){ return control; },
+									 t, count, out, tangents, thread_count);
+	}
+
+	/**
+	 *  Arc length of a curve sampled at segments uniform parameter steps,
+	 *  each step integrated with 5-point Gauss-Legendre. Lookups between
+	 *  the samples use cubic Hermite interpolation with the stored speeds
+	 *  as slopes, so a few dozen steps are enough for typical paths. The
+	 *  curve constructors take Vector2 or Vector3 control points, the
+	 *  generic one any callable returning |dB/dt| at t. Tables round trip
+	 *  through operator<< and operator>> so they can be baked offline.
+	 */
+	class Arc_Length_Table {
+		std::vector<float> lengths;
+		std::vector<float> speeds;
+
+		template<typename Speed>
+		inline
+		auto build(Speed speed, std::size_t segments) -> void {
+			static constexpr double node[5]{
+				0., -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640
+			};
+			static constexpr double weight[5]{
+				0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891
+			};
+			segments = std::max<std::size_t>(segments, 1);
+			const auto step{ 1./segments };
+			lengths.resize(segments+1);
+			speeds.resize(segments+1);
+			lengths[0] = 0.f;
+			auto total{ 0. };
+			for(std::size_t k{0}; k<segments; ++k){
+				auto sum{ 0. };
+				for(int n{0}; n<5; ++n)
+					sum += weight[n]*speed(static_cast<float>((k + (1.+node[n])*.5)*step));
+				total += sum*step*.5;
+				lengths[k+1] = static_cast<float>(total);
+			}
+			for(std::size_t k{0}; k<=segments; ++k) speeds[k] = speed(static_cast<float>(k*step));
+		}
+
+		/**
+		 *  Moves the cursor to the segment holding distance, stepping a few
+		 *  segments from where it was before falling back to a binary search.
+		 */
+		inline
+		auto locate(float distance, std::uint32_t& segment) const -> void {
+			const auto last{ static_cast<std::uint32_t>(lengths.size()-2) };
+			segment = std::min(segment, last);
+			for(int n{0}; n<4; ++n){
+				if(distance < lengths[segment] && segment > 0) --segment;
+				else if(distance > lengths[segment+1] && segment < last) ++segment;
+				else return;
+			}
+			const auto it{ std::upper_bound(lengths.begin()+1, lengths.end()-1, distance) };
+			segment = static_cast<std::uint32_t>(it - lengths.begin() - 1);
+		}
+
+	public:
+		/**
+		 *  Remembers the segment of the last lookup, lookups that move a
+		 *  little each time cost O(1).
+		 */
+		struct Cursor {
+			std::uint32_t segment{ 0 };
+		};
+
+		Arc_Length_Table() = default;
+
+		template<typename Speed>
+		inline
+		Arc_Length_Table(Speed speed, std::size_t segments){
+			build(speed, segments);
+		}
+
+		template<typename Point>
+		inline
+		Arc_Length_Table(const Point& p0, const Point& p1, const Point& p2, std::size_t segments=32){
+			build([&](float t){ return quadratic_bezier_derivative(p0, p1, p2, t).length(); }, segments);
+		}
+
+		template<typename Point>
+		inline
+		Arc_Length_Table(const Point& p0, const Point& p1, const Point& p2, const Point& p3, std::size_t segments=32){
+			build([&](float t){ return cubic_bezier_derivative(p0, p1, p2, p3, t).length(); }, segments);
+		}
+
+		inline
+		auto getSegments() const -> std::size_t {
+			return lengths.empty() ? 0 : lengths.size()-1;
+		}
+
+		inline
+		auto length() const -> float {
+			return lengths.empty() ? 0.f : lengths.back();
+		}
+
+		/**
+		 *  Arc length from the start of the curve to parameter t.
+		 */
+		inline
+		auto distance(float t) const -> float {
+			if(lengths.empty()) return 0.f;
+			const auto segments{ lengths.size()-1 };
+			const auto scaled{ std::min(std::max(t, 0.f), 1.f)*segments };
+			const auto k{ std::min(static_cast<std::size_t>(scaled), segments-1) };
+			const auto u{ scaled-k };
+			const auto step{ 1.f/segments };
+			const auto u2{ u*u }, u3{ u2*u };
+			return lengths[k]*(2.f*u3-3.f*u2+1.f) + speeds[k]*step*(u3-2.f*u2+u)
+				 + lengths[k+1]*(3.f*u2-2.f*u3) + speeds[k+1]*step*(u3-u2);
+		}
+
+		/**
+		 *  Parameter at arc length distance, clamped to the curve. The
+		 *  interpolant slopes are limited so t stays monotone across cusps.
+		 */
+		inline
+		auto parameter(float distance, Cursor& cursor) const -> float {
+			if(lengths.empty()) return 0.f;
+			distance = std::min(std::max(distance, 0.f), lengths.back());
+			locate(distance, cursor.segment);
+			const auto k{ cursor.segment };
+			const auto segments{ lengths.size()-1 };
+			const auto step{ 1.f/segments };
+			const auto span{ lengths[k+1]-lengths[k] };
+			if(span <= 0.f) return k*step;
+			auto slope{ [&](float speed){
+				return speed*step*3.f > span ? span/(speed*step) : 3.f;
+			}};
+			const auto v{ (distance-lengths[k])/span };
+			const auto v2{ v*v }, v3{ v2*v };
+			const auto h{ (3.f*v2-2.f*v3) + slope(speeds[k])*(v3-2.f*v2+v) + slope(speeds[k+1])*(v3-v2) };
+			return (k+h)*step;
+		}
+
+		inline
+		auto parameter(float distance) const -> float {
+			Cursor cursor{ 0xffffffffu };
+			return parameter(distance, cursor);
+		}
+
+		/**
+		 *  parameter for many distances, every chunk walks its own cursor so
+		 *  sorted input costs O(1) per query.
+		 */
+		inline
+		auto parameters(const float* distances, std::size_t count, float* out, unsigned thread_count=0) const -> void {
+			parallel_for(count, 4096, [&](std::size_t begin, std::size_t end, std::size_t){
+				Cursor cursor{ 0xffffffffu };
+				for(auto n{begin}; n<end; ++n) out[n] = parameter(distances[n], cursor);
+			}, thread_count);
+		}
+
+		friend inline
+		auto operator<<(std::ostream& out, const Arc_Length_Table& table)
+		-> std::ostream&;
+
+		friend inline
+		auto operator>>(std::istream& in, Arc_Length_Table& table)
+		-> std::istream&;
+	};
+
+	/**
+	 *  Segment count, then the cumulative lengths and the speeds, written
+	 *  with enough digits to read back the same floats.
+	 */
+	inline
+	auto operator<<(std::ostream& out, const Arc_Length_Table& table)
+	-> std::ostream& {
+		const auto precision{ out.precision(std::numeric_limits<float>::max_digits10) };
+		out << table.getSegments();
+		for(auto l : table.lengths) out << ' ' << l;
+		for(auto s : table.speeds) out << ' ' << s;
+		out.precision(precision);
+		return out;
+	}
+
+	inline
+	auto operator>>(std::istream& in, Arc_Length_Table& table)
+	-> std::istream& {
+		// unsigned extraction wraps a leading minus instead of failing
+		std::size_t segments;
+		if(!(in >> std::ws) || in.peek() == '-' || !(in >> segments) || !segments
+		|| segments >= std::vector<float>().max_size()){
+			in.setstate(std::ios::failbit);
+			return in;
+		}
+		// grow with what is actually read, the count alone is not trusted
+		std::vector<float> lengths, speeds;
+		auto read{ [&](std::vector<float>& values){
+			values.reserve(std::min<std::size_t>(segments+1, 4096));
+			float value;
+			while(values.size() <= segments && in >> value) values.push_back(value);
+		}};
+		read(lengths);
+		read(speeds);
+		if(in){
+			table.lengths = std::move(lengths);
+			table.speeds = std::move(speeds);
+		}
+		return in;
+	}
+
+	namespace flatten_detail {
+		constexpr int max_depth{ 16 };
+
+		/**
+		 *  Squared bound on how far a Bezier strays from its chord, from
+		 *  the largest second difference of its control points (Wang).
+		 */
+		template<typename Point>
+		inline
+		auto deviation(const Point (&p)[3]) -> float {
+			return (p[0] - p[1]*2.f + p[2]).squared_length()*(1.f/16.f);
+		}
+
+		template<typename Point>
+		inline
+		auto deviation(const Point (&p)[4]) -> float {
+			return std::max((p[0] - p[1]*2.f + p[2]).squared_length(),
+							(p[1] - p[2]*2.f + p[3]).squared_length())*(9.f/16.f);
+		}
+
+		/**
+		 *  Squared distance of the farthest inner control point from the
+		 *  chord. The curve stays inside its control hull, so this bounds
+		 *  the gap to the polyline even where the parametrisation is uneven.
+		 */
+		template<int Degree, typename Point>
+		inline
+		auto chord_deviation(const Point (&p)[Degree+1]) -> float {
+			const auto chord{ p[Degree]-p[0] };
+			const auto squared_chord{ chord.squared_length() };
+			auto farthest{ 0.f };
+			for(int i{1}; i<Degree; ++i){
+				const auto offset{ p[i]-p[0] };
+				const auto along{ squared_chord > 0.f
+					? std::min(std::max(offset.dot_prod(chord)/squared_chord, 0.f), 1.f) : 0.f };
+				farthest = std::max(farthest, (offset - chord*along).squared_length());
+			}
+			return farthest;
+		}
+
+		/**
+		 *  Halving a curve quarters its second differences, so this many
+		 *  halvings make every piece flat.
+		 */
+		inline
+		auto depth(float squared_deviation, float tolerance) -> int {
+			const auto limit{ tolerance*tolerance };
+			int d{ 0 };
+			for(; squared_deviation > limit && d < max_depth; ++d) squared_deviation *= 1.f/16.f;
+			return d;
+		}
+
+		template<int Degree, typename Point>
+		inline
+		auto split(const Point (&p)[Degree+1], Point (&left)[Degree+1], Point (&right)[Degree+1]) -> void {
+			Point mid[Degree+1];
+			for(int i{0}; i<=Degree; ++i) mid[i] = p[i];
+			left[0] = p[0];
+			right[Degree] = p[Degree];
+			for(int r{1}; r<=Degree; ++r){
+				for(int i{0}; i<=Degree-r; ++i) mid[i] = (mid[i]+mid[i+1])*.5f;
+				left[r] = mid[0];
+				right[Degree-r] = mid[Degree-r];
+			}
+		}
+
+		/**
+		 *  Depth first de Casteljau halving until each piece is within
+		 *  tolerance of its chord, never deeper than the uniform depth that
+		 *  the second difference bound guarantees.
+		 */
+		template<int Degree, typename Point, typename Line>
+		inline
+		auto subdivide(const Point (&control)[Degree+1], float tolerance, Line* out) -> std::size_t {
+			struct Piece {
+				Point p[Degree+1];
+				int depth;
+			};
+			const auto limit{ depth(deviation(control), tolerance) };
+			const auto squared_tolerance{ tolerance*tolerance };
+			Piece stack[max_depth+1];
+			std::size_t top{ 0 }, written{ 0 };
+			for(int i{0}; i<=Degree; ++i) stack[0].p[i] = control[i];
+			stack[top++].depth = 0;
+			while(top){
+				auto piece{ stack[--top] };
+				while(piece.depth < limit && chord_deviation<Degree>(piece.p) > squared_tolerance){
+					auto& right{ stack[top++] };
+					Piece left;
+					split<Degree>(piece.p, left.p, right.p);
+					left.depth = right.depth = piece.depth+1;
+					piece = left;
+				}
+				out[written++] = Line(piece.p[0], piece.p[Degree]);
+			}
+			return written;
+		}
+
+		template<int Degree, typename Point>
+		inline
+		auto bound(const Point* control, float tolerance) -> std::size_t {
+			Point p[Degree+1];
+			for(int i{0}; i<=Degree; ++i) p[i] = control[i];
+			return std::size_t{1} << depth(deviation(p), tolerance);
+		}
+	}
+
+	/**
+	 *  Most segments flatten_bezier can write for the curve, at most 2^16.
+	 */
+	template<typename Point>
+	inline
+	auto flatten_bound(const Point& p0, const Point& p1, const Point& p2, float tolerance) -> std::size_t {
+		const Point control[3]{ p0, p1, p2 };
+		return flatten_detail::bound<2>(control, tolerance);
+	}
+
+	template<typename Point>
+	inline
+	auto flatten_bound(const Point& p0, const Point& p1, const Point& p2, const Point& p3, float tolerance)
+	-> std::size_t {
+		const Point control[4]{ p0, p1, p2, p3 };
+		return flatten_detail::bound<3>(control, tolerance);
+	}
+
+	/**
+	 *  Adaptive flattening of a quadratic Bezier into consecutive segments
+	 *  that stay within tolerance of the curve. Flat stretches get long
+	 *  segments, out needs room for flatten_bound of them. Returns the
+	 *  number written.
+	 */
+	inline
+	auto flatten_bezier(const Vector2& p0, const Vector2& p1, const Vector2& p2, float tolerance, Line2* out)
+	-> std::size_t {
+		const Vector2 control[3]{ p0, p1, p2 };
+		return flatten_detail::subdivide<2>(control, tolerance, out);
+	}
+
+	inline
+	auto flatten_bezier(const Vector3& p0, const Vector3& p1, const Vector3& p2, float tolerance, Line3* out)
+	-> std::size_t {
+		const Vector3 control[3]{ p0, p1, p2 };
+		return flatten_detail::subdivide<2>(control, tolerance, out);
+	}
+
+	/**
+	 *  Same for a cubic Bezier.
+	 */
+	inline
+	auto flatten_bezier(const Vector2& p0, const Vector2& p1, const Vector2& p2, const Vector2& p3,
+						float tolerance, Line2* out) -> std::size_t {
+		const Vector2 control[4]{ p0, p1, p2, p3 };
+		return flatten_detail::subdivide<3>(control, tolerance, out);
+	}
+
+	inline
+	auto flatten_bezier(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3,
+						float tolerance, Line3* out) -> std::size_t {
+		const Vector3 control[4]{ p0, p1, p2, p3 };
+		return flatten_detail::subdivide<3>(control, tolerance, out);
+	}
+
+	/**
+	 *  Summed flatten_bound of count Beziers of the given degree (2 or 3),
+	 *  stored as Degree+1 consecutive control points each.
+	 */
+	template<int Degree, typename Point>
+	inline
+	auto flatten_beziers_bound(const Point* control, std::size_t count, float tolerance) -> std::size_t {
+		std::size_t total{ 0 };
+		for(std::size_t n{0}; n<count; ++n) total += flatten_detail::bound<Degree>(control+n*(Degree+1), tolerance);
+		return total;
+	}
+
+	/**
+	 *  Flattens count Beziers laid out as for flatten_beziers_bound, which
+	 *  gives the room out needs. Curve n ends up in out[first[n]] up to
+	 *  out[first[n+1]], first has count+1 entries. Every curve is written
+	 *  at its bound offset in parallel and the gaps are closed afterwards.
+	 *  Returns the total segment count.
+	 */
+	template<int Degree, typename Point, typename Line>
+	inline
+	auto flatten_beziers(const Point* control, std::size_t count, float tolerance, Line* out,
+						 std::uint32_t* first, unsigned thread_count=0) -> std::size_t {
+		static_assert(Degree == 2 || Degree == 3, "flatten_beziers takes quadratic or cubic curves");
+		parallel_for(count, 1u << 12, [&](std::size_t begin, std::size_t end, std::size_t){
+			for(auto n{begin}; n<end; ++n)
+				first[n] = static_cast<std::uint32_t>(flatten_detail::bound<Degree>(control+n*(Degree+1), tolerance));
+		}, thread_count);
+		std::uint32_t offset{ 0 };
+		for(std::size_t n{0}; n<count; ++n){
+			const auto size{ first[n] };
+			first[n] = offset;
+			offset += size;
+		}
+
+		std::vector<std::uint32_t> written(count);
+		parallel_for(count, 1u << 10, [&](std::size_t begin, std::size_t end, std::size_t){
+			Point p[Degree+1];
+			for(auto n{begin}; n<end; ++n){
+				for(int i{0}; i<=Degree; ++i) p[i] = control[n*(Degree+1)+i];
+				written[n] = static_cast<std::uint32_t>(flatten_detail::subdivide<Degree>(p, tolerance, out+first[n]));
+			}
+		}, thread_count);
+
+		std::uint32_t total{ 0 };
+		for(std::size_t n{0}; n<count; ++n){
+			if(first[n] != total) std::copy(out+first[n], out+first[n]+written[n], out+total);
+			first[n] = total;
+			total += written[n];
+		}
+		first[count] = total;
+		return total;
+	}
+
+	inline constexpr
+	auto min(float& a, float& b) -> float& {
+		return a<b?a:b;
+	}
+
+	inline constexpr
+	auto max(float& a, float& b) -> float& {
+		return a>b?a:b;
+	}
+
+    inline 
+    auto powZ(const float& b, const int& exp)-> float {
+        if(b == 0) [[unlikely]] {
+            if(exp<0){
+                return std::round_toward_infinity;
+            }
+            return 1;
+        }
+        if(exp == 0) return 0;
+
+        auto base{b};
+        for(int i{1}; i<exp; ++i){
+            base *= b;
+        }
+
+        if(exp<0){
+            return 1/b;
+        }
+        return base;
     }
 
-    inline 
-    auto lerp(const Vector3& goal, const Vector3& current, const float& step)-> Vector3 {
-		auto fwd{ goal-current };
-		fwd._normalize()._scale(step);
-		return current.add(fwd); 
-    }
+	inline 
+	auto pow(const float& b, const float& exp) -> float {
+  		 return __builtin_powf(b, exp); 
+	}
+
+	/**
+	 *  Static bounding volume hierarchy over boxes, built with a binned SAH.
+	 *  Bvh<2> works on Rects (stored flat at z=0), Bvh<3> on AABB3s.
+	 *  Children of a node are always allocated next to each other, so a node
+	 *  only stores the index of its first child.
+	 */
+	template<int Dim>
+	class Bvh {
+	public:
+		struct Node {
+			float lower[3];
+			std::uint32_t first;
+			float upper[3];
+			std::uint32_t count;
+
+			inline constexpr
+			auto isLeaf() const -> bool {
+				return count != 0;
+			}
+
+			inline constexpr
+			auto bounds() const -> AABB3 {
+				return AABB3(
+					Vector3(lower[0], lower[1], lower[2]),
+					Vector3(upper[0], upper[1], upper[2])
+				);
+			}
+		};
+		static_assert(sizeof(Node) == 32, "Bvh nodes must stay 32 bytes");
+
+		struct Hit {
+			std::uint32_t index;
+			float fraction;
+		};
+
+		struct Nearest {
+			std::uint32_t index;
+			float distance;
+			Vector3 point;
+		};
+
+		static constexpr std::uint32_t npos{ 0xffffffffu };
+		static constexpr std::uint32_t max_leaf_size{ 4 };
+		static constexpr int bin_count{ 16 };
+		static constexpr std::size_t parallel_threshold{ 1u << 14 };
+
+	private:
+		std::vector<Node> node_pool;
+		std::vector<std::uint32_t> order;
+		std::vector<AABB3> boxes;
+		std::vector<AABB3> leaf_boxes;
+		std::vector<Vector3> centroids;
+
+		static constexpr int max_depth{ 48 };
+		static constexpr int stack_size{ 128 };
+
+		static inline
+		auto cost_area(const AABB3& b) -> float {
+			if(b.isEmpty()) return 0.f;
+			const auto dx{ b.getMax(0)-b.getMin(0) };
+			const auto dy{ b.getMax(1)-b.getMin(1) };
+			if(Dim == 2) return dx+dy;
+			const auto dz{ b.getMax(2)-b.getMin(2) };
+			return dx*dy + dy*dz + dz*dx;
+		}
+
+		static inline
+		auto write_bounds(Node& node, const AABB3& b) -> void {
+			for(int a{0}; a<3; ++a){
+				node.lower[a] = b.getMin(a);
+				node.upper[a] = b.getMax(a);
+			}
+		}
+
+		/**
+		 *  Slab test of the segment origin + t*dir, t in [0, t_max],
+		 *  returns the entry fraction or inf if the box is missed.
+		 */
+		static inline
+		auto slab(const float* lower, const float* upper, const float* origin,
+				  const float* inv_dir, float t_max) -> float {
+			auto t_enter{ 0.f };
+			auto t_exit{ t_max };
+			for(int a{0}; a<Dim; ++a){
+				const auto t0{ (lower[a]-origin[a])*inv_dir[a] };
+				const auto t1{ (upper[a]-origin[a])*inv_dir[a] };
+				t_enter = std::max(t_enter, std::min(t0, t1));
+				t_exit  = std::min(t_exit,  std::max(t0, t1));
+			}
+			return t_enter <= t_exit ? t_enter : inf;
+		}
+
+		static inline
+		auto squared_distance(const float* lower, const float* upper, const float* p)
+		-> float {
+			auto d{ 0.f };
+			for(int a{0}; a<Dim; ++a){
+				const auto v{ std::max(std::max(lower[a]-p[a], 0.f), p[a]-upper[a]) };
+				d += v*v;
+			}
+			return d;
+		}
+
+		auto subdivide(std::atomic<std::uint32_t>& used_nodes, std::uint32_t node_index,
+					   std::size_t begin, std::size_t end, int depth, int parallel_depth)
+		-> void {
+			auto bounds{ AABB3::empty() };
+			auto centroid_bounds{ AABB3::empty() };
+			for(auto n{begin}; n<end; ++n){
+				bounds._merge(boxes[order[n]]);
+				centroid_bounds._merge(centroids[order[n]]);
+			}
+
+			const auto count{ end-begin };
+			write_bounds(node_pool[node_index], bounds);
+			auto make_leaf{ [&]{
+				node_pool[node_index].first = static_cast<std::uint32_t>(begin);
+				node_pool[node_index].count = static_cast<std::uint32_t>(count);
+			}};
+			if(count <= max_leaf_size){
+				make_leaf();
+				return;
+			}
+
+			auto best_axis{ -1 };
+			auto best_split{ 0 };
+			auto best_cost{ inf };
+			for(int a{0}; a<Dim; ++a){
+				const auto lo{ centroid_bounds.getMin(a) };
+				const auto extent{ centroid_bounds.getMax(a)-lo };
+				if(extent <= 0.f) continue;
+				const auto scale{ bin_count/extent };
+
+				AABB3 bin_bounds[bin_count];
+				std::size_t bin_counts[bin_count]{};
+				for(auto n{begin}; n<end; ++n){
+					const auto b{ std::min(bin_count-1,
+						static_cast<int>((centroids[order[n]][a]-lo)*scale)) };
+					++bin_counts[b];
+					bin_bounds[b]._merge(boxes[order[n]]);
+				}
+
+				float right_cost[bin_count];
+				auto right{ AABB3::empty() };
+				std::size_t right_count{ 0 };
+				for(int b{bin_count-1}; b>0; --b){
+					right._merge(bin_bounds[b]);
+					right_count += bin_counts[b];
+					right_cost[b] = cost_area(right)*right_count;
+				}
+
+				auto left{ AABB3::empty() };
+				std::size_t left_count{ 0 };
+				for(int b{0}; b<bin_count-1; ++b){
+					left._merge(bin_bounds[b]);
+					left_count += bin_counts[b];
+					const auto cost{ cost_area(left)*left_count + right_cost[b+1] };
+					if(cost < best_cost){
+						best_cost = cost;
+						best_axis = a;
+						best_split = b+1;
+					}
+				}
+			}
+
+			// all centroids coincide, large groups still get a median split
+			const auto leaf_cost{ cost_area(bounds)*count };
+			if(count <= 4*max_leaf_size && (best_axis < 0 || best_cost >= leaf_cost)){
+				make_leaf();
+				return;
+			}
+
+			auto mid{ begin };
+			if(best_axis >= 0 && depth < max_depth){
+				const auto lo{ centroid_bounds.getMin(best_axis) };
+				const auto scale{ bin_count/(centroid_bounds.getMax(best_axis)-lo) };
+				mid = static_cast<std::size_t>(std::partition(
+					order.begin()+begin, order.begin()+end,
+					[&](std::uint32_t i){
+						return std::min(bin_count-1,
+							static_cast<int>((centroids[i][best_axis]-lo)*scale)) < best_split;
+					}) - order.begin());
+			}
+			if(mid == begin || mid == end){
+				const auto axis{ centroid_bounds.largest_axis() };
+				mid = begin + count/2;
+				std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end,
+					[&](std::uint32_t l, std::uint32_t r){
+						return centroids[l][axis] < centroids[r][axis];
+					});
+			}
+
+			const auto left_index{ used_nodes.fetch_add(2) };
+			node_pool[node_index].first = left_index;
+			node_pool[node_index].count = 0;
+
+			if(parallel_depth > 0 && count >= parallel_threshold){
+				std::thread worker([this, &used_nodes, left_index, begin, mid, depth,
+									parallel_depth]{
+					subdivide(used_nodes, left_index, begin, mid, depth+1, parallel_depth-1);
+				});
+				subdivide(used_nodes, left_index+1, mid, end, depth+1, parallel_depth-1);
+				worker.join();
+			}
+			else{
+				subdivide(used_nodes, left_index, begin, mid, depth+1, 0);
+				subdivide(used_nodes, left_index+1, mid, end, depth+1, 0);
+			}
+		}
+
+		auto build(unsigned thread_count) -> void {
+			const auto count{ boxes.size() };
+			centroids.clear();
+			centroids.reserve(count);
+			order.resize(count);
+			for(std::size_t n{0}; n<count; ++n){
+				centroids.push_back(boxes[n].getCenter());
+				order[n] = static_cast<std::uint32_t>(n);
+			}
+
+			node_pool.assign(count ? 2*count-1 : 1, Node{});
+			if(!count){
+				write_bounds(node_pool[0], AABB3::empty());
+				return;
+			}
+
+			auto parallel_depth{ 0 };
+			for(auto workers{ worker_count(thread_count) }; workers > 1; workers >>= 1)
+				++parallel_depth;
+			std::atomic<std::uint32_t> used_nodes{ 1 };
+			subdivide(used_nodes, 0, 0, count, 0, parallel_depth);
+			node_pool.resize(used_nodes);
+
+			leaf_boxes.clear();
+			leaf_boxes.reserve(count);
+			for(auto index : order) leaf_boxes.push_back(boxes[index]);
+			boxes = std::vector<AABB3>();
+			centroids = std::vector<Vector3>();
+		}
+
+		template<typename Visit>
+		inline
+		auto traverse_ray(const float* origin, const float* dir, Visit&& visit) const
+		-> Hit {
+			float inv_dir[3];
+			for(int a{0}; a<3; ++a) inv_dir[a] = 1.f/dir[a];
+
+			auto best{ Hit{ npos, 1.f } };
+			if(order.empty()) return Hit{ npos, inf };
+
+			std::uint32_t stack[stack_size];
+			int top{ 0 };
+			stack[top++] = 0;
+			while(top){
+				const auto& node{ node_pool[stack[--top]] };
+				if(slab(node.lower, node.upper, origin, inv_dir, best.fraction) == inf)
+					continue;
+
+				if(node.isLeaf()){
+					for(auto n{node.first}; n<node.first+node.count; ++n)
+						visit(n, inv_dir, best);
+					continue;
+				}
+
+				const auto& l{ node_pool[node.first] };
+				const auto& r{ node_pool[node.first+1] };
+				const auto tl{ slab(l.lower, l.upper, origin, inv_dir, best.fraction) };
+				const auto tr{ slab(r.lower, r.upper, origin, inv_dir, best.fraction) };
+				if(tl <= tr){
+					if(tr != inf) stack[top++] = node.first+1;
+					if(tl != inf) stack[top++] = node.first;
+				}
+				else{
+					if(tl != inf) stack[top++] = node.first;
+					stack[top++] = node.first+1;
+				}
+			}
+			if(best.index == npos) best.fraction = inf;
+			return best;
+		}
+
+		inline
+		auto raycast(const float* origin, const float* dir) const -> Hit {
+			return traverse_ray(origin, dir,
+				[&](std::uint32_t n, const float* inv_dir, Hit& best){
+					float lower[3], upper[3];
+					for(int a{0}; a<3; ++a){
+						lower[a] = leaf_boxes[n].getMin(a);
+						upper[a] = leaf_boxes[n].getMax(a);
+					}
+					const auto t{ slab(lower, upper, origin, inv_dir, best.fraction) };
+					if(t < best.fraction || (t == best.fraction && best.index == npos))
+						best = Hit{ order[n], t };
+				});
+		}
+
+		template<typename Func>
+		inline
+		auto overlap(const AABB3& box, Func&& func) const -> void {
+			if(order.empty()) return;
+			std::uint32_t stack[stack_size];
+			int top{ 0 };
+			stack[top++] = 0;
+			while(top){
+				const auto& node{ node_pool[stack[--top]] };
+				auto hit{ true };
+				for(int a{0}; a<Dim; ++a)
+					hit = hit && node.lower[a] <= box.getMax(a) && box.getMin(a) <= node.upper[a];
+				if(!hit) continue;
+
+				if(node.isLeaf()){
+					for(auto n{node.first}; n<node.first+node.count; ++n){
+						auto prim_hit{ true };
+						for(int a{0}; a<Dim; ++a)
+							prim_hit = prim_hit
+								&& leaf_boxes[n].getMin(a) <= box.getMax(a)
+								&& box.getMin(a) <= leaf_boxes[n].getMax(a);
+						if(prim_hit) func(order[n]);
+					}
+					continue;
+				}
+				stack[top++] = node.first+1;
+				stack[top++] = node.first;
+			}
+		}
+
+		inline
+		auto nearest(const float* p) const -> Nearest {
+			auto best{ Nearest{ npos, inf, Vector3::infinity() } };
+			if(order.empty()) return best;
+
+			auto best_sq{ inf };
+			std::uint32_t stack[stack_size];
+			int top{ 0 };
+			stack[top++] = 0;
+			while(top){
+				const auto& node{ node_pool[stack[--top]] };
+				if(squared_distance(node.lower, node.upper, p) >= best_sq) continue;
+
+				if(node.isLeaf()){
+					for(auto n{node.first}; n<node.first+node.count; ++n){
+						float lower[3], upper[3];
+						for(int a{0}; a<3; ++a){
+							lower[a] = leaf_boxes[n].getMin(a);
+							upper[a] = leaf_boxes[n].getMax(a);
+						}
+						const auto d{ squared_distance(lower, upper, p) };
+						if(d < best_sq){
+							best_sq = d;
+							float c[3]{ 0.f, 0.f, 0.f };
+							for(int a{0}; a<Dim; ++a)
+								c[a] = std::min(std::max(p[a], lower[a]), upper[a]);
+							best = Nearest{ order[n], sqrtf(d), Vector3(c[0], c[1], c[2]) };
+						}
+					}
+					continue;
+				}
+
+				const auto& l{ node_pool[node.first] };
+				const auto& r{ node_pool[node.first+1] };
+				const auto dl{ squared_distance(l.lower, l.upper, p) };
+				const auto dr{ squared_distance(r.lower, r.upper, p) };
+				if(dl <= dr){
+					stack[top++] = node.first+1;
+					stack[top++] = node.first;
+				}
+				else{
+					stack[top++] = node.first;
+					stack[top++] = node.first+1;
+				}
+			}
+			return best;
+		}
+
+	public:
+		inline
+		Bvh(){
+			node_pool.assign(1, Node{});
+			write_bounds(node_pool[0], AABB3::empty());
+		}
+
+		inline
+		Bvh(const Rect* rects, std::size_t count, unsigned thread_count=0){
+			static_assert(Dim == 2, "Rects can only be stored in a Bvh<2>");
+			boxes.reserve(count);
+			for(std::size_t n{0}; n<count; ++n) boxes.emplace_back(rects[n]);
+			build(thread_count);
+		}
+
+		inline
+		Bvh(const AABB3* aabbs, std::size_t count, unsigned thread_count=0)
+		:boxes(aabbs, aabbs+count){
+			static_assert(Dim == 3, "AABB3s can only be stored in a Bvh<3>");
+			build(thread_count);
+		}
+
+		inline
+		auto nodes() const -> const std::vector<Node>& {
+			return node_pool;
+		}
+
+		/**
+		 *  Maps the primitive slots referenced by leaves to the input indices.
+		 */
+		inline
+		auto indices() const -> const std::vector<std::uint32_t>& {
+			return order;
+		}
+
+		/**
+		 *  Primitive boxes in the same slot order as indices().
+		 */
+		inline
+		auto leaf_bounds() const -> const std::vector<AABB3>& {
+			return leaf_boxes;
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return order.size();
+		}
+
+		inline
+		auto bounds() const -> AABB3 {
+			return node_pool[0].bounds();
+		}
+
+		/**
+		 *  Closest box hit along the segment, fraction is 0 at getFrom()
+		 *  and 1 at getTo(). index is npos if nothing was hit.
+		 */
+		inline
+		auto raycast(const Line2& line) const -> Hit {
+			static_assert(Dim == 2, "Line2 raycasts need a Bvh<2>");
+			const float origin[3]{ line.getFrom().getX(), line.getFrom().getY(), 0.f };
+			const float dir[3]{ line.asVec2().getX(), line.asVec2().getY(), 0.f };
+			return raycast(origin, dir);
+		}
+
+		inline
+		auto raycast(const Line3& line) const -> Hit {
+			static_assert(Dim == 3, "Line3 raycasts need a Bvh<3>");
+			const auto d{ line.getDir() };
+			const float origin[3]{
+				line.getFrom().getX(), line.getFrom().getY(), line.getFrom().getZ()
+			};
+			const float dir[3]{ d.getX(), d.getY(), d.getZ() };
+			return raycast(origin, dir);
+		}
+
+		/**
+		 *  Closest hit with a custom primitive test, test(index, t_max)
+		 *  returns the fraction at which primitive index is hit or inf.
+		 */
+		template<typename Test>
+		inline
+		auto raycast(const Line3& line, Test&& test) const -> Hit {
+			static_assert(Dim == 3, "Line3 raycasts need a Bvh<3>");
+			const auto d{ line.getDir() };
+			const float origin[3]{
+				line.getFrom().getX(), line.getFrom().getY(), line.getFrom().getZ()
+			};
+			const float dir[3]{ d.getX(), d.getY(), d.getZ() };
+			return traverse_ray(origin, dir,
+				[&](std::uint32_t n, const float*, Hit& best){
+					const auto t{ test(order[n], best.fraction) };
+					if(t < best.fraction || (t == best.fraction && best.index == npos))
+						best = Hit{ order[n], t };
+				});
+		}
+
+		/**
+		 *  Calls func(index) for every stored box overlapping the query box.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_overlap(const Rect& rect, Func&& func) const -> void {
+			static_assert(Dim == 2, "Rect queries need a Bvh<2>");
+			overlap(AABB3(rect), func);
+		}
+
+		template<typename Func>
+		inline
+		auto for_each_overlap(const AABB3& box, Func&& func) const -> void {
+			overlap(box, func);
+		}
+
+		template<typename Box>
+		inline
+		auto query(const Box& box, std::vector<std::uint32_t>& out) const -> std::size_t {
+			const auto before{ out.size() };
+			for_each_overlap(box, [&](std::uint32_t index){ out.push_back(index); });
+			return out.size() - before;
+		}
+
+		/**
+		 *  Box closest to the point, distance is 0 if the point is inside.
+		 */
+		inline
+		auto nearest(const Vector2& point) const -> Nearest {
+			static_assert(Dim == 2, "Vector2 queries need a Bvh<2>");
+			const float p[3]{ point.getX(), point.getY(), 0.f };
+			return nearest(p);
+		}
+
+		inline
+		auto nearest(const Vector3& point) const -> Nearest {
+			static_assert(Dim == 3, "Vector3 queries need a Bvh<3>");
+			const float p[3]{ point.getX(), point.getY(), point.getZ() };
+			return nearest(p);
+		}
+	};
+
+	using Bvh2 = Bvh<2>;
+	using Bvh3 = Bvh<3>;
+
+	/**
+	 *  Incremental AABB tree for moving objects. Leaves store fattened boxes
+	 *  so small movements do not touch the tree, and inserts/removals keep
+	 *  the tree height balanced with rotations. Proxy ids stay valid until
+	 *  they are destroyed.
+	 */
+	class Dynamic_AABB_Tree {
+	public:
+		static constexpr std::int32_t null_node{ -1 };
+
+		struct Node {
+			AABB3 box;
+			std::uint32_t user_data;
+			std::int32_t parent;
+			std::int32_t child1;
+			std::int32_t child2;
+			std::int32_t height;
+			bool moved;
+
+			inline constexpr
+			auto isLeaf() const -> bool {
+				return child1 == null_node;
+			}
+		};
+
+	private:
+		std::vector<Node> nodes;
+		std::vector<std::int32_t> move_buffer;
+		std::int32_t root{ null_node };
+		std::int32_t free_list{ null_node };
+		std::size_t proxy_count{ 0 };
+		float margin;
+
+		static constexpr float displacement_multiplier{ 4.f };
+
+		auto allocate_node() -> std::int32_t {
+			if(free_list == null_node){
+				nodes.push_back(Node{});
+				free_list = static_cast<std::int32_t>(nodes.size()-1);
+				nodes.back().parent = null_node;
+			}
+			const auto id{ free_list };
+			free_list = nodes[id].parent;
+			nodes[id] = Node{ AABB3::empty(), 0, null_node, null_node, null_node, 0, false };
+			return id;
+		}
+
+		auto free_node(std::int32_t id) -> void {
+			nodes[id].parent = free_list;
+			nodes[id].height = -1;
+			free_list = id;
+		}
+
+		static inline
+		auto area(const AABB3& b) -> float {
+			return b.surface_area();
+		}
+
+		auto insert_leaf(std::int32_t leaf) -> void {
+			if(root == null_node){
+				root = leaf;
+				nodes[root].parent = null_node;
+				return;
+			}
+
+			// descend towards the cheapest sibling, cost is the area added
+			// to every ancestor (Catto's branch and bound heuristic)
+			const auto leaf_box{ nodes[leaf].box };
+			auto index{ root };
+			while(!nodes[index].isLeaf()){
+				const auto c1{ nodes[index].child1 };
+				const auto c2{ nodes[index].child2 };
+
+				const auto node_area{ area(nodes[index].box) };
+				const auto combined_area{ area(nodes[index].box.merged(leaf_box)) };
+				const auto cost{ 2.f*combined_area };
+				const auto inheritance{ 2.f*(combined_area - node_area) };
+
+				auto child_cost{ [&](std::int32_t c){
+					const auto merged{ area(leaf_box.merged(nodes[c].box)) };
+					if(nodes[c].isLeaf()) return merged + inheritance;
+					return merged - area(nodes[c].box) + inheritance;
+				}};
+				const auto cost1{ child_cost(c1) };
+				const auto cost2{ child_cost(c2) };
+
+				if(cost < cost1 && cost < cost2) break;
+				index = cost1 < cost2 ? c1 : c2;
+			}
+
+			const auto sibling{ index };
+			const auto old_parent{ nodes[sibling].parent };
+			const auto new_parent{ allocate_node() };
+			nodes[new_parent].parent = old_parent;
+			nodes[new_parent].box = leaf_box.merged(nodes[sibling].box);
+			nodes[new_parent].height = nodes[sibling].height + 1;
+			nodes[new_parent].child1 = sibling;
+			nodes[new_parent].child2 = leaf;
+			nodes[sibling].parent = new_parent;
+			nodes[leaf].parent = new_parent;
+
+			if(old_parent != null_node){
+				if(nodes[old_parent].child1 == sibling) nodes[old_parent].child1 = new_parent;
+				else nodes[old_parent].child2 = new_parent;
+			}
+			else root = new_parent;
+
+			fix_upwards(nodes[leaf].parent);
+		}
+
+		auto remove_leaf(std::int32_t leaf) -> void {
+			if(leaf == root){
+				root = null_node;
+				return;
+			}
+
+			const auto parent{ nodes[leaf].parent };
+			const auto grand_parent{ nodes[parent].parent };
+			const auto sibling{ nodes[parent].child1 == leaf
+				? nodes[parent].child2 : nodes[parent].child1 };
+
+			if(grand_parent != null_node){
+				if(nodes[grand_parent].child1 == parent) nodes[grand_parent].child1 = sibling;
+				else nodes[grand_parent].child2 = sibling;
+				nodes[sibling].parent = grand_parent;
+				free_node(parent);
+				fix_upwards(grand_parent);
+			}
+			else{
+				root = sibling;
+				nodes[sibling].parent = null_node;
+				free_node(parent);
+			}
+		}
+
+		auto fix_upwards(std::int32_t index) -> void {
+			while(index != null_node){
+				index = balance(index);
+				auto& node{ nodes[index] };
+				const auto& c1{ nodes[node.child1] };
+				const auto& c2{ nodes[node.child2] };
+				node.height = 1 + std::max(c1.height, c2.height);
+				node.box = c1.box.merged(c2.box);
+				index = node.parent;
+			}
+		}
+
+		/**
+		 *  Rotates the taller grandchild of a up if its children differ in
+		 *  height by more than one, returns the new subtree root.
+		 */
+		auto balance(std::int32_t a) -> std::int32_t {
+			if(nodes[a].isLeaf() || nodes[a].height < 2) return a;
+
+			const auto b{ nodes[a].child1 };
+			const auto c{ nodes[a].child2 };
+			const auto diff{ nodes[c].height - nodes[b].height };
+			if(diff > 1) return rotate_up(a, c, b, false);
+			if(diff < -1) return rotate_up(a, b, c, true);
+			return a;
+		}
+
+		auto rotate_up(std::int32_t a, std::int32_t up, std::int32_t other, bool up_is_child1)
+		-> std::int32_t {
+			const auto f{ nodes[up].child1 };
+			const auto g{ nodes[up].child2 };
+
+			nodes[up].child1 = a;
+			nodes[up].parent = nodes[a].parent;
+			nodes[a].parent = up;
+
+			const auto up_parent{ nodes[up].parent };
+			if(up_parent != null_node){
+				if(nodes[up_parent].child1 == a) nodes[up_parent].child1 = up;
+				else nodes[up_parent].child2 = up;
+			}
+			else root = up;
+
+			// the taller grandchild stays with up, the other one moves to a
+			const auto keep{ nodes[f].height > nodes[g].height ? f : g };
+			const auto give{ keep == f ? g : f };
+			nodes[up].child2 = keep;
+			if(up_is_child1) nodes[a].child1 = give;
+			else nodes[a].child2 = give;
+			nodes[give].parent = a;
+
+			nodes[a].box = nodes[other].box.merged(nodes[give].box);
+			nodes[a].height = 1 + std::max(nodes[other].height, nodes[give].height);
+			nodes[up].box = nodes[a].box.merged(nodes[keep].box);
+			nodes[up].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+			return up;
+		}
+
+	public:
+		inline explicit
+		Dynamic_AABB_Tree(float fat_margin=0.1f): margin{fat_margin}{}
+
+		inline
+		auto create_proxy(const AABB3& box, std::uint32_t user_data) -> std::int32_t {
+			const auto id{ allocate_node() };
+			nodes[id].box = box.expanded(margin);
+			nodes[id].user_data = user_data;
+			nodes[id].moved = true;
+			insert_leaf(id);
+			move_buffer.push_back(id);
+			++proxy_count;
+			return id;
+		}
+
+		inline
+		auto create_proxy(const Rect& rect, std::uint32_t user_data) -> std::int32_t {
+			return create_proxy(AABB3(rect), user_data);
+		}
+
+		inline
+		auto destroy_proxy(std::int32_t proxy) -> void {
+			remove_leaf(proxy);
+			free_node(proxy);
+			--proxy_count;
+			for(auto& id : move_buffer)
+				if(id == proxy) id = null_node;
+		}
+
+		/**
+		 *  Updates a proxy after its object moved by displacement. Nothing
+		 *  happens while box stays inside the fat box, otherwise the leaf is
+		 *  reinserted with a box fattened along the displacement.
+		 *  Returns true if the proxy was reinserted.
+		 */
+		inline
+		auto move_proxy(std::int32_t proxy, const AABB3& box, const Vector3& displacement)
+		-> bool {
+			auto fat{ box.expanded(margin) };
+			const auto d{ displacement*displacement_multiplier };
+			auto lower{ fat.getMin() };
+			auto upper{ fat.getMax() };
+			for(int a{0}; a<3; ++a){
+				if(d[a] < 0.f) lower[a] += d[a];
+				else upper[a] += d[a];
+			}
+			fat = AABB3(lower, upper);
+
+			const auto& tree_box{ nodes[proxy].box };
+			if(tree_box.contains(box)){
+				// keep the old box unless it became far too large
+				if(fat.expanded(4.f*margin).contains(tree_box)) return false;
+			}
+
+			remove_leaf(proxy);
+			nodes[proxy].box = fat;
+			insert_leaf(proxy);
+			if(!nodes[proxy].moved){
+				nodes[proxy].moved = true;
+				move_buffer.push_back(proxy);
+			}
+			return true;
+		}
+
+		inline
+		auto move_proxy(std::int32_t proxy, const Rect& rect, const Vector2& displacement)
+		-> bool {
+			return move_proxy(proxy, AABB3(rect), Vector3(displacement));
+		}
+
+		/**
+		 *  Refit-only update: the leaf box is replaced without touching the
+		 *  tree structure. Call refit() once after a batch of these.
+		 */
+		inline
+		auto set_proxy_bounds(std::int32_t proxy, const AABB3& box) -> void {
+			nodes[proxy].box = box.expanded(margin);
+			if(!nodes[proxy].moved){
+				nodes[proxy].moved = true;
+				move_buffer.push_back(proxy);
+			}
+		}
+
+		/**
+		 *  Recomputes all internal boxes bottom up, keeps the topology.
+		 */
+		inline
+		auto refit() -> void {
+			if(root == null_node) return;
+			std::vector<std::int32_t> post_order;
+			post_order.reserve(nodes.size());
+			std::vector<std::int32_t> stack{ root };
+			while(!stack.empty()){
+				const auto index{ stack.back() };
+				stack.pop_back();
+				post_order.push_back(index);
+				if(!nodes[index].isLeaf()){
+					stack.push_back(nodes[index].child1);
+					stack.push_back(nodes[index].child2);
+				}
+			}
+			for(auto it{ post_order.rbegin() }; it != post_order.rend(); ++it){
+				auto& node{ nodes[*it] };
+				if(node.isLeaf()) continue;
+				node.box = nodes[node.child1].box.merged(nodes[node.child2].box);
+			}
+		}
+
+		inline
+		auto getFatAABB(std::int32_t proxy) const -> const AABB3& {
+			return nodes[proxy].box;
+		}
+
+		inline
+		auto getUserData(std::int32_t proxy) const -> std::uint32_t {
+			return nodes[proxy].user_data;
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return proxy_count;
+		}
+
+		inline
+		auto height() const -> std::int32_t {
+			return root == null_node ? 0 : nodes[root].height;
+		}
+
+		/**
+		 *  Calls func(proxy) for every proxy whose fat box overlaps box.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_overlap(const AABB3& box, Func&& func) const -> void {
+			if(root == null_node) return;
+			std::int32_t stack[128];
+			std::vector<std::int32_t> overflow;
+			int top{ 0 };
+			stack[top++] = root;
+			while(top || !overflow.empty()){
+				std::int32_t index;
+				if(!overflow.empty()){ index = overflow.back(); overflow.pop_back(); }
+				else index = stack[--top];
+
+				const auto& node{ nodes[index] };
+				if(!node.box.intersects(box)) continue;
+				if(node.isLeaf()){
+					func(index);
+					continue;
+				}
+				for(auto child : { node.child1, node.child2 }){
+					if(top < 128) stack[top++] = child;
+					else overflow.push_back(child);
+				}
+			}
+		}
+
+		template<typename Func>
+		inline
+		auto for_each_overlap(const Rect& rect, Func&& func) const -> void {
+			for_each_overlap(AABB3(rect), func);
+		}
+
+		/**
+		 *  Reports every overlapping pair (proxy_a < proxy_b) that involves
+		 *  a proxy created or moved since the last call, each pair once.
+		 */
+		template<typename Func>
+		inline
+		auto update_pairs(Func&& func) -> void {
+			for(auto proxy : move_buffer){
+				if(proxy == null_node) continue;
+				for_each_overlap(nodes[proxy].box, [&](std::int32_t other){
+					if(other == proxy) return;
+					if(nodes[other].moved && other < proxy) return;
+					func(std::min(proxy, other), std::max(proxy, other));
+				});
+			}
+			for(auto proxy : move_buffer)
+				if(proxy != null_node) nodes[proxy].moved = false;
+			move_buffer.clear();
+		}
+
+		/**
+		 *  Calls func(proxy_a, proxy_b) for every overlapping pair in the tree.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_pair(Func&& func) const -> void {
+			for(std::size_t n{0}; n<nodes.size(); ++n){
+				const auto proxy{ static_cast<std::int32_t>(n) };
+				if(nodes[n].height != 0) continue;
+				for_each_overlap(nodes[n].box, [&](std::int32_t other){
+					if(other > proxy) func(proxy, other);
+				});
+			}
+		}
+	};
+
+	/**
+	 *  Sweep and prune broadphase that keeps its endpoint arrays sorted
+	 *  between updates. Frame to frame coherence makes the insertion sort
+	 *  close to linear, and the overlap pairs are persistent so every
+	 *  update only reports what was added or removed.
+	 *
+	 *  Axes::all sorts all three axes and derives pair changes from the
+	 *  endpoint swaps. Axes::single sorts one axis, its swaps maintain the
+	 *  pairs overlapping on that axis and each update re-tests only those
+	 *  candidates against the full boxes.
+	 */
+	class Sweep_And_Prune {
+	public:
+		enum class Axes { single, all };
+
+		struct Pair {
+			std::uint32_t a;
+			std::uint32_t b;
+		};
+
+	private:
+		struct Endpoint {
+			float value;
+			std::uint32_t data;
+
+			inline constexpr
+			auto id() const -> std::uint32_t {
+				return data >> 1;
+			}
+
+			inline constexpr
+			auto isMax() const -> bool {
+				return data & 1u;
+			}
+
+			// mins go first on ties so touching boxes count as overlapping
+			inline constexpr
+			auto after(const Endpoint& other) const -> bool {
+				return value > other.value
+					|| (value == other.value && isMax() && !other.isMax());
+			}
+		};
+
+		Axes mode;
+		int sweep_axis;
+		std::vector<Endpoint> endpoints[3];
+		std::vector<AABB3> boxes;
+		std::vector<std::uint32_t> free_ids;
+		std::vector<std::uint32_t> pending;
+		std::unordered_set<std::uint64_t> pairs;
+		std::unordered_set<std::uint64_t> axis_pairs;
+		std::vector<Pair> added;
+		std::vector<Pair> removed;
+		std::vector<Pair> removed_by_user;
+
+		static inline
+		auto key(std::uint32_t a, std::uint32_t b) -> std::uint64_t {
+			if(a > b) std::swap(a, b);
+			return (static_cast<std::uint64_t>(a) << 32) | b;
+		}
+
+		static inline
+		auto unkey(std::uint64_t k) -> Pair {
+			return Pair{ static_cast<std::uint32_t>(k >> 32),
+						 static_cast<std::uint32_t>(k & 0xffffffffu) };
+		}
+
+		auto add_pair(std::uint32_t a, std::uint32_t b) -> void {
+			if(pairs.insert(key(a, b)).second) added.push_back(unkey(key(a, b)));
+		}
+
+		auto remove_pair(std::uint32_t a, std::uint32_t b) -> void {
+			if(pairs.erase(key(a, b))) removed.push_back(unkey(key(a, b)));
+		}
+
+		auto axis_count() const -> int {
+			return mode == Axes::all ? 3 : 1;
+		}
+
+		auto axis_of(int a) const -> int {
+			return mode == Axes::all ? a : sweep_axis;
+		}
+
+		auto refresh_values(int a) -> void {
+			const auto axis{ axis_of(a) };
+			for(auto& e : endpoints[a]){
+				const auto& box{ boxes[e.id()] };
+				e.value = e.isMax() ? box.getMax(axis) : box.getMin(axis);
+			}
+		}
+
+		auto begin_overlap(std::uint32_t a, std::uint32_t b) -> void {
+			if(mode == Axes::single) axis_pairs.insert(key(a, b));
+			else if(boxes[a].intersects(boxes[b])) add_pair(a, b);
+		}
+
+		auto end_overlap(std::uint32_t a, std::uint32_t b) -> void {
+			if(mode == Axes::single) axis_pairs.erase(key(a, b));
+			remove_pair(a, b);
+		}
+
+		/**
+		 *  Insertion sort that tracks the swaps. A min moving below a max
+		 *  can start an overlap, a max moving below a min ends one.
+		 */
+		auto sort_axis(int a) -> void {
+			auto& list{ endpoints[a] };
+			for(std::size_t n{1}; n<list.size(); ++n){
+				const auto current{ list[n] };
+				auto m{ n };
+				while(m > 0 && list[m-1].after(current)){
+					const auto& passed{ list[m-1] };
+					if(passed.id() != current.id()){
+						if(!current.isMax() && passed.isMax()) begin_overlap(current.id(), passed.id());
+						else if(current.isMax() && !passed.isMax()) end_overlap(current.id(), passed.id());
+					}
+					list[m] = list[m-1];
+					--m;
+				}
+				list[m] = current;
+			}
+		}
+
+		/**
+		 *  Single axis mode, the other axes can start or stop overlapping
+		 *  without a swap so every candidate is re-tested.
+		 */
+		auto sweep() -> void {
+			for(auto k : axis_pairs){
+				const auto p{ unkey(k) };
+				if(boxes[p.a].intersects(boxes[p.b])) add_pair(p.a, p.b);
+				else remove_pair(p.a, p.b);
+			}
+		}
+
+	public:
+		inline explicit
+		Sweep_And_Prune(Axes axes=Axes::all, int single_axis=0)
+		:mode{axes}, sweep_axis{single_axis}{}
+
+		inline
+		auto add(const AABB3& box) -> std::uint32_t {
+			std::uint32_t id;
+			if(!free_ids.empty()){
+				id = free_ids.back();
+				free_ids.pop_back();
+				boxes[id] = box;
+			}
+			else{
+				id = static_cast<std::uint32_t>(boxes.size());
+				boxes.push_back(box);
+			}
+			pending.push_back(id);
+			return id;
+		}
+
+		inline
+		auto add(const Rect& rect) -> std::uint32_t {
+			return add(AABB3(rect));
+		}
+
+		inline
+		auto remove(std::uint32_t id) -> void {
+			for(int a{0}; a<axis_count(); ++a){
+				auto& list{ endpoints[a] };
+				list.erase(std::remove_if(list.begin(), list.end(),
+					[id](const Endpoint& e){ return e.id() == id; }), list.end());
+			}
+			pending.erase(std::remove(pending.begin(), pending.end(), id), pending.end());
+			for(auto it{ pairs.begin() }; it != pairs.end();){
+				const auto p{ unkey(*it) };
+				if(p.a == id || p.b == id){
+					removed_by_user.push_back(p);
+					it = pairs.erase(it);
+				}
+				else ++it;
+			}
+			for(auto it{ axis_pairs.begin() }; it != axis_pairs.end();){
+				const auto p{ unkey(*it) };
+				if(p.a == id || p.b == id) it = axis_pairs.erase(it);
+				else ++it;
+			}
+			free_ids.push_back(id);
+		}
+
+		inline
+		auto set_bounds(std::uint32_t id, const AABB3& box) -> void {
+			boxes[id] = box;
+		}
+
+		inline
+		auto set_bounds(std::uint32_t id, const Rect& rect) -> void {
+			boxes[id] = AABB3(rect);
+		}
+
+		inline
+		auto getBounds(std::uint32_t id) const -> const AABB3& {
+			return boxes[id];
+		}
+
+		/**
+		 *  Re-sorts the endpoints and refreshes added_pairs()/removed_pairs().
+		 */
+		inline
+		auto update() -> void {
+			added.clear();
+			removed.swap(removed_by_user);
+			removed_by_user.clear();
+
+			for(int a{0}; a<axis_count(); ++a){
+				refresh_values(a);
+				sort_axis(a);
+			}
+
+			// new boxes enter from +inf, which is a valid starting order
+			for(int a{0}; a<axis_count(); ++a){
+				const auto axis{ axis_of(a) };
+				for(auto id : pending){
+					endpoints[a].push_back(Endpoint{ boxes[id].getMin(axis), id << 1 });
+					endpoints[a].push_back(Endpoint{ boxes[id].getMax(axis), (id << 1) | 1u });
+				}
+				if(!pending.empty()) sort_axis(a);
+			}
+			pending.clear();
+
+			if(mode == Axes::single) sweep();
+		}
+
+		inline
+		auto added_pairs() const -> const std::vector<Pair>& {
+			return added;
+		}
+
+		inline
+		auto removed_pairs() const -> const std::vector<Pair>& {
+			return removed;
+		}
+
+		inline
+		auto pair_count() const -> std::size_t {
+			return pairs.size();
+		}
+
+		inline
+		auto contains_pair(std::uint32_t a, std::uint32_t b) const -> bool {
+			return pairs.count(key(a, b)) != 0;
+		}
+
+		template<typename Func>
+		inline
+		auto for_each_pair(Func&& func) const -> void {
+			for(auto k : pairs){
+				const auto p{ unkey(k) };
+				func(p.a, p.b);
+			}
+		}
+	};
+
+	/**
+	 *  Uniform grid over Vector2/Vector3 points with hashed cell coordinates.
+	 *  build() is a parallel counting sort into one flat index array, there
+	 *  are no per-cell allocations. Cells that collide in the hash table are
+	 *  told apart by recomputing the cell of every candidate point.
+	 */
+	template<int Dim>
+	class Spatial_Hash_Grid {
+		static_assert(Dim == 2 || Dim == 3, "Spatial_Hash_Grid is 2D or 3D");
+
+	public:
+		using Point = typename std::conditional<Dim == 2, Vector2, Vector3>::type;
+
+	private:
+		float cell_size;
+		float inv_cell_size;
+		std::size_t requested_table_size;
+		std::uint32_t table_mask{ 0 };
+		std::vector<std::uint32_t> cell_start;
+		std::vector<std::uint32_t> sorted;
+		std::vector<float> coords;
+		std::vector<std::uint32_t> buckets;
+		std::int32_t cell_lower[3]{ 0, 0, 0 };
+		std::int32_t cell_upper[3]{ -1, -1, -1 };
+
+		/**
+		 *  Clamped to ±2^29 so cell arithmetic around far queries stays in
+		 *  range, the outermost cells take everything beyond.
+		 */
+		inline
+		auto cell_of(float v) const -> std::int32_t {
+			constexpr float limit{ 536870912.f };
+			return static_cast<std::int32_t>(std::min(std::max(std::floor(v*inv_cell_size), -limit), limit));
+		}
+
+		inline
+		auto bucket_of(const std::int32_t* cell) const -> std::uint32_t {
+			auto h{ static_cast<std::uint32_t>(cell[0])*73856093u
+				  ^ static_cast<std::uint32_t>(cell[1])*19349663u };
+			if(Dim == 3) h ^= static_cast<std::uint32_t>(cell[2])*83492791u;
+			return h & table_mask;
+		}
+
+		template<typename Func>
+		inline
+		auto visit_cell(const std::int32_t* cell, Func&& func) const -> void {
+			const auto bucket{ bucket_of(cell) };
+			for(auto n{ cell_start[bucket] }; n<cell_start[bucket+1]; ++n){
+				const auto* p{ &coords[n*Dim] };
+				auto same_cell{ true };
+				for(int a{0}; a<Dim; ++a)
+					same_cell = same_cell && cell_of(p[a]) == cell[a];
+				if(same_cell) func(n, p);
+			}
+		}
+
+		inline
+		auto squared_distance(const float* p, const float* q) const -> float {
+			auto d{ 0.f };
+			for(int a{0}; a<Dim; ++a) d += (p[a]-q[a])*(p[a]-q[a]);
+			return d;
+		}
+
+	public:
+		/**
+		 *  table_size 0 picks the next power of two above the point count.
+		 */
+		inline explicit
+		Spatial_Hash_Grid(float cell_size, std::size_t table_size=0)
+		:cell_size{cell_size}, inv_cell_size{1.f/cell_size},
+		 requested_table_size{table_size}{}
+
+		inline
+		auto build(const Point* points, std::size_t count, unsigned thread_count=0) -> void {
+			std::size_t table_size{ 1 };
+			const auto wanted{ requested_table_size ? requested_table_size : count };
+			while(table_size < wanted) table_size <<= 1;
+			table_mask = static_cast<std::uint32_t>(table_size-1);
+
+			buckets.resize(count);
+			sorted.resize(count);
+			coords.resize(count*Dim);
+			cell_start.assign(table_size+1, 0);
+
+			constexpr std::size_t min_chunk{ 1u << 15 };
+			std::vector<std::vector<std::uint32_t>> histograms(worker_count(thread_count));
+			std::vector<std::array<std::int32_t, 6>> cell_bounds(histograms.size());
+
+			const auto chunks{ parallel_for(count, min_chunk,
+				[&](std::size_t begin, std::size_t end, std::size_t chunk){
+					auto& histogram{ histograms[chunk] };
+					histogram.assign(table_size, 0);
+					auto& bounds{ cell_bounds[chunk] };
+					bounds = { std::numeric_limits<std::int32_t>::max(),
+							   std::numeric_limits<std::int32_t>::max(),
+							   std::numeric_limits<std::int32_t>::max(),
+							   std::numeric_limits<std::int32_t>::min(),
+							   std::numeric_limits<std::int32_t>::min(),
+							   std::numeric_limits<std::int32_t>::min() };
+					for(auto n{begin}; n<end; ++n){
+						std::int32_t cell[3]{ 0, 0, 0 };
+						for(int a{0}; a<Dim; ++a){
+							cell[a] = cell_of(points[n][a]);
+							bounds[a] = std::min(bounds[a], cell[a]);
+							bounds[3+a] = std::max(bounds[3+a], cell[a]);
+						}
+						buckets[n] = bucket_of(cell);
+						++histogram[buckets[n]];
+					}
+				}, thread_count)
+			};
+
+			for(int a{0}; a<3; ++a){
+				cell_lower[a] = a < Dim ? std::numeric_limits<std::int32_t>::max() : 0;
+				cell_upper[a] = a < Dim ? std::numeric_limits<std::int32_t>::min() : 0;
+			}
+			for(std::size_t c{0}; c<chunks; ++c)
+				for(int a{0}; a<Dim; ++a){
+					cell_lower[a] = std::min(cell_lower[a], cell_bounds[c][a]);
+					cell_upper[a] = std::max(cell_upper[a], cell_bounds[c][3+a]);
+				}
+
+			// exclusive scan, afterwards histograms hold each chunk's write offsets
+			std::uint32_t offset{ 0 };
+			for(std::size_t b{0}; b<table_size; ++b){
+				cell_start[b] = offset;
+				for(std::size_t c{0}; c<chunks; ++c){
+					const auto n{ histograms[c][b] };
+					histograms[c][b] = offset;
+					offset += n;
+				}
+			}
+			cell_start[table_size] = offset;
+
+			parallel_for(count, min_chunk,
+				[&](std::size_t begin, std::size_t end, std::size_t chunk){
+					auto& write{ histograms[chunk] };
+					for(auto n{begin}; n<end; ++n){
+						const auto slot{ write[buckets[n]]++ };
+						sorted[slot] = static_cast<std::uint32_t>(n);
+						for(int a{0}; a<Dim; ++a) coords[slot*Dim+a] = points[n][a];
+					}
+				}, thread_count);
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return sorted.size();
+		}
+
+		inline
+		auto getCellSize() const -> float {
+			return cell_size;
+		}
+
+		/**
+		 *  Calls func(index, squared_distance) for every point within radius.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_in_radius(const Point& center, float radius, Func&& func) const
+		-> void {
+			if(sorted.empty()) return;
+			float c[3]{ 0.f, 0.f, 0.f };
+			std::int32_t lo[3]{ 0, 0, 0 }, hi[3]{ 0, 0, 0 };
+			for(int a{0}; a<Dim; ++a){
+				c[a] = center[a];
+				lo[a] = std::max(cell_of(c[a]-radius), cell_lower[a]);
+				hi[a] = std::min(cell_of(c[a]+radius), cell_upper[a]);
+				if(lo[a] > hi[a]) return;
+			}
+
+			const auto r2{ radius*radius };
+			std::int32_t cell[3];
+			for(cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2])
+			for(cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1])
+			for(cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0])
+				visit_cell(cell, [&](std::uint32_t n, const float* p){
+					const auto d{ squared_distance(p, c) };
+					if(d <= r2) func(sorted[n], d);
+				});
+		}
+
+		inline
+		auto query_radius(const Point& center, float radius,
+						  std::vector<std::uint32_t>& out) const -> std::size_t {
+			const auto before{ out.size() };
+			for_each_in_radius(center, radius,
+				[&](std::uint32_t index, float){ out.push_back(index); });
+			return out.size() - before;
+		}
+
+		/**
+		 *  Writes the indices of the k closest points to out, nearest first.
+		 *  Searches rings of cells around the query, from the first ring
+		 *  that reaches an occupied cell until no unvisited cell can hold
+		 *  anything closer than the current k-th neighbour.
+		 */
+		inline
+		auto k_nearest(const Point& center, std::size_t k,
+					   std::vector<std::uint32_t>& out) const -> std::size_t {
+			out.clear();
+			k = std::min(k, sorted.size());
+			if(!k) return 0;
+
+			float c[3]{ 0.f, 0.f, 0.f };
+			std::int32_t home[3]{ 0, 0, 0 };
+			for(int a{0}; a<Dim; ++a){
+				c[a] = center[a];
+				home[a] = cell_of(c[a]);
+			}
+
+			using Candidate = std::pair<float, std::uint32_t>;
+			std::vector<Candidate> heap;
+			heap.reserve(k+1);
+			auto consider{ [&](std::uint32_t n, const float* p){
+				const auto d{ squared_distance(p, c) };
+				if(heap.size() == k && d >= heap.front().first) return;
+				heap.emplace_back(d, sorted[n]);
+				std::push_heap(heap.begin(), heap.end());
+				if(heap.size() > k){
+					std::pop_heap(heap.begin(), heap.end());
+					heap.pop_back();
+				}
+			}};
+
+			// rings that miss every occupied cell are skipped outright
+			std::int32_t first{ 0 };
+			for(int a{0}; a<Dim; ++a)
+				first = std::max({ first, cell_lower[a]-home[a], home[a]-cell_upper[a] });
+
+			for(auto ring{ first };; ++ring){
+				auto covers_all{ true };
+				std::int32_t lo[3]{ 0, 0, 0 }, hi[3]{ 0, 0, 0 };
+				for(int a{0}; a<Dim; ++a){
+					lo[a] = home[a]-ring;
+					hi[a] = home[a]+ring;
+					covers_all = covers_all && lo[a] <= cell_lower[a] && hi[a] >= cell_upper[a];
+				}
+
+				// only the shell of the block is new, clipped to occupied cells
+				std::int32_t from[3]{ 0, 0, 0 }, to[3]{ -1, -1, -1 };
+				auto empty{ false };
+				for(int a{0}; a<Dim; ++a){
+					from[a] = std::max(lo[a], cell_lower[a]);
+					to[a] = std::min(hi[a], cell_upper[a]);
+					empty = empty || from[a] > to[a];
+				}
+				for(int a{Dim}; a<3; ++a) to[a] = 0;
+
+				std::int32_t cell[3];
+				if(!empty)
+				for(cell[2] = from[2]; cell[2] <= to[2]; ++cell[2])
+				for(cell[1] = from[1]; cell[1] <= to[1]; ++cell[1])
+				for(cell[0] = from[0]; cell[0] <= to[0]; ++cell[0]){
+					auto on_shell{ ring == 0 };
+					for(int a{0}; a<Dim; ++a)
+						on_shell = on_shell || cell[a] == lo[a] || cell[a] == hi[a];
+					if(!on_shell){
+						// jump over the already searched interior of the row
+						if(cell[0] > lo[0] && cell[0] < hi[0]) cell[0] = hi[0]-1;
+						continue;
+					}
+					visit_cell(cell, consider);
+				}
+
+				if(covers_all) break;
+				if(heap.size() == k){
+					// closest any point outside the searched block can be
+					auto reach{ inf };
+					for(int a{0}; a<Dim; ++a){
+						reach = std::min(reach, c[a] - lo[a]*cell_size);
+						reach = std::min(reach, (hi[a]+1)*cell_size - c[a]);
+					}
+					if(heap.front().first <= reach*reach) break;
+				}
+			}
+
+			std::sort_heap(heap.begin(), heap.end());
+			for(const auto& candidate : heap) out.push_back(candidate.second);
+			return out.size();
+		}
+	};
+
+	using Spatial_Hash_Grid2 = Spatial_Hash_Grid<2>;
+	using Spatial_Hash_Grid3 = Spatial_Hash_Grid<3>;
+
+	/**
+	 *  Implicit k-d tree over a static Vector3 set. The tree is the point
+	 *  array itself: a range [begin, end) has its splitting point at the
+	 *  middle, children are the two halves. Built in place with
+	 *  nth_element, large subranges are built on their own threads.
+	 */
+	class KD_Tree3 {
+	public:
+		struct Neighbor {
+			std::uint32_t index;
+			float distance;
+		};
+
+		static constexpr std::uint32_t npos{ 0xffffffffu };
+
+	private:
+		std::vector<float> coords;
+		std::vector<std::uint32_t> ids;
+		std::vector<std::uint8_t> axes;
+
+		static constexpr std::size_t leaf_size{ 8 };
+		static constexpr std::size_t parallel_threshold{ 1u << 15 };
+
+		using Candidate = std::pair<float, std::uint32_t>;
+
+		auto build(const Vector3* points, std::size_t begin, std::size_t end,
+				   int parallel_depth) -> void {
+			if(end-begin <= 1) return;
+
+			float lo[3]{ inf, inf, inf }, hi[3]{ -inf, -inf, -inf };
+			for(auto n{begin}; n<end; ++n)
+				for(int a{0}; a<3; ++a){
+					lo[a] = std::min(lo[a], points[ids[n]][a]);
+					hi[a] = std::max(hi[a], points[ids[n]][a]);
+				}
+			std::uint8_t axis{ 0 };
+			for(std::uint8_t a{1}; a<3; ++a)
+				if(hi[a]-lo[a] > hi[axis]-lo[axis]) axis = a;
+
+			const auto mid{ begin + (end-begin)/2 };
+			std::nth_element(ids.begin()+begin, ids.begin()+mid, ids.begin()+end,
+				[&](std::uint32_t l, std::uint32_t r){
+					return points[l][axis] < points[r][axis];
+				});
+			axes[mid] = axis;
+
+			if(parallel_depth > 0 && end-begin >= parallel_threshold){
+				std::thread worker([this, points, begin, mid, parallel_depth]{
+					build(points, begin, mid, parallel_depth-1);
+				});
+				build(points, mid+1, end, parallel_depth-1);
+				worker.join();
+			}
+			else{
+				build(points, begin, mid, 0);
+				build(points, mid+1, end, 0);
+			}
+		}
+
+		inline
+		auto squared_distance(std::size_t n, const float* q) const -> float {
+			const auto* p{ &coords[3*n] };
+			return (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]);
+		}
+
+		/**
+		 *  Visits the near half first, the far half only if the splitting
+		 *  plane is closer than bound() (the current search radius squared).
+		 */
+		template<typename Visit, typename Bound>
+		inline
+		auto search(std::size_t begin, std::size_t end, const float* q,
+					Visit& visit, Bound& bound) const -> void {
+			while(end-begin > leaf_size){
+				const auto mid{ begin + (end-begin)/2 };
+				visit(mid, squared_distance(mid, q));
+
+				const auto axis{ axes[mid] };
+				const auto diff{ q[axis] - coords[3*mid+axis] };
+				const auto near_begin{ diff < 0.f ? begin : mid+1 };
+				const auto near_end{ diff < 0.f ? mid : end };
+				const auto far_begin{ diff < 0.f ? mid+1 : begin };
+				const auto far_end{ diff < 0.f ? end : mid };
+
+				search(near_begin, near_end, q, visit, bound);
+				if(diff*diff > bound()) return;
+				begin = far_begin;
+				end = far_end;
+			}
+			for(auto n{begin}; n<end; ++n) visit(n, squared_distance(n, q));
+		}
+
+	public:
+		inline
+		KD_Tree3() = default;
+
+		inline
+		KD_Tree3(const Vector3* points, std::size_t count, unsigned thread_count=0)
+		:coords(3*count), ids(count), axes(count, 0){
+			for(std::size_t n{0}; n<count; ++n) ids[n] = static_cast<std::uint32_t>(n);
+
+			auto parallel_depth{ 0 };
+			for(auto workers{ worker_count(thread_count) }; workers > 1; workers >>= 1)
+				++parallel_depth;
+			build(points, 0, count, parallel_depth);
+
+			for(std::size_t n{0}; n<count; ++n)
+				for(int a{0}; a<3; ++a) coords[3*n+a] = points[ids[n]][a];
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return ids.size();
+		}
+
+		inline
+		auto nearest(const Vector3& point) const -> Neighbor {
+			const float q[3]{ point.getX(), point.getY(), point.getZ() };
+			auto best_d{ inf };
+			std::size_t best{ ids.size() };
+			auto visit{ [&](std::size_t n, float d){
+				if(d < best_d){ best_d = d; best = n; }
+			}};
+			auto bound{ [&]{ return best_d; } };
+			search(0, ids.size(), q, visit, bound);
+			if(best == ids.size()) return Neighbor{ npos, inf };
+			return Neighbor{ ids[best], sqrtf(best_d) };
+		}
+
+		/**
+		 *  Writes up to k neighbors to out, nearest first, returns the count.
+		 */
+		inline
+		auto k_nearest(const Vector3& point, std::size_t k, Neighbor* out) const
+		-> std::size_t {
+			const float q[3]{ point.getX(), point.getY(), point.getZ() };
+			k = std::min(k, ids.size());
+			if(!k) return 0;
+
+			Candidate local[32];
+			std::vector<Candidate> spill;
+			auto* heap{ local };
+			if(k+1 > 32){
+				spill.resize(k+1);
+				heap = spill.data();
+			}
+			std::size_t heap_size{ 0 };
+
+			auto visit{ [&](std::size_t n, float d){
+				if(heap_size == k){
+					if(d >= heap[0].first) return;
+					std::pop_heap(heap, heap+heap_size);
+					--heap_size;
+				}
+				heap[heap_size++] = Candidate{ d, static_cast<std::uint32_t>(n) };
+				std::push_heap(heap, heap+heap_size);
+			}};
+			auto bound{ [&]{ return heap_size == k ? heap[0].first : inf; } };
+			search(0, ids.size(), q, visit, bound);
+
+			std::sort_heap(heap, heap+heap_size);
+			for(std::size_t n{0}; n<heap_size; ++n)
+				out[n] = Neighbor{ ids[heap[n].second], sqrtf(heap[n].first) };
+			return heap_size;
+		}
+
+		inline
+		auto k_nearest(const Vector3& point, std::size_t k, std::vector<Neighbor>& out) const
+		-> std::size_t {
+			out.resize(std::min(k, ids.size()));
+			return k_nearest(point, k, out.data());
+		}
+
+		/**
+		 *  Calls func(index, squared_distance) for every point within radius.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_in_radius(const Vector3& point, float radius, Func&& func) const
+		-> void {
+			const float q[3]{ point.getX(), point.getY(), point.getZ() };
+			const auto r2{ radius*radius };
+			auto visit{ [&](std::size_t n, float d){
+				if(d <= r2) func(ids[n], d);
+			}};
+			auto bound{ [r2]{ return r2; } };
+			search(0, ids.size(), q, visit, bound);
+		}
+
+		inline
+		auto query_radius(const Vector3& point, float radius,
+						  std::vector<std::uint32_t>& out) const -> std::size_t {
+			const auto before{ out.size() };
+			for_each_in_radius(point, radius,
+				[&](std::uint32_t index, float){ out.push_back(index); });
+			return out.size() - before;
+		}
+
+		inline
+		auto nearest_batch(const Vector3* queries, std::size_t count, Neighbor* out,
+						   unsigned thread_count=0) const -> void {
+			parallel_for(count, 256, [&](std::size_t begin, std::size_t end, std::size_t){
+				for(auto n{begin}; n<end; ++n) out[n] = nearest(queries[n]);
+			}, thread_count);
+		}
+
+		/**
+		 *  out holds k entries per query, counts (optional) the number found.
+		 */
+		inline
+		auto k_nearest_batch(const Vector3* queries, std::size_t count, std::size_t k,
+							 Neighbor* out, std::size_t* counts=nullptr,
+							 unsigned thread_count=0) const -> void {
+			parallel_for(count, 64, [&](std::size_t begin, std::size_t end, std::size_t){
+				for(auto n{begin}; n<end; ++n){
+					const auto found{ k_nearest(queries[n], k, out+n*k) };
+					if(counts) counts[n] = found;
+				}
+			}, thread_count);
+		}
+
+		inline
+		auto radius_batch(const Vector3* queries, std::size_t count, float radius,
+						  std::vector<std::vector<std::uint32_t>>& out,
+						  unsigned thread_count=0) const -> void {
+			out.resize(count);
+			parallel_for(count, 64, [&](std::size_t begin, std::size_t end, std::size_t){
+				for(auto n{begin}; n<end; ++n){
+					out[n].clear();
+					query_radius(queries[n], radius, out[n]);
+				}
+			}, thread_count);
+		}
+	};
+
+	/**
+	 *  Result of testing a box against a query volume. inside lets tree
+	 *  queries report a whole subtree without testing its objects.
+	 */
+	enum class Containment { outside, intersects, inside };
+
+	/**
+	 *  Loose quadtree (Dim 2, over Rect) or loose octree (Dim 3, over AABB3)
+	 *  with a fixed world box. Node bounds are doubled, so an object goes
+	 *  to the depth its size allows and to the cell holding its center;
+	 *  both are computed directly, without descending from the root.
+	 *  Nodes and objects live in pooled arrays with free lists.
+	 */
+	template<int Dim>
+	class Loose_Tree {
+		static_assert(Dim == 2 || Dim == 3, "Loose_Tree is a quadtree or an octree");
+
+		static constexpr int child_count{ 1 << Dim };
+		static constexpr std::int32_t null_node{ -1 };
+
+		struct Node {
+			float center[3];
+			float half;
+			std::int32_t parent;
+			std::int32_t children[child_count];
+			std::int32_t first;
+			std::uint32_t count;
+			std::int32_t depth;
+			std::int32_t cell[3];
+		};
+
+		struct Object {
+			AABB3 box;
+			std::int32_t node;
+			std::int32_t next;
+			std::int32_t prev;
+		};
+
+		AABB3 world;
+		float world_half;
+		int max_depth;
+		std::vector<Node> nodes;
+		std::vector<std::int32_t> free_nodes;
+		std::vector<Object> objects;
+		std::vector<std::int32_t> free_objects;
+		std::size_t object_count{ 0 };
+
+		auto allocate_node(std::int32_t parent, int child) -> std::int32_t {
+			std::int32_t index;
+			if(!free_nodes.empty()){
+				index = free_nodes.back();
+				free_nodes.pop_back();
+			}
+			else{
+				index = static_cast<std::int32_t>(nodes.size());
+				nodes.emplace_back();
+			}
+
+			auto& node{ nodes[index] };
+			node.parent = parent;
+			for(auto& c : node.children) c = null_node;
+			node.first = null_node;
+			node.count = 0;
+			if(parent == null_node){
+				node.depth = 0;
+				node.half = world_half;
+				for(int a{0}; a<3; ++a){
+					node.center[a] = world.getMin(a) + world_half;
+					node.cell[a] = 0;
+				}
+				return index;
+			}
+
+			const auto& up{ nodes[parent] };
+			node.depth = up.depth+1;
+			node.half = up.half*0.5f;
+			for(int a{0}; a<3; ++a){
+				const auto bit{ a < Dim ? (child >> a) & 1 : 0 };
+				node.center[a] = a < Dim ? up.center[a] + (bit ? node.half : -node.half) : 0.f;
+				node.cell[a] = up.cell[a]*2 + bit;
+			}
+			return index;
+		}
+
+		inline
+		auto loose_bounds(const Node& node) const -> AABB3 {
+			if(node.parent == null_node)
+				return AABB3(Vector3(-inf, -inf, -inf), Vector3(inf, inf, inf));
+			const auto l{ 2.f*node.half };
+			return AABB3(
+				Vector3(node.center[0]-l, node.center[1]-l, Dim == 3 ? node.center[2]-l : 0.f),
+				Vector3(node.center[0]+l, node.center[1]+l, Dim == 3 ? node.center[2]+l : 0.f)
+			);
+		}
+
+		/**
+		 *  Deepest level whose cells are at least as wide as the box, and the
+		 *  cell there that holds the box center. Centers outside the world
+		 *  go to the root, which has unbounded loose bounds.
+		 */
+		auto place(const AABB3& box, std::int32_t* cell) const -> int {
+			auto extent{ 0.f };
+			auto outside{ false };
+			float center[3];
+			for(int a{0}; a<Dim; ++a){
+				extent = std::max(extent, box.getMax(a)-box.getMin(a));
+				center[a] = 0.5f*(box.getMin(a)+box.getMax(a));
+				outside = outside || center[a] < world.getMin(a) || center[a] > world.getMax(a);
+			}
+			for(int a{0}; a<3; ++a) cell[a] = 0;
+			if(outside) return 0;
+
+			int depth{ 0 };
+			auto half{ world_half };
+			while(depth < max_depth && extent <= half){
+				half *= 0.5f;
+				++depth;
+			}
+
+			const auto cells{ std::int32_t{1} << depth };
+			for(int a{0}; a<Dim; ++a){
+				const auto c{ static_cast<std::int32_t>((center[a]-world.getMin(a)) / (2.f*half)) };
+				cell[a] = std::min(std::max(c, std::int32_t{0}), cells-1);
+			}
+			return depth;
+		}
+
+		auto link(std::int32_t id, int depth, const std::int32_t* cell) -> void {
+			auto index{ std::int32_t{0} };
+			++nodes[0].count;
+			for(int level{1}; level<=depth; ++level){
+				int child{ 0 };
+				for(int a{0}; a<Dim; ++a)
+					child |= ((cell[a] >> (depth-level)) & 1) << a;
+				if(nodes[index].children[child] == null_node){
+					const auto created{ allocate_node(index, child) };
+					nodes[index].children[child] = created;
+				}
+				index = nodes[index].children[child];
+				++nodes[index].count;
+			}
+
+			auto& object{ objects[id] };
+			object.node = index;
+			object.prev = null_node;
+			object.next = nodes[index].first;
+			if(object.next != null_node) objects[object.next].prev = id;
+			nodes[index].first = id;
+		}
+
+		auto unlink(std::int32_t id) -> void {
+			auto& object{ objects[id] };
+			if(object.prev != null_node) objects[object.prev].next = object.next;
+			else nodes[object.node].first = object.next;
+			if(object.next != null_node) objects[object.next].prev = object.prev;
+
+			// release the branch once nothing is left below it
+			auto index{ object.node };
+			while(index != null_node){
+				const auto parent{ nodes[index].parent };
+				if(--nodes[index].count == 0 && parent != null_node){
+					for(auto& c : nodes[parent].children)
+						if(c == index) c = null_node;
+					free_nodes.push_back(index);
+				}
+				index = parent;
+			}
+		}
+
+		template<typename Classify, typename Func>
+		auto traverse(Classify& classify, Func& func) const -> void {
+			std::int32_t stack[128];
+			std::vector<std::int32_t> overflow;
+			int top{ 0 };
+			stack[top++] = 0;
+			while(top || !overflow.empty()){
+				std::int32_t index;
+				if(!overflow.empty()){ index = overflow.back(); overflow.pop_back(); }
+				else index = stack[--top];
+
+				const auto& node{ nodes[index] };
+				const auto state{ classify(loose_bounds(node)) };
+				if(state == Containment::outside) continue;
+				if(state == Containment::inside){
+					report_subtree(index, func);
+					continue;
+				}
+
+				for(auto id{ node.first }; id != null_node; id = objects[id].next)
+					if(classify(objects[id].box) != Containment::outside)
+						func(static_cast<std::uint32_t>(id));
+				for(auto c : node.children){
+					if(c == null_node) continue;
+					if(top < 128) stack[top++] = c;
+					else overflow.push_back(c);
+				}
+			}
+		}
+
+		template<typename Func>
+		auto report_subtree(std::int32_t index, Func& func) const -> void {
+			const auto& node{ nodes[index] };
+			for(auto id{ node.first }; id != null_node; id = objects[id].next)
+				func(static_cast<std::uint32_t>(id));
+			for(auto c : node.children)
+				if(c != null_node) report_subtree(c, func);
+		}
+
+	public:
+		/**
+		 *  max_depth bounds the levels below the root, 2^max_depth cells per axis.
+		 */
+		inline
+		Loose_Tree(const AABB3& world, int max_depth=8)
+		:world{world}, world_half{0.f}, max_depth{max_depth}{
+			for(int a{0}; a<Dim; ++a)
+				world_half = std::max(world_half, 0.5f*(world.getMax(a)-world.getMin(a)));
+			allocate_node(null_node, 0);
+		}
+
+		inline
+		Loose_Tree(const Rect& world, int max_depth=8)
+		:Loose_Tree(AABB3(world), max_depth){
+			static_assert(Dim == 2, "Rect worlds need a Loose_Tree<2>");
+		}
+
+		inline
+		auto insert(const AABB3& box) -> std::uint32_t {
+			std::int32_t id;
+			if(!free_objects.empty()){
+				id = free_objects.back();
+				free_objects.pop_back();
+			}
+			else{
+				id = static_cast<std::int32_t>(objects.size());
+				objects.emplace_back();
+			}
+			objects[id].box = box;
+
+			std::int32_t cell[3];
+			const auto depth{ place(box, cell) };
+			link(id, depth, cell);
+			++object_count;
+			return static_cast<std::uint32_t>(id);
+		}
+
+		inline
+		auto insert(const Rect& rect) -> std::uint32_t {
+			static_assert(Dim == 2, "Rect objects need a Loose_Tree<2>");
+			return insert(AABB3(rect));
+		}
+
+		/**
+		 *  Returns true when the object stayed in its node, the common case
+		 *  for small movements, which then only stores the new box.
+		 */
+		inline
+		auto update(std::uint32_t id, const AABB3& box) -> bool {
+			auto& object{ objects[id] };
+			object.box = box;
+
+			std::int32_t cell[3];
+			const auto depth{ place(box, cell) };
+			const auto& node{ nodes[object.node] };
+			auto same{ node.depth == depth };
+			for(int a{0}; a<Dim; ++a) same = same && node.cell[a] == cell[a];
+			if(same) return true;
+
+			unlink(static_cast<std::int32_t>(id));
+			link(static_cast<std::int32_t>(id), depth, cell);
+			return false;
+		}
+
+		inline
+		auto update(std::uint32_t id, const Rect& rect) -> bool {
+			static_assert(Dim == 2, "Rect objects need a Loose_Tree<2>");
+			return update(id, AABB3(rect));
+		}
+
+		inline
+		auto remove(std::uint32_t id) -> void {
+			unlink(static_cast<std::int32_t>(id));
+			objects[id].node = null_node;
+			free_objects.push_back(static_cast<std::int32_t>(id));
+			--object_count;
+		}
+
+		inline
+		auto getBounds(std::uint32_t id) const -> const AABB3& {
+			return objects[id].box;
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return object_count;
+		}
+
+		inline
+		auto node_count() const -> std::size_t {
+			return nodes.size() - free_nodes.size();
+		}
+
+		/**
+		 *  classify(const AABB3&) -> Containment is called on loose node bounds
+		 *  and on object boxes, func(id) for every object not outside.
+		 */
+		template<typename Classify, typename Func>
+		inline
+		auto for_each_classified(Classify&& classify, Func&& func) const -> void {
+			traverse(classify, func);
+		}
+
+		template<typename Func>
+		inline
+		auto for_each_overlap(const AABB3& box, Func&& func) const -> void {
+			auto classify{ [&box](const AABB3& bounds){
+				if(!bounds.intersects(box)) return Containment::outside;
+				return box.contains(bounds) ? Containment::inside : Containment::intersects;
+			}};
+			traverse(classify, func);
+		}
+
+		template<typename Func>
+		inline
+		auto for_each_overlap(const Rect& rect, Func&& func) const -> void {
+			static_assert(Dim == 2, "Rect queries need a Loose_Tree<2>");
+			for_each_overlap(AABB3(rect), func);
+		}
+
+		/**
+		 *  Objects whose box touches the circle (Dim 2) or sphere (Dim 3).
+		 */
+		template<typename Func>
+		inline
+		auto for_each_in_radius(const Vector3& center, float radius, Func&& func) const
+		-> void {
+			const auto r2{ radius*radius };
+			auto classify{ [&](const AABB3& bounds){
+				auto closest{ 0.f }, farthest{ 0.f };
+				for(int a{0}; a<Dim; ++a){
+					const auto lo{ bounds.getMin(a) - center[a] };
+					const auto hi{ center[a] - bounds.getMax(a) };
+					const auto d{ std::max(std::max(lo, hi), 0.f) };
+					closest += d*d;
+					const auto f{ std::max(std::fabs(lo), std::fabs(hi)) };
+					farthest += f*f;
+				}
+				if(closest > r2) return Containment::outside;
+				return farthest <= r2 ? Containment::inside : Containment::intersects;
+			}};
+			traverse(classify, func);
+		}
+
+		template<typename Func>
+		inline
+		auto for_each_in_radius(const Vector2& center, float radius, Func&& func) const
+		-> void {
+			static_assert(Dim == 2, "circle queries need a Loose_Tree<2>");
+			for_each_in_radius(Vector3(center.getX(), center.getY(), 0.f), radius, func);
+		}
+
+		template<typename Query>
+		inline
+		auto query(const Query& region, std::vector<std::uint32_t>& out) const -> std::size_t {
+			const auto before{ out.size() };
+			for_each_overlap(region, [&](std::uint32_t id){ out.push_back(id); });
+			return out.size() - before;
+		}
+	};
+
+	using Loose_Quadtree = Loose_Tree<2>;
+	using Loose_Octree = Loose_Tree<3>;
+
+	/**
+	 *  Morton (Z-order) codes. 2D interleaves two 32 bit coordinates,
+	 *  3D three 21 bit coordinates, x always lands in the lowest bit.
+	 */
+	inline
+	auto morton_encode(std::uint32_t x, std::uint32_t y) -> std::uint64_t {
+	#if defined(__BMI2__)
+		return _pdep_u64(x, 0x5555555555555555ull) | _pdep_u64(y, 0xaaaaaaaaaaaaaaaaull);
+	#else
+		auto spread{ [](std::uint64_t v){
+			v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+			v = (v | (v << 8))  & 0x00ff00ff00ff00ffull;
+			v = (v | (v << 4))  & 0x0f0f0f0f0f0f0f0full;
+			v = (v | (v << 2))  & 0x3333333333333333ull;
+			v = (v | (v << 1))  & 0x5555555555555555ull;
+			return v;
+		}};
+		return spread(x) | (spread(y) << 1);
+	#endif
+	}
+
+	inline
+	auto morton_encode(std::uint32_t x, std::uint32_t y, std::uint32_t z) -> std::uint64_t {
+	#if defined(__BMI2__)
+		return _pdep_u64(x, 0x1249249249249249ull)
+			 | _pdep_u64(y, 0x2492492492492492ull)
+			 | _pdep_u64(z, 0x4924924924924924ull);
+	#else
+		auto spread{ [](std::uint64_t v){
+			v &= 0x1fffff;
+			v = (v | (v << 32)) & 0x001f00000000ffffull;
+			v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+			v = (v | (v << 8))  & 0x100f00f00f00f00full;
+			v = (v | (v << 4))  & 0x10c30c30c30c30c3ull;
+			v = (v | (v << 2))  & 0x1249249249249249ull;
+			return v;
+		}};
+		return spread(x) | (spread(y) << 1) | (spread(z) << 2);
+	#endif
+	}
+
+	inline
+	auto morton_decode(std::uint64_t code, std::uint32_t& x, std::uint32_t& y) -> void {
+	#if defined(__BMI2__)
+		x = static_cast<std::uint32_t>(_pext_u64(code, 0x5555555555555555ull));
+		y = static_cast<std::uint32_t>(_pext_u64(code, 0xaaaaaaaaaaaaaaaaull));
+	#else
+		auto compact{ [](std::uint64_t v){
+			v &= 0x5555555555555555ull;
+			v = (v ^ (v >> 1))  & 0x3333333333333333ull;
+			v = (v ^ (v >> 2))  & 0x0f0f0f0f0f0f0f0full;
+			v = (v ^ (v >> 4))  & 0x00ff00ff00ff00ffull;
+			v = (v ^ (v >> 8))  & 0x0000ffff0000ffffull;
+			v = (v ^ (v >> 16)) & 0x00000000ffffffffull;
+			return static_cast<std::uint32_t>(v);
+		}};
+		x = compact(code);
+		y = compact(code >> 1);
+	#endif
+	}
+
+	inline
+	auto morton_decode(std::uint64_t code, std::uint32_t& x, std::uint32_t& y,
+					   std::uint32_t& z) -> void {
+	#if defined(__BMI2__)
+		x = static_cast<std::uint32_t>(_pext_u64(code, 0x1249249249249249ull));
+		y = static_cast<std::uint32_t>(_pext_u64(code, 0x2492492492492492ull));
+		z = static_cast<std::uint32_t>(_pext_u64(code, 0x4924924924924924ull));
+	#else
+		auto compact{ [](std::uint64_t v){
+			v &= 0x1249249249249249ull;
+			v = (v ^ (v >> 2))  & 0x10c30c30c30c30c3ull;
+			v = (v ^ (v >> 4))  & 0x100f00f00f00f00full;
+			v = (v ^ (v >> 8))  & 0x001f0000ff0000ffull;
+			v = (v ^ (v >> 16)) & 0x001f00000000ffffull;
+			v = (v ^ (v >> 32)) & 0x00000000001fffffull;
+			return static_cast<std::uint32_t>(v);
+		}};
+		x = compact(code);
+		y = compact(code >> 1);
+		z = compact(code >> 2);
+	#endif
+	}
+
+	/**
+	 *  Maps v from [lower, upper] onto the integers [0, 2^bits - 1].
+	 */
+	inline
+	auto quantize(float v, float lower, float upper, int bits) -> std::uint32_t {
+		const auto top{ static_cast<double>((std::uint64_t{1} << bits) - 1) };
+		const auto range{ static_cast<double>(upper) - lower };
+		auto t{ range > 0.0 ? (static_cast<double>(v) - lower) / range : 0.0 };
+		t = std::min(std::max(t, 0.0), 1.0);
+		return static_cast<std::uint32_t>(t*top + 0.5);
+	}
+
+	inline
+	auto morton_code(const Vector2& p, const Rect& bounds) -> std::uint64_t {
+		return morton_encode(
+			quantize(p.getX(), bounds.getXMin(), bounds.getXMax(), 32),
+			quantize(p.getY(), bounds.getYMin(), bounds.getYMax(), 32)
+		);
+	}
+
+	inline
+	auto morton_code(const Vector3& p, const AABB3& bounds) -> std::uint64_t {
+		return morton_encode(
+			quantize(p.getX(), bounds.getMin(0), bounds.getMax(0), 21),
+			quantize(p.getY(), bounds.getMin(1), bounds.getMax(1), 21),
+			quantize(p.getZ(), bounds.getMin(2), bounds.getMax(2), 21)
+		);
+	}
+
+	/**
+	 *  Hilbert index of a cell on a 2^bits grid per axis, via Skilling's
+	 *  transpose: axes are turned into the transposed index in place, then
+	 *  interleaved with the first axis in the most significant position.
+	 */
+	template<int Dim>
+	inline
+	auto hilbert_transpose(std::uint32_t* axes, int bits) -> std::uint64_t {
+		const auto top{ std::uint32_t{1} << (bits-1) };
+		for(auto q{ top }; q > 1; q >>= 1){
+			const auto p{ q-1 };
+			for(int a{0}; a<Dim; ++a){
+				if(axes[a] & q) axes[0] ^= p;
+				else{
+					const auto t{ (axes[0] ^ axes[a]) & p };
+					axes[0] ^= t;
+					axes[a] ^= t;
+				}
+			}
+		}
+		for(int a{1}; a<Dim; ++a) axes[a] ^= axes[a-1];
+		std::uint32_t t{ 0 };
+		for(auto q{ top }; q > 1; q >>= 1)
+			if(axes[Dim-1] & q) t ^= q-1;
+		for(int a{0}; a<Dim; ++a) axes[a] ^= t;
+
+		std::uint64_t index{ 0 };
+		for(auto bit{ bits-1 }; bit >= 0; --bit)
+			for(int a{0}; a<Dim; ++a)
+				index = (index << 1) | ((axes[a] >> bit) & 1u);
+		return index;
+	}
+
+	inline
+	auto hilbert_index(std::uint32_t x, std::uint32_t y, int bits=32) -> std::uint64_t {
+		std::uint32_t axes[2]{ x, y };
+		return hilbert_transpose<2>(axes, bits);
+	}
+
+	inline
+	auto hilbert_index(std::uint32_t x, std::uint32_t y, std::uint32_t z, int bits=21)
+	-> std::uint64_t {
+		std::uint32_t axes[3]{ x, y, z };
+		return hilbert_transpose<3>(axes, bits);
+	}
+
+	inline
+	auto hilbert_index(const Vector2& p, const Rect& bounds, int bits=16) -> std::uint64_t {
+		return hilbert_index(
+			quantize(p.getX(), bounds.getXMin(), bounds.getXMax(), bits),
+			quantize(p.getY(), bounds.getYMin(), bounds.getYMax(), bits),
+			bits
+		);
+	}
+
+	inline
+	auto hilbert_index(const Vector3& p, const AABB3& bounds, int bits=21) -> std::uint64_t {
+		return hilbert_index(
+			quantize(p.getX(), bounds.getMin(0), bounds.getMax(0), bits),
+			quantize(p.getY(), bounds.getMin(1), bounds.getMax(1), bits),
+			quantize(p.getZ(), bounds.getMin(2), bounds.getMax(2), bits),
+			bits
+		);
+	}
+
+	/**
+	 *  LSD radix sort on 8 bit digits, writes the stable sorting permutation
+	 *  of keys to order. All histograms are built in one pass and digits
+	 *  that are the same for every key are skipped.
+	 */
+	inline
+	auto radix_sort(const std::uint64_t* keys, std::size_t count, std::uint32_t* order) -> void {
+		std::vector<std::uint64_t> key_buffer(keys, keys+count), key_scratch(count);
+		std::vector<std::uint32_t> scratch(count);
+		for(std::size_t n{0}; n<count; ++n) order[n] = static_cast<std::uint32_t>(n);
+
+		std::vector<std::array<std::size_t, 256>> histograms(8);
+		for(auto& h : histograms) h.fill(0);
+		for(std::size_t n{0}; n<count; ++n)
+			for(int d{0}; d<8; ++d) ++histograms[d][(keys[n] >> (8*d)) & 0xff];
+
+		auto* source_keys{ key_buffer.data() };
+		auto* target_keys{ key_scratch.data() };
+		auto* source{ order };
+		auto* target{ scratch.data() };
+		for(int d{0}; d<8; ++d){
+			auto& h{ histograms[d] };
+			if(std::find(h.begin(), h.end(), count) != h.end()) continue;
+
+			std::size_t offset{ 0 };
+			for(auto& bucket : h){
+				const auto n{ bucket };
+				bucket = offset;
+				offset += n;
+			}
+			for(std::size_t n{0}; n<count; ++n){
+				const auto slot{ h[(source_keys[n] >> (8*d)) & 0xff]++ };
+				target_keys[slot] = source_keys[n];
+				target[slot] = source[n];
+			}
+			std::swap(source_keys, target_keys);
+			std::swap(source, target);
+		}
+		if(source != order) std::copy(source, source+count, order);
+	}
+
+	/**
+	 *  Applies a permutation from radix_sort to any number of arrays,
+	 *  array[n] becomes array[order[n]].
+	 */
+	template<typename... Arrays>
+	inline
+	auto reorder(const std::uint32_t* order, std::size_t count, Arrays*... arrays) -> void {
+		auto apply{ [order, count](auto* array){
+			using T = typename std::remove_pointer<decltype(array)>::type;
+			std::vector<T> copy(array, array+count);
+			for(std::size_t n{0}; n<count; ++n) array[n] = copy[order[n]];
+		}};
+		(apply(arrays), ...);
+	}
+
+	/**
+	 *  Sorting permutation of points along the Morton curve over their bounds.
+	 */
+	inline
+	auto morton_order(const Vector3* points, std::size_t count, std::uint32_t* order) -> void {
+		const auto bounds{ compute_bounds(points, count) };
+		std::vector<std::uint64_t> keys(count);
+		for(std::size_t n{0}; n<count; ++n) keys[n] = morton_code(points[n], bounds);
+		radix_sort(keys.data(), count, order);
+	}
+
+	inline
+	auto morton_order(const Vector2* points, std::size_t count, std::uint32_t* order) -> void {
+		const auto bounds{ compute_bounds(points, count) };
+		std::vector<std::uint64_t> keys(count);
+		for(std::size_t n{0}; n<count; ++n) keys[n] = morton_code(points[n], bounds);
+		radix_sort(keys.data(), count, order);
+	}
+
+	/**
+	 *  Slab test kernel shared by the ray and box packets. Every lane holds
+	 *  one ray/box pair, bit l of the result is set when lane l hits and
+	 *  t_enter[l] is its entry fraction (inf on a miss). The comparisons
+	 *  are ordered so the NaN of a ray lying in a slab plane is ignored.
+	 */
+	template<int Width, int Dim>
+	inline
+	auto slab_lanes(const float (&lower)[3][Width], const float (&upper)[3][Width],
+					const float (&origin)[3][Width], const float (&inv_dir)[3][Width],
+					const float (&t_max)[Width], float* t_enter) -> std::uint32_t {
+		float enter[Width], exit[Width];
+		for(int l{0}; l<Width; ++l){
+			enter[l] = 0.f;
+			exit[l] = t_max[l];
+		}
+		for(int a{0}; a<Dim; ++a)
+			for(int l{0}; l<Width; ++l){
+				const auto t0{ (lower[a][l]-origin[a][l])*inv_dir[a][l] };
+				const auto t1{ (upper[a][l]-origin[a][l])*inv_dir[a][l] };
+				const auto lo{ t1 < t0 ? t1 : t0 };
+				const auto hi{ t1 > t0 ? t1 : t0 };
+				enter[l] = lo > enter[l] ? lo : enter[l];
+				exit[l] = hi < exit[l] ? hi : exit[l];
+			}
+
+		std::uint32_t mask{ 0 };
+		for(int l{0}; l<Width; ++l){
+			const auto hit{ enter[l] <= exit[l] };
+			t_enter[l] = hit ? enter[l] : inf;
+			mask |= static_cast<std::uint32_t>(hit) << l;
+		}
+		return mask;
+	}
+
+	/**
+	 *  Width segments (from + t*(to-from), t in [0, 1]) in SoA layout with
+	 *  precomputed inverse directions. Unused lanes never hit.
+	 */
+	template<int Width, int Dim=3>
+	class Ray_Packet {
+		static_assert(Width == 4 || Width == 8 || Width == 16, "packets are 4, 8 or 16 wide");
+		static_assert(Dim == 2 || Dim == 3, "Ray_Packet is 2D or 3D");
+
+		float origin[3][Width];
+		float inv_dir[3][Width];
+		float t_max[Width];
+
+		inline
+		auto set_lane(int l, const float* from, const float* dir) -> void {
+			for(int a{0}; a<3; ++a){
+				origin[a][l] = from[a];
+				inv_dir[a][l] = 1.f/dir[a];
+			}
+			t_max[l] = 1.f;
+		}
+
+		inline
+		auto against(const float* lower, const float* upper, float* t_enter) const
+		-> std::uint32_t {
+			float lo[3][Width], hi[3][Width];
+			for(int a{0}; a<3; ++a)
+				for(int l{0}; l<Width; ++l){
+					lo[a][l] = lower[a];
+					hi[a][l] = upper[a];
+				}
+			return slab_lanes<Width, Dim>(lo, hi, origin, inv_dir, t_max, t_enter);
+		}
+
+	public:
+		static constexpr int width{ Width };
+
+		inline
+		Ray_Packet(){
+			for(int a{0}; a<3; ++a)
+				for(int l{0}; l<Width; ++l){
+					origin[a][l] = 0.f;
+					inv_dir[a][l] = inf;
+				}
+			for(auto& t : t_max) t = -1.f;
+		}
+
+		inline
+		Ray_Packet(const Line3* rays, std::size_t count)
+		:Ray_Packet(){
+			static_assert(Dim == 3, "Line3 rays need a 3D packet");
+			for(std::size_t l{0}; l<std::min<std::size_t>(count, Width); ++l){
+				const auto dir{ rays[l].getDir() };
+				const float from[3]{ rays[l].getFrom().getX(), rays[l].getFrom().getY(),
+									 rays[l].getFrom().getZ() };
+				const float d[3]{ dir.getX(), dir.getY(), dir.getZ() };
+				set_lane(static_cast<int>(l), from, d);
+			}
+		}
+
+		inline
+		Ray_Packet(const Line2* rays, std::size_t count)
+		:Ray_Packet(){
+			static_assert(Dim == 2, "Line2 rays need a 2D packet");
+			for(std::size_t l{0}; l<std::min<std::size_t>(count, Width); ++l){
+				const auto dir{ rays[l].asVec2() };
+				const float from[3]{ rays[l].getFrom().getX(), rays[l].getFrom().getY(), 0.f };
+				const float d[3]{ dir.getX(), dir.getY(), 1.f };
+				set_lane(static_cast<int>(l), from, d);
+			}
+		}
+
+		/**
+		 *  All rays against one box, t_enter must hold Width floats.
+		 */
+		inline
+		auto intersect(const AABB3& box, float* t_enter) const -> std::uint32_t {
+			const float lower[3]{ box.getMin(0), box.getMin(1), box.getMin(2) };
+			const float upper[3]{ box.getMax(0), box.getMax(1), box.getMax(2) };
+			return against(lower, upper, t_enter);
+		}
+
+		inline
+		auto intersect(const Rect& rect, float* t_enter) const -> std::uint32_t {
+			static_assert(Dim == 2, "Rect targets need a 2D packet");
+			return intersect(AABB3(rect), t_enter);
+		}
+	};
+
+	/**
+	 *  Width boxes in SoA layout for testing one ray against many boxes.
+	 *  Unused lanes never hit.
+	 */
+	template<int Width, int Dim=3>
+	class Box_Packet {
+		static_assert(Width == 4 || Width == 8 || Width == 16, "packets are 4, 8 or 16 wide");
+		static_assert(Dim == 2 || Dim == 3, "Box_Packet is 2D or 3D");
+
+		float lower[3][Width];
+		float upper[3][Width];
+		std::uint32_t used;
+
+		static constexpr
+		auto lane_mask(std::size_t count) -> std::uint32_t {
+			return count >= Width ? ~0u >> (32-Width) : (1u << count)-1;
+		}
+
+	public:
+		static constexpr int width{ Width };
+
+		inline
+		Box_Packet()
+		:used{ 0 }{
+			for(int a{0}; a<3; ++a)
+				for(int l{0}; l<Width; ++l){
+					lower[a][l] = inf;
+					upper[a][l] = -inf;
+				}
+		}
+
+		inline
+		Box_Packet(const AABB3* boxes, std::size_t count)
+		:Box_Packet(){
+			used = lane_mask(count);
+			for(std::size_t l{0}; l<std::min<std::size_t>(count, Width); ++l)
+				for(int a{0}; a<3; ++a){
+					lower[a][l] = boxes[l].getMin(a);
+					upper[a][l] = boxes[l].getMax(a);
+				}
+		}
+
+		inline
+		Box_Packet(const Rect* rects, std::size_t count)
+		:Box_Packet(){
+			static_assert(Dim == 2, "Rect boxes need a 2D packet");
+			used = lane_mask(count);
+			for(std::size_t l{0}; l<std::min<std::size_t>(count, Width); ++l){
+				lower[0][l] = rects[l].getXMin();
+				lower[1][l] = rects[l].getYMin();
+				upper[0][l] = rects[l].getXMax();
+				upper[1][l] = rects[l].getYMax();
+			}
+		}
+
+		inline
+		auto intersect(const Line3& ray, float* t_enter) const -> std::uint32_t {
+			static_assert(Dim == 3, "Line3 rays need a 3D packet");
+			const auto dir{ ray.getDir() };
+			const float from[3]{ ray.getFrom().getX(), ray.getFrom().getY(), ray.getFrom().getZ() };
+			const float d[3]{ dir.getX(), dir.getY(), dir.getZ() };
+			return against(from, d, t_enter);
+		}
+
+		inline
+		auto intersect(const Line2& ray, float* t_enter) const -> std::uint32_t {
+			static_assert(Dim == 2, "Line2 rays need a 2D packet");
+			const auto dir{ ray.asVec2() };
+			const float from[3]{ ray.getFrom().getX(), ray.getFrom().getY(), 0.f };
+			const float d[3]{ dir.getX(), dir.getY(), 1.f };
+			return against(from, d, t_enter);
+		}
+
+	private:
+		inline
+		auto against(const float* from, const float* dir, float* t_enter) const
+		-> std::uint32_t {
+			float origin[3][Width], inv_dir[3][Width], t_max[Width];
+			for(int a{0}; a<3; ++a){
+				const auto inv{ 1.f/dir[a] };
+				for(int l{0}; l<Width; ++l){
+					origin[a][l] = from[a];
+					inv_dir[a][l] = inv;
+				}
+			}
+			for(auto& t : t_max) t = 1.f;
+			// the empty boxes padding a packet span every slab, drop them here
+			const auto mask{ slab_lanes<Width, Dim>(lower, upper, origin, inv_dir, t_max, t_enter) & used };
+			for(int l{0}; l<Width; ++l)
+				if(!((used >> l) & 1u)) t_enter[l] = inf;
+			return mask;
+		}
+	};
+
+	/**
+	 *  count rays against one box, Width at a time. masks gets one entry
+	 *  per packet (bit l is ray packet*Width+l), t_enter one per ray.
+	 *  Returns the number of rays that hit.
+	 */
+	template<int Width=8, typename Ray, typename Box>
+	inline
+	auto raycast_batch(const Ray* rays, std::size_t count, const Box& box,
+					   std::uint32_t* masks, float* t_enter) -> std::size_t {
+		constexpr int dim{ std::is_same<Ray, Line2>::value ? 2 : 3 };
+		std::size_t hits{ 0 };
+		float lane_t[Width];
+		for(std::size_t n{0}; n<count; n += Width){
+			const auto lanes{ std::min<std::size_t>(Width, count-n) };
+			const auto mask{ Ray_Packet<Width, dim>(rays+n, lanes).intersect(box, lane_t) };
+			masks[n/Width] = mask;
+			std::copy(lane_t, lane_t+lanes, t_enter+n);
+			for(auto m{mask}; m; m &= m-1) ++hits;
+		}
+		return hits;
+	}
+
+	/**
+	 *  One ray against count boxes, same output layout as above.
+	 */
+	template<int Width=8, typename Ray, typename Box>
+	inline
+	auto raycast_batch(const Ray& ray, const Box* boxes, std::size_t count,
+					   std::uint32_t* masks, float* t_enter) -> std::size_t {
+		constexpr int dim{ std::is_same<Ray, Line2>::value ? 2 : 3 };
+		std::size_t hits{ 0 };
+		float lane_t[Width];
+		for(std::size_t n{0}; n<count; n += Width){
+			const auto lanes{ std::min<std::size_t>(Width, count-n) };
+			const auto mask{ Box_Packet<Width, dim>(boxes+n, lanes).intersect(ray, lane_t) };
+			masks[n/Width] = mask;
+			std::copy(lane_t, lane_t+lanes, t_enter+n);
+			for(auto m{mask}; m; m &= m-1) ++hits;
+		}
+		return hits;
+	}
+
+	/**
+	 *  Plane in Hessian normal form, dot(normal, p) + d = 0 with a unit
+	 *  normal. Points with a positive signed distance are in front.
+	 */
+	class Normal_Plane3 {
+		Vector3 normal;
+		float d;
+
+	public:
+		inline
+		Normal_Plane3()
+		:normal{0.f, 0.f, 1.f}, d{0.f}{}
+
+		/**
+		 *  Takes the unnormalised equation a*x + b*y + c*z + w = 0.
+		 */
+		inline
+		Normal_Plane3(float a, float b, float c, float w)
+		:normal{a, b, c}, d{w}{
+			const auto length{ sqrtf(a*a + b*b + c*c) };
+			if(length > 0.f){
+				normal.set(a/length, b/length, c/length);
+				d = w/length;
+			}
+		}
+
+		inline
+		Normal_Plane3(const Vector3& normal, const Vector3& point)
+		:Normal_Plane3(normal.getX(), normal.getY(), normal.getZ(), 0.f){
+			d = -this->normal.dot_prod(point);
+		}
+
+		inline explicit
+		Normal_Plane3(const Plane3& plane)
+		:Normal_Plane3(plane.getNormal(), plane.getPosition()){}
+
+		inline
+		auto getNormal() const -> const Vector3& {
+			return normal;
+		}
+
+		inline
+		auto getD() const -> float {
+			return d;
+		}
+
+		inline
+		auto signed_distance(const Vector3& p) const -> float {
+			return normal.getX()*p.getX() + normal.getY()*p.getY() + normal.getZ()*p.getZ() + d;
+		}
+
+		inline
+		auto project(const Vector3& p) const -> Vector3 {
+			return p - normal*signed_distance(p);
+		}
+
+		/**
+		 *  inside means the box lies entirely in front of the plane.
+		 */
+		inline
+		auto classify(const AABB3& box) const -> Containment {
+			const auto c{ box.getCenter() };
+			const auto e{ box.getExtents() };
+			const auto dist{ signed_distance(c) };
+			const auto radius{ std::fabs(normal.getX())*e.getX()
+							 + std::fabs(normal.getY())*e.getY()
+							 + std::fabs(normal.getZ())*e.getZ() };
+			if(dist < -radius) return Containment::outside;
+			return dist >= radius ? Containment::inside : Containment::intersects;
+		}
+	};
+
+	inline
+	auto operator<<(std::ostream& os, const Normal_Plane3& p) -> std::ostream& {
+		return os << "[Normal: " << p.getNormal() << " D: " << p.getD() << " ]";
+	}
+
+	/**
+	 *  Six inward facing planes: left, right, bottom, top, near, far.
+	 */
+	class Frustum {
+		Normal_Plane3 planes[6];
+
+		template<typename Func>
+		inline
+		auto report_subtree(const Bvh3& bvh, std::uint32_t node, Func& func) const -> void {
+			const auto& nodes{ bvh.nodes() };
+			if(nodes[node].isLeaf()){
+				for(auto n{ nodes[node].first }; n<nodes[node].first+nodes[node].count; ++n)
+					func(bvh.indices()[n]);
+				return;
+			}
+			report_subtree(bvh, nodes[node].first, func);
+			report_subtree(bvh, nodes[node].first+1, func);
+		}
+
+		inline
+		auto classify(const AABB3& box, std::uint32_t& mask) const -> Containment {
+			for(int p{0}; p<6; ++p){
+				if(!(mask & (1u << p))) continue;
+				const auto state{ planes[p].classify(box) };
+				if(state == Containment::outside) return Containment::outside;
+				if(state == Containment::inside) mask &= ~(1u << p);
+			}
+			return mask ? Containment::intersects : Containment::inside;
+		}
+
+	public:
+		enum Side { left, right, bottom, top, near_side, far_side };
+
+		inline
+		Frustum() = default;
+
+		inline
+		Frustum(const Normal_Plane3& left, const Normal_Plane3& right,
+				const Normal_Plane3& bottom, const Normal_Plane3& top,
+				const Normal_Plane3& near_plane, const Normal_Plane3& far_plane)
+		:planes{ left, right, bottom, top, near_plane, far_plane }{}
+
+		/**
+		 *  Gribb-Hartmann extraction from a column major view-projection
+		 *  matrix (m[column][row]). zero_to_one selects a [0, w] clip depth
+		 *  instead of the OpenGL [-w, w].
+		 */
+		static inline
+		auto from_matrix(const Matrix_4x4& m, bool zero_to_one=false) -> Frustum {
+			auto combine{ [&m](float s, int r){
+				return Normal_Plane3(
+					m[0][3] + s*m[0][r], m[1][3] + s*m[1][r],
+					m[2][3] + s*m[2][r], m[3][3] + s*m[3][r]
+				);
+			}};
+			const auto near_plane{ zero_to_one
+				? Normal_Plane3(m[0][2], m[1][2], m[2][2], m[3][2])
+				: combine(1.f, 2) };
+			return Frustum(combine(1.f, 0), combine(-1.f, 0), combine(1.f, 1),
+						   combine(-1.f, 1), near_plane, combine(-1.f, 2));
+		}
+
+		inline
+		auto getPlane(int side) const -> const Normal_Plane3& {
+			return planes[side];
+		}
+
+		inline
+		auto contains(const Vector3& p) const -> bool {
+			for(const auto& plane : planes)
+				if(plane.signed_distance(p) < 0.f) return false;
+			return true;
+		}
+
+		inline
+		auto intersects(const Vector3& center, float radius) const -> bool {
+			for(const auto& plane : planes)
+				if(plane.signed_distance(center) < -radius) return false;
+			return true;
+		}
+
+		inline
+		auto classify(const AABB3& box) const -> Containment {
+			std::uint32_t mask{ 0x3f };
+			return classify(box, mask);
+		}
+
+		inline
+		auto intersects(const AABB3& box) const -> bool {
+			return classify(box) != Containment::outside;
+		}
+
+		/**
+		 *  Sphere culling over SoA arrays. Bit n%32 of masks[n/32] is set
+		 *  when sphere n is (possibly) visible. Returns the visible count.
+		 */
+		inline
+		auto cull_spheres(const float* xs, const float* ys, const float* zs,
+						  const float* radii, std::size_t count, std::uint32_t* masks,
+						  unsigned thread_count=0) const -> std::size_t {
+			std::atomic<std::size_t> visible{ 0 };
+			parallel_for((count+31)/32, 512, [&](std::size_t begin, std::size_t end, std::size_t){
+				std::size_t local{ 0 };
+				for(auto word{begin}; word<end; ++word){
+					const auto base{ word*32 };
+					const auto lanes{ std::min<std::size_t>(32, count-base) };
+					float margin[32];
+					for(std::size_t l{0}; l<32; ++l) margin[l] = inf;
+					for(const auto& plane : planes){
+						const auto nx{ plane.getNormal().getX() }, ny{ plane.getNormal().getY() };
+						const auto nz{ plane.getNormal().getZ() }, d{ plane.getD() };
+						for(std::size_t l{0}; l<lanes; ++l){
+							const auto dist{ nx*xs[base+l] + ny*ys[base+l] + nz*zs[base+l] + d + radii[base+l] };
+							margin[l] = dist < margin[l] ? dist : margin[l];
+						}
+					}
+					std::uint32_t mask{ 0 };
+					for(std::size_t l{0}; l<lanes; ++l)
+						mask |= static_cast<std::uint32_t>(margin[l] >= 0.f) << l;
+					masks[word] = mask;
+					for(auto m{mask}; m; m &= m-1) ++local;
+				}
+				visible += local;
+			}, thread_count);
+			return visible;
+		}
+
+		/**
+		 *  Box culling over SoA center/extent arrays, same mask layout.
+		 */
+		inline
+		auto cull_boxes(const float* cx, const float* cy, const float* cz,
+						const float* ex, const float* ey, const float* ez,
+						std::size_t count, std::uint32_t* masks,
+						unsigned thread_count=0) const -> std::size_t {
+			std::atomic<std::size_t> visible{ 0 };
+			parallel_for((count+31)/32, 512, [&](std::size_t begin, std::size_t end, std::size_t){
+				std::size_t local{ 0 };
+				for(auto word{begin}; word<end; ++word){
+					const auto base{ word*32 };
+					const auto lanes{ std::min<std::size_t>(32, count-base) };
+					float margin[32];
+					for(std::size_t l{0}; l<32; ++l) margin[l] = inf;
+					for(const auto& plane : planes){
+						const auto nx{ plane.getNormal().getX() }, ny{ plane.getNormal().getY() };
+						const auto nz{ plane.getNormal().getZ() }, d{ plane.getD() };
+						const auto ax{ std::fabs(nx) }, ay{ std::fabs(ny) }, az{ std::fabs(nz) };
+						for(std::size_t l{0}; l<lanes; ++l){
+							const auto dist{ nx*cx[base+l] + ny*cy[base+l] + nz*cz[base+l] + d
+										   + ax*ex[base+l] + ay*ey[base+l] + az*ez[base+l] };
+							margin[l] = dist < margin[l] ? dist : margin[l];
+						}
+					}
+					std::uint32_t mask{ 0 };
+					for(std::size_t l{0}; l<lanes; ++l)
+						mask |= static_cast<std::uint32_t>(margin[l] >= 0.f) << l;
+					masks[word] = mask;
+					for(auto m{mask}; m; m &= m-1) ++local;
+				}
+				visible += local;
+			}, thread_count);
+			return visible;
+		}
+
+		inline
+		auto cull_boxes(const AABB3* boxes, std::size_t count, std::uint32_t* masks,
+						unsigned thread_count=0) const -> std::size_t {
+			std::vector<float> soa(6*count);
+			for(std::size_t n{0}; n<count; ++n)
+				for(int a{0}; a<3; ++a){
+					soa[a*count+n] = 0.5f*(boxes[n].getMin(a)+boxes[n].getMax(a));
+					soa[(3+a)*count+n] = 0.5f*(boxes[n].getMax(a)-boxes[n].getMin(a));
+				}
+			const auto* s{ soa.data() };
+			return cull_boxes(s, s+count, s+2*count, s+3*count, s+4*count, s+5*count,
+							  count, masks, thread_count);
+		}
+
+		/**
+		 *  Calls func(index) for every Bvh3 primitive whose box is visible.
+		 *  Planes a node lies fully in front of are skipped for its subtree.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_visible(const Bvh3& bvh, Func&& func) const -> void {
+			if(!bvh.size()) return;
+			const auto& nodes{ bvh.nodes() };
+			const auto& boxes{ bvh.leaf_bounds() };
+
+			std::pair<std::uint32_t, std::uint32_t> stack[128];
+			int top{ 0 };
+			stack[top++] = { 0, 0x3f };
+			while(top){
+				auto [index, mask] = stack[--top];
+				const auto& node{ nodes[index] };
+				const auto state{ classify(node.bounds(), mask) };
+				if(state == Containment::outside) continue;
+				if(state == Containment::inside){
+					report_subtree(bvh, index, func);
+					continue;
+				}
+				if(node.isLeaf()){
+					for(auto n{node.first}; n<node.first+node.count; ++n){
+						auto leaf_mask{ mask };
+						if(classify(boxes[n], leaf_mask) != Containment::outside)
+							func(bvh.indices()[n]);
+					}
+					continue;
+				}
+				stack[top++] = { node.first+1, mask };
+				stack[top++] = { node.first, mask };
+			}
+		}
+
+		/**
+		 *  Calls func(id) for every Loose_Octree object whose box is visible.
+		 */
+		template<typename Func>
+		inline
+		auto for_each_visible(const Loose_Octree& tree, Func&& func) const -> void {
+			tree.for_each_classified(
+				[this](const AABB3& box){ return classify(box); }, func);
+		}
+	};
+
+	inline
+	auto operator<<(std::ostream& os, const Frustum& f) -> std::ostream& {
+		os << "[Frustum:";
+		for(int p{0}; p<6; ++p) os << " " << f.getPlane(p);
+		return os << " ]";
+	}
+
+	/**
+	 *  Closest triangle hit, index is npos on a miss. The hit point is
+	 *  (1-u-v)*v0 + u*v1 + v*v2, fraction is measured along the segment.
+	 */
+	struct Triangle_Hit {
+		static constexpr std::uint32_t npos{ 0xffffffffu };
+
+		std::uint32_t index{ npos };
+		float fraction{ inf };
+		float u{ 0.f };
+		float v{ 0.f };
+	};
+
+	/**
+	 *  Eight triangles in SoA layout (first vertex and two edges), tested
+	 *  against one segment in a fixed width lane loop. Unused lanes have
+	 *  zero edges, which the determinant test rejects.
+	 */
+	class Triangle_Block {
+	public:
+		static constexpr int width{ 8 };
+
+	private:
+		float origin[3][width];
+		float edge1[3][width];
+		float edge2[3][width];
+		std::uint32_t ids[width];
+
+	public:
+		inline
+		Triangle_Block(){
+			for(int a{0}; a<3; ++a)
+				for(int l{0}; l<width; ++l)
+					origin[a][l] = edge1[a][l] = edge2[a][l] = 0.f;
+			for(auto& id : ids) id = Triangle_Hit::npos;
+		}
+
+		inline
+		auto set(int lane, const Vector3& v0, const Vector3& v1, const Vector3& v2,
+				 std::uint32_t id) -> void {
+			for(int a{0}; a<3; ++a){
+				origin[a][lane] = v0[a];
+				edge1[a][lane] = v1[a]-v0[a];
+				edge2[a][lane] = v2[a]-v0[a];
+			}
+			ids[lane] = id;
+		}
+
+		inline
+		auto bounds() const -> AABB3 {
+			auto box{ AABB3::empty() };
+			for(int l{0}; l<width; ++l){
+				if(ids[l] == Triangle_Hit::npos) continue;
+				const auto v0{ Vector3(origin[0][l], origin[1][l], origin[2][l]) };
+				box._merge(AABB3(v0, v0));
+				box._merge(AABB3(v0+Vector3(edge1[0][l], edge1[1][l], edge1[2][l]),
+								 v0+Vector3(edge1[0][l], edge1[1][l], edge1[2][l])));
+				box._merge(AABB3(v0+Vector3(edge2[0][l], edge2[1][l], edge2[2][l]),
+								 v0+Vector3(edge2[0][l], edge2[1][l], edge2[2][l])));
+			}
+			return box;
+		}
+
+		/**
+		 *  Updates hit if a lane is hit closer than hit.fraction.
+		 */
+		inline
+		auto intersect(const float* o, const float* d, Triangle_Hit& hit) const -> bool {
+			float t[width], u[width], v[width];
+			for(int l{0}; l<width; ++l){
+				const auto px{ d[1]*edge2[2][l] - d[2]*edge2[1][l] };
+				const auto py{ d[2]*edge2[0][l] - d[0]*edge2[2][l] };
+				const auto pz{ d[0]*edge2[1][l] - d[1]*edge2[0][l] };
+				const auto det{ edge1[0][l]*px + edge1[1][l]*py + edge1[2][l]*pz };
+				const auto inv{ det == 0.f ? 0.f : 1.f/det };
+
+				const auto sx{ o[0]-origin[0][l] }, sy{ o[1]-origin[1][l] }, sz{ o[2]-origin[2][l] };
+				u[l] = (sx*px + sy*py + sz*pz)*inv;
+				const auto qx{ sy*edge1[2][l] - sz*edge1[1][l] };
+				const auto qy{ sz*edge1[0][l] - sx*edge1[2][l] };
+				const auto qz{ sx*edge1[1][l] - sy*edge1[0][l] };
+				v[l] = (d[0]*qx + d[1]*qy + d[2]*qz)*inv;
+				t[l] = (edge2[0][l]*qx + edge2[1][l]*qy + edge2[2][l]*qz)*inv;
+
+				const auto valid{ inv != 0.f && u[l] >= 0.f && v[l] >= 0.f
+							   && u[l]+v[l] <= 1.f && t[l] >= 0.f && t[l] <= 1.f };
+				t[l] = valid ? t[l] : inf;
+			}
+
+			auto best{ -1 };
+			for(int l{0}; l<width; ++l)
+				if(t[l] < hit.fraction || (t[l] == hit.fraction && t[l] != inf && hit.index == Triangle_Hit::npos)){
+					hit.fraction = t[l];
+					best = l;
+				}
+			if(best < 0) return false;
+			hit.index = ids[best];
+			hit.u = u[best];
+			hit.v = v[best];
+			return true;
+		}
+
+		inline
+		auto intersect(const Line3& line, Triangle_Hit& hit) const -> bool {
+			const auto dir{ line.getDir() };
+			const float o[3]{ line.getFrom().getX(), line.getFrom().getY(), line.getFrom().getZ() };
+			const float d[3]{ dir.getX(), dir.getY(), dir.getZ() };
+			return intersect(o, d, hit);
+		}
+	};
+
+	/**
+	 *  Static indexed triangle mesh for raycasts. Triangles are sorted along
+	 *  the Morton curve of their centroids and packed into Triangle_Blocks,
+	 *  a Bvh3 over the block bounds finds the blocks a segment can hit.
+	 */
+	class Triangle_Mesh {
+		std::vector<Triangle_Block> blocks;
+		Bvh3 bvh;
+		std::size_t triangle_count{ 0 };
+
+	public:
+		inline
+		Triangle_Mesh() = default;
+
+		/**
+		 *  indices holds three vertex indices per triangle.
+		 */
+		inline
+		Triangle_Mesh(const Vector3* vertices, const std::uint32_t* indices,
+					  std::size_t triangles, unsigned thread_count=0)
+		:triangle_count{triangles}{
+			std::vector<Vector3> centroids;
+			centroids.reserve(triangles);
+			for(std::size_t n{0}; n<triangles; ++n){
+				const auto& v0{ vertices[indices[3*n]] };
+				const auto& v1{ vertices[indices[3*n+1]] };
+				const auto& v2{ vertices[indices[3*n+2]] };
+				centroids.push_back((v0+v1+v2)*(1.f/3.f));
+			}
+			std::vector<std::uint32_t> order(triangles);
+			morton_order(centroids.data(), triangles, order.data());
+
+			blocks.resize((triangles+Triangle_Block::width-1)/Triangle_Block::width);
+			for(std::size_t n{0}; n<triangles; ++n){
+				const auto t{ order[n] };
+				blocks[n/Triangle_Block::width].set(
+					static_cast<int>(n%Triangle_Block::width),
+					vertices[indices[3*t]], vertices[indices[3*t+1]], vertices[indices[3*t+2]], t
+				);
+			}
+
+			std::vector<AABB3> bounds;
+			bounds.reserve(blocks.size());
+			for(const auto& block : blocks) bounds.push_back(block.bounds());
+			bvh = Bvh3(bounds.data(), bounds.size(), thread_count);
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return triangle_count;
+		}
+
+		inline
+		auto raycast(const Line3& line) const -> Triangle_Hit {
+			const auto dir{ line.getDir() };
+			const float o[3]{ line.getFrom().getX(), line.getFrom().getY(), line.getFrom().getZ() };
+			const float d[3]{ dir.getX(), dir.getY(), dir.getZ() };
+
+			Triangle_Hit hit;
+			hit.fraction = 1.f;
+			bvh.raycast(line, [&](std::uint32_t block, float){
+				return blocks[block].intersect(o, d, hit) ? hit.fraction : inf;
+			});
+			if(hit.index == Triangle_Hit::npos) hit.fraction = inf;
+			return hit;
+		}
+
+		inline
+		auto raycast_batch(const Line3* lines, std::size_t count, Triangle_Hit* out,
+						   unsigned thread_count=0) const -> void {
+			parallel_for(count, 64, [&](std::size_t begin, std::size_t end, std::size_t){
+				for(auto n{begin}; n<end; ++n) out[n] = raycast(lines[n]);
+			}, thread_count);
+		}
+	};
+
+	class Sphere {
+		Vector3 center;
+		float radius;
+
+	public:
+		inline
+		Sphere(const Vector3& center, float radius)
+		:center{center}, radius{radius}{}
+
+		inline
+		auto getCenter() const -> const Vector3& {
+			return center;
+		}
+
+		inline
+		auto getRadius() const -> float {
+			return radius;
+		}
+
+		inline
+		auto getBounds() const -> AABB3 {
+			return AABB3(center, center).expanded(radius);
+		}
+
+		inline
+		auto contains(const Vector3& p) const -> bool {
+			return (p-center).squared_length() <= radius*radius;
+		}
+	};
+
+	inline
+	auto operator<<(std::ostream& os, const Sphere& s) -> std::ostream& {
+		return os << "[Center: " << s.getCenter() << " Radius: " << s.getRadius() << " ]";
+	}
+
+	/**
+	 *  Segment swept by a sphere.
+	 */
+	class Capsule {
+		Line3 segment;
+		float radius;
+
+	public:
+		inline
+		Capsule(const Vector3& from, const Vector3& to, float radius)
+		:segment{from, to}, radius{radius}{}
+
+		inline
+		Capsule(const Line3& segment, float radius)
+		:segment{segment}, radius{radius}{}
+
+		inline
+		auto getSegment() const -> const Line3& {
+			return segment;
+		}
+
+		inline
+		auto getRadius() const -> float {
+			return radius;
+		}
+
+		inline
+		auto getBounds() const -> AABB3 {
+			return AABB3(segment.getFrom(), segment.getFrom())
+				.merged(segment.getTo()).expanded(radius);
+		}
+
+		inline
+		auto contains(const Vector3& p) const -> bool {
+			return segment.squared_distance(p) <= radius*radius;
+		}
+	};
+
+	inline
+	auto operator<<(std::ostream& os, const Capsule& c) -> std::ostream& {
+		return os << "[From: " << c.getSegment().getFrom() << " To: " << c.getSegment().getTo()
+				  << " Radius: " << c.getRadius() << " ]";
+	}
+
+	/**
+	 *  Oriented box, the columns of orientation are its unit local axes.
+	 */
+	class OBB {
+		Vector3 center;
+		Matrix_3x3 orientation;
+		Vector3 half_extents;
+
+	public:
+		inline
+		OBB(const Vector3& center, const Matrix_3x3& orientation, const Vector3& half_extents)
+		:center{center}, orientation{orientation}, half_extents{half_extents}{}
+
+		inline explicit
+		OBB(const AABB3& box)
+		:center{box.getCenter()}, orientation{Matrix_3x3::identity()},
+		 half_extents{box.getExtents()}{}
+
+		inline
+		auto getCenter() const -> const Vector3& {
+			return center;
+		}
+
+		inline
+		auto getOrientation() const -> const Matrix_3x3& {
+			return orientation;
+		}
+
+		inline
+		auto getHalfExtents() const -> const Vector3& {
+			return half_extents;
+		}
+
+		inline
+		auto getAxis(int axis) const -> const Vector3& {
+			return orientation[axis];
+		}
+
+		/**
+		 *  p in box space, where the box is centered on the origin.
+		 */
+		inline
+		auto to_local(const Vector3& p) const -> Vector3 {
+			const auto d{ p-center };
+			return Vector3(d.dot_prod(orientation[0]), d.dot_prod(orientation[1]),
+						   d.dot_prod(orientation[2]));
+		}
+
+		inline
+		auto closest_point(const Vector3& p) const -> Vector3 {
+			const auto local{ to_local(p) };
+			auto result{ center };
+			for(int a{0}; a<3; ++a){
+				const auto v{ std::min(std::max(local[a], -half_extents[a]), half_extents[a]) };
+				result = result + orientation[a]*v;
+			}
+			return result;
+		}
+
+		inline
+		auto squared_distance(const Vector3& p) const -> float {
+			const auto local{ to_local(p) };
+			auto d{ 0.f };
+			for(int a{0}; a<3; ++a){
+				const auto excess{ std::max(std::fabs(local[a]) - half_extents[a], 0.f) };
+				d += excess*excess;
+			}
+			return d;
+		}
+
+		inline
+		auto contains(const Vector3& p) const -> bool {
+			const auto local{ to_local(p) };
+			for(int a{0}; a<3; ++a)
+				if(std::fabs(local[a]) > half_extents[a]) return false;
+			return true;
+		}
+
+		inline
+		auto getBounds() const -> AABB3 {
+			float extent[3];
+			for(int r{0}; r<3; ++r){
+				extent[r] = 0.f;
+				for(int c{0}; c<3; ++c) extent[r] += std::fabs(orientation[c][r])*half_extents[c];
+			}
+			return AABB3(center - Vector3(extent[0], extent[1], extent[2]),
+						 center + Vector3(extent[0], extent[1], extent[2]));
+		}
+	};
+
+	inline
+	auto operator<<(std::ostream& os, const OBB& b) -> std::ostream& {
+		return os << "[Center: " << b.getCenter() << " Half extents: " << b.getHalfExtents() << " ]";
+	}
+
+	inline
+	auto intersects(const Sphere& a, const Sphere& b) -> bool {
+		const auto r{ a.getRadius() + b.getRadius() };
+		return (a.getCenter()-b.getCenter()).squared_length() <= r*r;
+	}
+
+	inline
+	auto intersects(const Sphere& s, const Capsule& c) -> bool {
+		const auto r{ s.getRadius() + c.getRadius() };
+		return c.getSegment().squared_distance(s.getCenter()) <= r*r;
+	}
+
+	inline
+	auto intersects(const Sphere& s, const OBB& b) -> bool {
+		return b.squared_distance(s.getCenter()) <= s.getRadius()*s.getRadius();
+	}
+
+	inline
+	auto intersects(const Capsule& a, const Capsule& b) -> bool {
+		const auto r{ a.getRadius() + b.getRadius() };
+		return a.getSegment().squared_distance(b.getSegment()) <= r*r;
+	}
+
+	/**
+	 *  Segment against the box, exact slab test in box space.
+	 */
+	inline
+	auto intersects(const Line3& line, const OBB& b) -> bool {
+		const auto from{ b.to_local(line.getFrom()) };
+		const auto to{ b.to_local(line.getTo()) };
+		auto enter{ 0.f }, exit{ 1.f };
+		for(int a{0}; a<3; ++a){
+			const auto d{ to[a]-from[a] };
+			const auto e{ b.getHalfExtents()[a] };
+			if(d == 0.f){
+				if(std::fabs(from[a]) > e) return false;
+				continue;
+			}
+			const auto t0{ (-e-from[a])/d };
+			const auto t1{ (e-from[a])/d };
+			enter = std::max(enter, std::min(t0, t1));
+			exit = std::min(exit, std::max(t0, t1));
+			if(enter > exit) return false;
+		}
+		return true;
+	}
+
+	/**
+	 *  The distance from the box to a point moving along the segment is
+	 *  convex, so after the cheap rejections its minimum is found with a
+	 *  golden section search.
+	 */
+	inline
+	auto intersects(const Capsule& c, const OBB& b) -> bool {
+		const auto& segment{ c.getSegment() };
+		const auto r2{ c.getRadius()*c.getRadius() };
+		if(intersects(segment, b)) return true;
+		if(!intersects(segment, OBB(b.getCenter(), b.getOrientation(),
+				b.getHalfExtents() + Vector3(c.getRadius(), c.getRadius(), c.getRadius()))))
+			return false;
+
+		const auto from{ segment.getFrom() };
+		const auto dir{ segment.getDir() };
+		auto distance{ [&](float t){ return b.squared_distance(from + dir*t); } };
+		if(distance(0.f) <= r2 || distance(1.f) <= r2) return true;
+
+		constexpr auto ratio{ 0.6180339887f };
+		auto lo{ 0.f }, hi{ 1.f };
+		auto x1{ hi - ratio*(hi-lo) }, x2{ lo + ratio*(hi-lo) };
+		auto f1{ distance(x1) }, f2{ distance(x2) };
+		for(int n{0}; n<40 && std::min(f1, f2) > r2; ++n){
+			if(f1 < f2){
+				hi = x2; x2 = x1; f2 = f1;
+				x1 = hi - ratio*(hi-lo);
+				f1 = distance(x1);
+			}
+			else{
+				lo = x1; x1 = x2; f1 = f2;
+				x2 = lo + ratio*(hi-lo);
+				f2 = distance(x2);
+			}
+		}
+		return std::min(f1, f2) <= r2;
+	}
+
+	/**
+	 *  Separating axis test over the 15 candidate axes (Ericson, RTCD 4.4.1).
+	 */
+	inline
+	auto intersects(const OBB& a, const OBB& b) -> bool {
+		constexpr auto eps{ 1e-6f };
+		float R[3][3], abs_R[3][3], t[3];
+		const auto d{ b.getCenter()-a.getCenter() };
+		for(int i{0}; i<3; ++i){
+			t[i] = d.dot_prod(a.getAxis(i));
+			for(int j{0}; j<3; ++j){
+				R[i][j] = a.getAxis(i).dot_prod(b.getAxis(j));
+				abs_R[i][j] = std::fabs(R[i][j]) + eps;
+			}
+		}
+		const auto& ea{ a.getHalfExtents() };
+		const auto& eb{ b.getHalfExtents() };
+
+		for(int i{0}; i<3; ++i){
+			const auto rb{ eb[0]*abs_R[i][0] + eb[1]*abs_R[i][1] + eb[2]*abs_R[i][2] };
+			if(std::fabs(t[i]) > ea[i] + rb) return false;
+		}
+		for(int j{0}; j<3; ++j){
+			const auto ra{ ea[0]*abs_R[0][j] + ea[1]*abs_R[1][j] + ea[2]*abs_R[2][j] };
+			if(std::fabs(t[0]*R[0][j] + t[1]*R[1][j] + t[2]*R[2][j]) > ra + eb[j]) return false;
+		}
+		for(int i{0}; i<3; ++i){
+			const auto i1{ (i+1)%3 }, i2{ (i+2)%3 };
+			for(int j{0}; j<3; ++j){
+				const auto j1{ (j+1)%3 }, j2{ (j+2)%3 };
+				const auto ra{ ea[i1]*abs_R[i2][j] + ea[i2]*abs_R[i1][j] };
+				const auto rb{ eb[j1]*abs_R[i][j2] + eb[j2]*abs_R[i][j1] };
+				if(std::fabs(t[i2]*R[i1][j] - t[i1]*R[i2][j]) > ra + rb) return false;
+			}
+		}
+		return true;
+	}
+
+	inline
+	auto intersects(const Line3& line, const Sphere& s) -> bool {
+		return line.squared_distance(s.getCenter()) <= s.getRadius()*s.getRadius();
+	}
+
+	inline
+	auto intersects(const Line3& line, const Capsule& c) -> bool {
+		return line.squared_distance(c.getSegment()) <= c.getRadius()*c.getRadius();
+	}
+
+	inline
+	auto intersects(const Capsule& c, const Sphere& s) -> bool {
+		return intersects(s, c);
+	}
+
+	inline
+	auto intersects(const OBB& b, const Sphere& s) -> bool {
+		return intersects(s, b);
+	}
+
+	inline
+	auto intersects(const OBB& b, const Capsule& c) -> bool {
+		return intersects(c, b);
+	}
+
+	/**
+	 *  One query shape against count shapes. Bit n%32 of masks[n/32] is
+	 *  set when shape n overlaps the query, returns the overlap count.
+	 */
+	template<typename Query, typename Shape>
+	inline
+	auto intersects_batch(const Query& query, const Shape* shapes, std::size_t count,
+						  std::uint32_t* masks) -> std::size_t {
+		std::size_t hits{ 0 };
+		for(std::size_t word{0}; word*32<count; ++word){
+			const auto base{ word*32 };
+			const auto lanes{ std::min<std::size_t>(32, count-base) };
+			std::uint32_t mask{ 0 };
+			for(std::size_t l{0}; l<lanes; ++l)
+				mask |= static_cast<std::uint32_t>(intersects(query, shapes[base+l])) << l;
+			masks[word] = mask;
+			for(auto m{mask}; m; m &= m-1) ++hits;
+		}
+		return hits;
+	}
+
+	/**
+	 *  Segment (a shot) against count capsules stored as SoA arrays: segment
+	 *  starts, segment directions and radii. The closest point computation
+	 *  is written branch free so the lane loop vectorises.
+	 */
+	inline
+	auto intersects_batch(const Line3& shot, const float* from_x, const float* from_y,
+						  const float* from_z, const float* dir_x, const float* dir_y,
+						  const float* dir_z, const float* radii, std::size_t count,
+						  std::uint32_t* masks) -> std::size_t {
+		constexpr auto eps{ std::numeric_limits<float>::epsilon() };
+		const auto p{ shot.getFrom() };
+		const auto d{ shot.getDir() };
+		const auto px{ p.getX() }, py{ p.getY() }, pz{ p.getZ() };
+		const auto dx{ d.getX() }, dy{ d.getY() }, dz{ d.getZ() };
+		const auto sq1{ std::max(dx*dx + dy*dy + dz*dz, eps) };
+
+		std::size_t hits{ 0 };
+		for(std::size_t word{0}; word*32<count; ++word){
+			const auto base{ word*32 };
+			const auto lanes{ std::min<std::size_t>(32, count-base) };
+			float dist[32];
+			for(std::size_t l{0}; l<lanes; ++l){
+				const auto n{ base+l };
+				const auto ex{ dir_x[n] }, ey{ dir_y[n] }, ez{ dir_z[n] };
+				const auto rx{ px-from_x[n] }, ry{ py-from_y[n] }, rz{ pz-from_z[n] };
+				const auto sq2{ std::max(ex*ex + ey*ey + ez*ez, eps) };
+				const auto b{ dx*ex + dy*ey + dz*ez };
+				const auto c{ dx*rx + dy*ry + dz*rz };
+				const auto f{ ex*rx + ey*ry + ez*rz };
+				const auto denom{ sq1*sq2 - b*b };
+
+				auto s{ denom > eps*sq1*sq2 ? (b*f - c*sq2)/denom : 0.f };
+				s = s < 0.f ? 0.f : (s > 1.f ? 1.f : s);
+				auto t{ (b*s + f)/sq2 };
+				const auto s_low{ -c/sq1 }, s_high{ (b-c)/sq1 };
+				s = t < 0.f ? s_low : (t > 1.f ? s_high : s);
+				s = s < 0.f ? 0.f : (s > 1.f ? 1.f : s);
+				t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+
+				const auto wx{ rx + dx*s - ex*t };
+				const auto wy{ ry + dy*s - ey*t };
+				const auto wz{ rz + dz*s - ez*t };
+				dist[l] = wx*wx + wy*wy + wz*wz - radii[n]*radii[n];
+			}
+			std::uint32_t mask{ 0 };
+			for(std::size_t l{0}; l<lanes; ++l)
+				mask |= static_cast<std::uint32_t>(dist[l] <= 0.f) << l;
+			masks[word] = mask;
+			for(auto m{mask}; m; m &= m-1) ++hits;
+		}
+		return hits;
+	}
+
+	/**
+	 *  Support mapping over a borrowed point cloud, the convex hull of the
+	 *  points is the shape. Sphere, Capsule and OBB provide their own.
+	 */
+	struct Convex_Points {
+		const Vector3* points;
+		std::size_t count;
+
+		inline
+		auto support(const Vector3& dir) const -> Vector3 {
+			std::size_t best{ 0 };
+			auto best_dot{ -inf };
+			for(std::size_t n{0}; n<count; ++n){
+				const auto d{ points[n].dot_prod(dir) };
+				if(d > best_dot){ best_dot = d; best = n; }
+			}
+			return points[best];
+		}
+	};
+
+	/**
+	 *  Up to four vertices of the Minkowski difference A - B. Each keeps
+	 *  the points on both shapes and the direction it was found along, so
+	 *  a simplex kept from the previous frame can be rebuilt for the new
+	 *  poses and used as a warm start.
+	 */
+	struct GJK_Simplex {
+		struct Vertex {
+			Vector3 w;
+			Vector3 a;
+			Vector3 b;
+			Vector3 dir;
+		};
+
+		Vertex vertices[4];
+		int count{ 0 };
+
+		inline
+		auto clear() -> void {
+			count = 0;
+		}
+	};
+
+	struct GJK_Result {
+		bool intersecting;
+		float distance;
+		Vector3 point_a;
+		Vector3 point_b;
+		int iterations;
+	};
+
+	/**
+	 *  Moving B by normal*depth separates the shapes, point_a and point_b
+	 *  are the deepest points on each. valid is false when the overlap is
+	 *  too flat to build a polytope around the origin.
+	 */
+	struct Penetration {
+		bool valid;
+		Vector3 normal;
+		float depth;
+		Vector3 point_a;
+		Vector3 point_b;
+	};
+
+	inline
+	auto support(const Sphere& s, const Vector3& dir) -> Vector3 {
+		const auto length{ dir.length() };
+		if(length <= 0.f) return s.getCenter() + Vector3(s.getRadius(), 0.f, 0.f);
+		return s.getCenter() + dir*(s.getRadius()/length);
+	}
+
+	inline
+	auto support(const Capsule& c, const Vector3& dir) -> Vector3 {
+		const auto& segment{ c.getSegment() };
+		const auto end{ segment.getTo().dot_prod(dir) > segment.getFrom().dot_prod(dir)
+			? segment.getTo() : segment.getFrom() };
+		const auto length{ dir.length() };
+		if(length <= 0.f) return end;
+		return end + dir*(c.getRadius()/length);
+	}
+
+	inline
+	auto support(const OBB& b, const Vector3& dir) -> Vector3 {
+		auto p{ b.getCenter() };
+		for(int a{0}; a<3; ++a){
+			const auto& axis{ b.getAxis(a) };
+			const auto e{ b.getHalfExtents()[a] };
+			p = p + axis*(axis.dot_prod(dir) >= 0.f ? e : -e);
+		}
+		return p;
+	}
+
+	inline
+	auto support(const Convex_Points& points, const Vector3& dir) -> Vector3 {
+		return points.support(dir);
+	}
+
+	namespace gjk_detail {
+		template<typename A, typename B>
+		inline
+		auto support_vertex(const A& a, const B& b, const Vector3& dir) -> GJK_Simplex::Vertex {
+			const auto pa{ support(a, dir) };
+			const auto pb{ support(b, dir*-1.f) };
+			return GJK_Simplex::Vertex{ pa-pb, pa, pb, dir };
+		}
+
+		inline
+		auto keep(GJK_Simplex& s, std::initializer_list<int> which, float* lambda,
+				  std::initializer_list<float> weights) -> void {
+			GJK_Simplex::Vertex kept[4];
+			int n{ 0 };
+			for(auto index : which) kept[n++] = s.vertices[index];
+			for(int i{0}; i<n; ++i) s.vertices[i] = kept[i];
+			s.count = n;
+			n = 0;
+			for(auto weight : weights) lambda[n++] = weight;
+		}
+
+		/**
+		 *  Closest point to the origin on triangle s[i], s[j], s[k]
+		 *  (Ericson, RTCD 5.1.5), written as vertex indices and weights.
+		 */
+		inline
+		auto closest_on_triangle(const GJK_Simplex& s, int i, int j, int k,
+								 int* ids, float* weights) -> int {
+			const auto& a{ s.vertices[i].w };
+			const auto& b{ s.vertices[j].w };
+			const auto& c{ s.vertices[k].w };
+			const auto ab{ b-a }, ac{ c-a };
+			const auto d1{ ab.dot_prod(a*-1.f) }, d2{ ac.dot_prod(a*-1.f) };
+			if(d1 <= 0.f && d2 <= 0.f){ ids[0] = i; weights[0] = 1.f; return 1; }
+
+			const auto d3{ ab.dot_prod(b*-1.f) }, d4{ ac.dot_prod(b*-1.f) };
+			if(d3 >= 0.f && d4 <= d3){ ids[0] = j; weights[0] = 1.f; return 1; }
+
+			const auto vc{ d1*d4 - d3*d2 };
+			if(vc <= 0.f && d1 >= 0.f && d3 <= 0.f){
+				const auto v{ d1/(d1-d3) };
+				ids[0] = i; ids[1] = j; weights[0] = 1.f-v; weights[1] = v;
+				return 2;
+			}
+
+			const auto d5{ ab.dot_prod(c*-1.f) }, d6{ ac.dot_prod(c*-1.f) };
+			if(d6 >= 0.f && d5 <= d6){ ids[0] = k; weights[0] = 1.f; return 1; }
+
+			const auto vb{ d5*d2 - d1*d6 };
+			if(vb <= 0.f && d2 >= 0.f && d6 <= 0.f){
+				const auto w{ d2/(d2-d6) };
+				ids[0] = i; ids[1] = k; weights[0] = 1.f-w; weights[1] = w;
+				return 2;
+			}
+
+			const auto va{ d3*d6 - d5*d4 };
+			if(va <= 0.f && d4-d3 >= 0.f && d5-d6 >= 0.f){
+				const auto w{ (d4-d3)/((d4-d3) + (d5-d6)) };
+				ids[0] = j; ids[1] = k; weights[0] = 1.f-w; weights[1] = w;
+				return 2;
+			}
+
+			const auto denom{ 1.f/(va+vb+vc) };
+			const auto v{ vb*denom }, w{ vc*denom };
+			ids[0] = i; ids[1] = j; ids[2] = k;
+			weights[0] = 1.f-v-w; weights[1] = v; weights[2] = w;
+			return 3;
+		}
+
+		/**
+		 *  Reduces the simplex to the feature closest to the origin and
+		 *  returns that point. Returns false if a tetrahedron contains the
+		 *  origin, the simplex is then left untouched.
+		 */
+		inline
+		auto reduce(GJK_Simplex& s, float* lambda, Vector3& closest) -> bool {
+			int ids[3];
+			float weights[3];
+			int kept{ 0 };
+
+			switch(s.count){
+			case 1:
+				lambda[0] = 1.f;
+				closest = s.vertices[0].w;
+				return true;
+			case 2:{
+				const auto& a{ s.vertices[0].w };
+				const auto ab{ s.vertices[1].w - a };
+				const auto sq{ ab.dot_prod(ab) };
+				auto t{ sq > 0.f ? -a.dot_prod(ab)/sq : 0.f };
+				if(t <= 0.f) keep(s, {0}, lambda, {1.f});
+				else if(t >= 1.f) keep(s, {1}, lambda, {1.f});
+				else{ lambda[0] = 1.f-t; lambda[1] = t; }
+				break;
+			}
+			case 3:
+				kept = closest_on_triangle(s, 0, 1, 2, ids, weights);
+				break;
+			default:{
+				// faces the origin lies outside of, each opposite one vertex
+				const int faces[4][4]{ {0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0} };
+				auto best{ inf };
+				auto outside_any{ false };
+				for(const auto& f : faces){
+					const auto& a{ s.vertices[f[0]].w };
+					const auto n{ (s.vertices[f[1]].w - a).cross_prod(s.vertices[f[2]].w - a) };
+					const auto side_origin{ (a*-1.f).dot_prod(n) };
+					const auto side_other{ (s.vertices[f[3]].w - a).dot_prod(n) };
+					if(side_origin*side_other >= 0.f && side_other != 0.f) continue;
+					outside_any = true;
+
+					int face_ids[3];
+					float face_weights[3];
+					const auto n_kept{ closest_on_triangle(s, f[0], f[1], f[2], face_ids, face_weights) };
+					auto p{ Vector3(0.f, 0.f, 0.f) };
+					for(int v{0}; v<n_kept; ++v) p = p + s.vertices[face_ids[v]].w*face_weights[v];
+					const auto d{ p.dot_prod(p) };
+					if(d < best){
+						best = d;
+						kept = n_kept;
+						for(int v{0}; v<n_kept; ++v){ ids[v] = face_ids[v]; weights[v] = face_weights[v]; }
+					}
+				}
+				if(!outside_any) return false;
+				break;
+			}
+			}
+
+			if(s.count >= 3 && kept){
+				GJK_Simplex::Vertex picked[3];
+				for(int v{0}; v<kept; ++v) picked[v] = s.vertices[ids[v]];
+				for(int v{0}; v<kept; ++v){ s.vertices[v] = picked[v]; lambda[v] = weights[v]; }
+				s.count = kept;
+			}
+
+			closest = Vector3(0.f, 0.f, 0.f);
+			for(int v{0}; v<s.count; ++v) closest = closest + s.vertices[v].w*lambda[v];
+			return true;
+		}
+
+		template<typename A, typename B>
+		inline
+		auto run(const A& a, const B& b, GJK_Simplex& s, bool boolean, int max_iterations)
+		-> GJK_Result {
+			constexpr auto tolerance{ 1e-6f };
+			auto result{ GJK_Result{ false, 0.f, Vector3(0.f, 0.f, 0.f), Vector3(0.f, 0.f, 0.f), 0 } };
+
+			// rebuild the cached simplex for the current poses, dropping duplicates
+			const auto cached{ s.count };
+			s.count = 0;
+			for(int n{0}; n<cached; ++n){
+				const auto v{ support_vertex(a, b, s.vertices[n].dir) };
+				auto duplicate{ false };
+				for(int m{0}; m<s.count; ++m)
+					duplicate = duplicate || (s.vertices[m].w - v.w).squared_length() <= tolerance;
+				if(!duplicate) s.vertices[s.count++] = v;
+			}
+			if(!s.count) s.vertices[s.count++] = support_vertex(a, b, Vector3(1.f, 0.f, 0.f));
+
+			float lambda[4]{ 1.f, 0.f, 0.f, 0.f };
+			Vector3 v;
+			if(!reduce(s, lambda, v)){
+				result.intersecting = true;
+				return result;
+			}
+
+			for(; result.iterations<max_iterations; ++result.iterations){
+				const auto vv{ v.dot_prod(v) };
+				if(vv <= tolerance*tolerance){
+					result.intersecting = true;
+					return result;
+				}
+
+				const auto w{ support_vertex(a, b, v*-1.f) };
+				const auto vw{ v.dot_prod(w.w) };
+				if(boolean && vw > 0.f) break;
+				if(vv - vw <= tolerance*vv) break;
+
+				auto duplicate{ false };
+				for(int m{0}; m<s.count; ++m)
+					duplicate = duplicate || (s.vertices[m].w - w.w).squared_length() <= tolerance*tolerance;
+				if(duplicate) break;
+
+				// a nearly degenerate step can make things worse, keep the last simplex then
+				const auto previous{ s };
+				float previous_lambda[4]{ lambda[0], lambda[1], lambda[2], lambda[3] };
+				s.vertices[s.count++] = w;
+				Vector3 next;
+				if(!reduce(s, lambda, next)){
+					result.intersecting = true;
+					return result;
+				}
+				if(next.dot_prod(next) >= vv){
+					s = previous;
+					for(int n{0}; n<4; ++n) lambda[n] = previous_lambda[n];
+					break;
+				}
+				v = next;
+			}
+
+			result.distance = v.length();
+			for(int n{0}; n<s.count; ++n){
+				result.point_a = result.point_a + s.vertices[n].a*lambda[n];
+				result.point_b = result.point_b + s.vertices[n].b*lambda[n];
+			}
+			return result;
+		}
+	}
+
+	/**
+	 *  GJK distance between two convex shapes with a support() overload.
+	 *  simplex is read as a warm start and holds the final simplex after.
+	 */
+	template<typename A, typename B>
+	inline
+	auto gjk_distance(const A& a, const B& b, GJK_Simplex& simplex, int max_iterations=64)
+	-> GJK_Result {
+		return gjk_detail::run(a, b, simplex, false, max_iterations);
+	}
+
+	template<typename A, typename B>
+	inline
+	auto gjk_distance(const A& a, const B& b) -> GJK_Result {
+		GJK_Simplex simplex;
+		return gjk_detail::run(a, b, simplex, false, 64);
+	}
+
+	/**
+	 *  Boolean query, stops as soon as a separating direction is found.
+	 */
+	template<typename A, typename B>
+	inline
+	auto gjk_intersects(const A& a, const B& b, GJK_Simplex& simplex, int max_iterations=64)
+	-> bool {
+		return gjk_detail::run(a, b, simplex, true, max_iterations).intersecting;
+	}
+
+	template<typename A, typename B>
+	inline
+	auto gjk_intersects(const A& a, const B& b) -> bool {
+		GJK_Simplex simplex;
+		return gjk_intersects(a, b, simplex);
+	}
+
+	/**
+	 *  Expanding polytope from the simplex of an intersecting GJK query.
+	 *  Vertices and faces live in fixed arrays, expansion stops when they
+	 *  are full and the best face so far is used.
+	 */
+	template<typename A, typename B>
+	inline
+	auto epa_penetration(const A& a, const B& b, const GJK_Simplex& simplex,
+						 int max_iterations=64) -> Penetration {
+		constexpr int max_vertices{ 64 };
+		constexpr int max_faces{ 128 };
+		constexpr auto tolerance{ 1e-4f };
+		using Vertex = GJK_Simplex::Vertex;
+
+		struct Face {
+			int v[3];
+			Vector3 normal;
+			float distance;
+			bool alive;
+		};
+
+		Vertex vertices[max_vertices];
+		Face faces[max_faces];
+		int vertex_count{ 0 }, face_count{ 0 };
+		auto failed{ Penetration{ false, Vector3(0.f, 0.f, 0.f), 0.f,
+								  Vector3(0.f, 0.f, 0.f), Vector3(0.f, 0.f, 0.f) } };
+
+		for(int n{0}; n<simplex.count; ++n) vertices[vertex_count++] = simplex.vertices[n];
+
+		// grow a smaller simplex into a tetrahedron
+		const Vector3 axes[6]{ {1.f, 0.f, 0.f}, {-1.f, 0.f, 0.f}, {0.f, 1.f, 0.f},
+							   {0.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f, -1.f} };
+		if(vertex_count == 0) vertices[vertex_count++] = gjk_detail::support_vertex(a, b, axes[0]);
+		if(vertex_count == 1)
+			for(const auto& axis : axes){
+				const auto v{ gjk_detail::support_vertex(a, b, axis) };
+				if((v.w - vertices[0].w).squared_length() > tolerance){
+					vertices[vertex_count++] = v;
+					break;
+				}
+			}
+		if(vertex_count == 2){
+			const auto e{ vertices[1].w - vertices[0].w };
+			for(const auto& axis : axes){
+				const auto dir{ e.cross_prod(axis) };
+				if(dir.squared_length() <= tolerance) continue;
+				const auto v{ gjk_detail::support_vertex(a, b, dir) };
+				if((v.w - vertices[0].w).cross_prod(e).squared_length() > tolerance){
+					vertices[vertex_count++] = v;
+					break;
+				}
+			}
+		}
+		if(vertex_count == 3){
+			const auto n{ (vertices[1].w - vertices[0].w).cross_prod(vertices[2].w - vertices[0].w) };
+			for(const auto& dir : { n, n*-1.f }){
+				const auto v{ gjk_detail::support_vertex(a, b, dir) };
+				if(std::fabs((v.w - vertices[0].w).dot_prod(n)) > tolerance){
+					vertices[vertex_count++] = v;
+					break;
+				}
+			}
+		}
+		if(vertex_count < 4) return failed;
+
+		auto add_face{ [&](int i, int j, int k) -> bool {
+			auto slot{ face_count };
+			for(int f{0}; f<face_count; ++f)
+				if(!faces[f].alive){ slot = f; break; }
+			if(slot == max_faces) return false;
+			if(slot == face_count) ++face_count;
+
+			auto& face{ faces[slot] };
+			face.v[0] = i; face.v[1] = j; face.v[2] = k;
+			face.alive = true;
+			auto n{ (vertices[j].w - vertices[i].w).cross_prod(vertices[k].w - vertices[i].w) };
+			const auto length{ n.length() };
+			if(length <= 0.f){
+				face.normal = Vector3(0.f, 0.f, 0.f);
+				face.distance = inf;
+				return true;
+			}
+			face.normal = n*(1.f/length);
+			face.distance = face.normal.dot_prod(vertices[i].w);
+			return true;
+		}};
+
+		// orient the tetrahedron's faces outwards
+		const int tetra[4][4]{ {0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0} };
+		for(const auto& t : tetra){
+			const auto n{ (vertices[t[1]].w - vertices[t[0]].w).cross_prod(vertices[t[2]].w - vertices[t[0]].w) };
+			if(n.dot_prod(vertices[t[3]].w - vertices[t[0]].w) > 0.f) add_face(t[0], t[2], t[1]);
+			else add_face(t[0], t[1], t[2]);
+		}
+
+		int best{ 0 };
+		for(int iteration{0}; iteration<max_iterations; ++iteration){
+			best = -1;
+			for(int f{0}; f<face_count; ++f)
+				if(faces[f].alive && (best < 0 || faces[f].distance < faces[best].distance))
+					best = f;
+			if(best < 0) return failed;
+
+			const auto& closest{ faces[best] };
+			const auto w{ gjk_detail::support_vertex(a, b, closest.normal) };
+			if(w.w.dot_prod(closest.normal) - closest.distance <= tolerance
+			|| vertex_count == max_vertices) break;
+
+			const auto index{ vertex_count };
+			vertices[vertex_count++] = w;
+
+			int edges[3*max_faces][2];
+			int edge_count{ 0 };
+			for(int f{0}; f<face_count; ++f){
+				auto& face{ faces[f] };
+				if(!face.alive || face.normal.dot_prod(w.w - vertices[face.v[0]].w) <= 0.f) continue;
+				face.alive = false;
+				for(int e{0}; e<3; ++e){
+					const auto from{ face.v[e] }, to{ face.v[(e+1)%3] };
+					auto shared{ false };
+					for(int k{0}; k<edge_count; ++k)
+						if(edges[k][0] == to && edges[k][1] == from){
+							edges[k][0] = edges[edge_count-1][0];
+							edges[k][1] = edges[edge_count-1][1];
+							--edge_count;
+							shared = true;
+							break;
+						}
+					if(!shared){
+						edges[edge_count][0] = from;
+						edges[edge_count][1] = to;
+						++edge_count;
+					}
+				}
+			}
+			auto full{ false };
+			for(int e{0}; e<edge_count && !full; ++e)
+				full = !add_face(edges[e][0], edges[e][1], index);
+			if(full) break;
+		}
+
+		best = -1;
+		for(int f{0}; f<face_count; ++f)
+			if(faces[f].alive && (best < 0 || faces[f].distance < faces[best].distance))
+				best = f;
+		if(best < 0 || faces[best].distance == inf) return failed;
+
+		// barycentrics of the origin's projection onto the closest face
+		const auto& face{ faces[best] };
+		const auto p{ face.normal*face.distance };
+		const auto& va{ vertices[face.v[0]] };
+		const auto& vb{ vertices[face.v[1]] };
+		const auto& vc{ vertices[face.v[2]] };
+		const auto v0{ vb.w - va.w }, v1{ vc.w - va.w }, v2{ p - va.w };
+		const auto d00{ v0.dot_prod(v0) }, d01{ v0.dot_prod(v1) }, d11{ v1.dot_prod(v1) };
+		const auto d20{ v2.dot_prod(v0) }, d21{ v2.dot_prod(v1) };
+		const auto denom{ d00*d11 - d01*d01 };
+		const auto v{ denom != 0.f ? (d11*d20 - d01*d21)/denom : 0.f };
+		const auto w{ denom != 0.f ? (d00*d21 - d01*d20)/denom : 0.f };
+		const auto u{ 1.f-v-w };
+
+		return Penetration{
+			true, face.normal, std::max(face.distance, 0.f),
+			va.a*u + vb.a*v + vc.a*w,
+			va.b*u + vb.b*v + vc.b*w
+		};
+	}
+
+	/**
+	 *  GJK followed by EPA when the shapes overlap. depth is 0 and valid
+	 *  false for separated shapes.
+	 */
+	template<typename A, typename B>
+	inline
+	auto gjk_penetration(const A& a, const B& b, GJK_Simplex& simplex) -> Penetration {
+		const auto result{ gjk_distance(a, b, simplex) };
+		if(!result.intersecting)
+			return Penetration{ false, Vector3(0.f, 0.f, 0.f), 0.f, result.point_a, result.point_b };
+		return epa_penetration(a, b, simplex);
+	}
+
+	/**
+	 *  Continuous collision. Every sweep returns the fraction of the motion
+	 *  at first contact, 0 if the shapes already touch and inf if they never
+	 *  meet within the motion.
+	 */
+	namespace toi_detail {
+		inline
+		auto ray_sphere(const Vector3& o, const Vector3& d, const Vector3& center, float r) -> float {
+			const auto m{ o-center };
+			const auto c{ m.dot_prod(m) - r*r };
+			if(c <= 0.f) return 0.f;
+			const auto b{ m.dot_prod(d) };
+			const auto a{ d.dot_prod(d) };
+			if(b >= 0.f || a <= 0.f) return inf;
+			const auto disc{ b*b - a*c };
+			if(disc < 0.f) return inf;
+			const auto t{ (-b - sqrtf(disc))/a };
+			return t <= 1.f ? t : inf;
+		}
+
+		/**
+		 *  Segment o + t*d against the capsule p-q, the body is solved as an
+		 *  infinite cylinder clipped to the axis, the caps as spheres.
+		 */
+		inline
+		auto ray_capsule(const Vector3& o, const Vector3& d, const Vector3& p, const Vector3& q,
+						 float r) -> float {
+			auto best{ std::min(ray_sphere(o, d, p, r), ray_sphere(o, d, q, r)) };
+			const auto m{ q-p };
+			const auto w{ o-p };
+			const auto mm{ m.dot_prod(m) };
+			const auto md{ w.dot_prod(m) };
+			const auto nd{ d.dot_prod(m) };
+			const auto c{ mm*(w.dot_prod(w) - r*r) - md*md };
+			if(c <= 0.f && md >= 0.f && md <= mm) return 0.f;
+
+			const auto a{ mm*d.dot_prod(d) - nd*nd };
+			if(a <= std::numeric_limits<float>::epsilon()*mm) return best;
+			const auto b{ mm*w.dot_prod(d) - nd*md };
+			const auto disc{ b*b - a*c };
+			if(disc < 0.f) return best;
+			const auto t{ (-b - sqrtf(disc))/a };
+			const auto along{ md + t*nd };
+			if(t >= 0.f && t <= 1.f && along >= 0.f && along <= mm) best = std::min(best, t);
+			return best;
+		}
+	}
+
+	inline
+	auto sweep(const Sphere& sphere, const Vector3& motion, const Normal_Plane3& plane) -> float {
+		const auto r{ sphere.getRadius() };
+		const auto d0{ plane.signed_distance(sphere.getCenter()) };
+		if(std::fabs(d0) <= r) return 0.f;
+		const auto d1{ plane.signed_distance(sphere.getCenter() + motion) };
+		const auto side{ d0 > 0.f ? r : -r };
+		if((d0 > 0.f && d1 >= r) || (d0 < 0.f && d1 <= -r)) return inf;
+		return (d0-side)/(d0-d1);
+	}
+
+	/**
+	 *  First contact with the face if it lies inside the triangle, else
+	 *  the earliest hit on the edge capsules, which covers the vertices.
+	 */
+	inline
+	auto sweep(const Sphere& sphere, const Vector3& motion,
+			   const Vector3& v0, const Vector3& v1, const Vector3& v2) -> float {
+		const auto& c{ sphere.getCenter() };
+		const auto r{ sphere.getRadius() };
+		const auto n{ (v1-v0).cross_prod(v2-v0) };
+		const auto length{ n.length() };
+
+		if(length > 0.f){
+			const auto unit{ n*(1.f/length) };
+			auto inside{ [&](const Vector3& p){
+				return (v1-v0).cross_prod(p-v0).dot_prod(n) >= 0.f
+					&& (v2-v1).cross_prod(p-v1).dot_prod(n) >= 0.f
+					&& (v0-v2).cross_prod(p-v2).dot_prod(n) >= 0.f;
+			}};
+			const auto d0{ unit.dot_prod(c-v0) };
+			const auto side{ d0 >= 0.f ? 1.f : -1.f };
+			if(std::fabs(d0) <= r){
+				if(inside(c - unit*d0)) return 0.f;
+			}
+			else{
+				const auto speed{ unit.dot_prod(motion) };
+				if(speed*side < 0.f){
+					const auto t{ (d0 - side*r)/-speed };
+					if(t <= 1.f && inside(c + motion*t - unit*(side*r))) return t;
+				}
+			}
+		}
+
+		return std::min(std::min(
+			toi_detail::ray_capsule(c, motion, v0, v1, r),
+			toi_detail::ray_capsule(c, motion, v1, v2, r)),
+			toi_detail::ray_capsule(c, motion, v2, v0, r));
+	}
+
+	/**
+	 *  The box grown by the radius is the union of the box grown along
+	 *  each single axis and the twelve edge capsules.
+	 */
+	inline
+	auto sweep(const Sphere& sphere, const Vector3& motion, const AABB3& box) -> float {
+		const auto& c{ sphere.getCenter() };
+		const auto r{ sphere.getRadius() };
+		const auto path{ Line3(c, c+motion) };
+		if(!(path.intersect_fraction(box.expanded(r)) <= 1.f)) return inf;
+
+		auto best{ inf };
+		for(int axis{0}; axis<3; ++axis){
+			auto lo{ box.getMin() }, hi{ box.getMax() };
+			lo[axis] -= r;
+			hi[axis] += r;
+			best = std::min(best, path.intersect_fraction(AABB3(lo, hi)));
+		}
+		if(best == 0.f) return best;
+
+		const auto lo{ box.getMin() }, hi{ box.getMax() };
+		for(int axis{0}; axis<3; ++axis){
+			const auto u{ (axis+1)%3 }, v{ (axis+2)%3 };
+			for(int corner{0}; corner<4; ++corner){
+				auto p{ lo };
+				p[u] = corner & 1 ? hi[u] : lo[u];
+				p[v] = corner & 2 ? hi[v] : lo[v];
+				auto q{ p };
+				q[axis] = hi[axis];
+				best = std::min(best, toi_detail::ray_capsule(c, motion, p, q, r));
+			}
+		}
+		return best;
+	}
+
+	/**
+	 *  Both boxes move, the test runs on the relative motion against b
+	 *  grown by a's extents.
+	 */
+	inline
+	auto sweep(const AABB3& a, const Vector3& motion_a, const AABB3& b, const Vector3& motion_b)
+	-> float {
+		const auto extents{ a.getExtents() };
+		const auto grown{ AABB3(b.getMin()-extents, b.getMax()+extents) };
+		return Line3(a.getCenter(), a.getCenter() + motion_a - motion_b).intersect_fraction(grown);
+	}
+
+	inline
+	auto sweep(const AABB3& a, const Vector3& motion, const AABB3& b) -> float {
+		return sweep(a, motion, b, Vector3(0.f, 0.f, 0.f));
+	}
+
+	/**
+	 *  Shape moved by offset, lets the GJK queries run on shapes at any
+	 *  point along their motion without copying them.
+	 */
+	template<typename Shape>
+	struct Translated {
+		const Shape& shape;
+		Vector3 offset;
+	};
+
+	template<typename Shape>
+	inline
+	auto support(const Translated<Shape>& t, const Vector3& dir) -> Vector3 {
+		return support(t.shape, dir) + t.offset;
+	}
+
+	/**
+	 *  Conservative advancement for two translating convex shapes. Under
+	 *  pure translation the distance is convex in time, so stepping by
+	 *  distance over closing speed never passes the contact. Returns inf if
+	 *  the shapes stay further apart than tolerance.
+	 */
+	template<typename A, typename B>
+	inline
+	auto time_of_impact(const A& a, const Vector3& motion_a, const B& b, const Vector3& motion_b,
+						float tolerance=1e-3f, int max_iterations=32) -> float {
+		const auto relative{ motion_a - motion_b };
+		GJK_Simplex simplex;
+		auto t{ 0.f };
+		for(int iteration{0}; iteration<max_iterations; ++iteration){
+			const auto result{ gjk_distance(Translated<A>{ a, motion_a*t },
+											Translated<B>{ b, motion_b*t }, simplex) };
+			if(result.intersecting || result.distance <= tolerance) return t;
+
+			const auto normal{ (result.point_b - result.point_a)*(1.f/result.distance) };
+			const auto closing{ relative.dot_prod(normal) };
+			if(closing <= 0.f) return inf;
+			t += (result.distance - 0.5f*tolerance)/closing;
+			if(t > 1.f) return inf;
+		}
+		return t;
+	}
+
+	/**
+	 *  Sweeps every shape by its motion against one static target, out
+	 *  gets the fractions. Returns how many shapes hit.
+	 */
+	template<typename Shape, typename Target>
+	inline
+	auto sweep_batch(const Shape* shapes, const Vector3* motions, std::size_t count,
+					 const Target& target, float* out, unsigned thread_count=0) -> std::size_t {
+		parallel_for(count, 256, [&](std::size_t begin, std::size_t end, std::size_t){
+			for(auto n{begin}; n<end; ++n) out[n] = sweep(shapes[n], motions[n], target);
+		}, thread_count);
+
+		std::size_t hits{ 0 };
+		for(std::size_t n{0}; n<count; ++n) hits += out[n] <= 1.f;
+		return hits;
+	}
+
+	/**
+	 *  Conservative advancement of every shape against one static target.
+	 */
+	template<typename Shape, typename Target>
+	inline
+	auto time_of_impact_batch(const Shape* shapes, const Vector3* motions, std::size_t count,
+							  const Target& target, float* out, unsigned thread_count=0)
+	-> std::size_t {
+		parallel_for(count, 64, [&](std::size_t begin, std::size_t end, std::size_t){
+			for(auto n{begin}; n<end; ++n)
+				out[n] = time_of_impact(shapes[n], motions[n], target, Vector3(0.f, 0.f, 0.f));
+		}, thread_count);
+
+		std::size_t hits{ 0 };
+		for(std::size_t n{0}; n<count; ++n) hits += out[n] <= 1.f;
+		return hits;
+	}
+
+	struct Segment_Intersection {
+		std::uint32_t a;
+		std::uint32_t b;
+		Vector2 point;
+	};
+
+	namespace segment_detail {
+		struct Sweep_Point {
+			double x, y;
+
+			inline
+			auto operator<(const Sweep_Point& other) const -> bool {
+				return x < other.x || (x == other.x && y < other.y);
+			}
+
+			inline
+			auto operator==(const Sweep_Point& other) const -> bool {
+				return x == other.x && y == other.y;
+			}
+		};
+
+		struct Sweep_Event {
+			Sweep_Point point;
+			std::uint32_t a;
+			std::uint32_t b;
+			enum Kind : std::uint8_t { start, end, cross } kind;
+
+			inline
+			auto operator>(const Sweep_Event& other) const -> bool {
+				return other.point < point;
+			}
+		};
+
+		/**
+		 *  Segments oriented left to right and the sweep position. Segments
+		 *  flagged as through pass the current event point and are ordered by
+		 *  slope just right of it. Everything else is ordered with exact
+		 *  orientation tests against the event point or segment endpoints,
+		 *  never with interpolated heights, which rounding of computed
+		 *  crossing points throws off for steep segments.
+		 */
+		struct Sweep_State {
+			std::vector<Sweep_Point> lo;
+			std::vector<Sweep_Point> hi;
+			std::vector<std::uint8_t> through;
+			Sweep_Point sweep{ -inf, -inf };
+
+			/**
+			 *  Positive when p lies above s, negative below.
+			 */
+			inline
+			auto side(std::uint32_t s, const Sweep_Point& p) const -> double {
+				const double a[2]{ lo[s].x, lo[s].y }, b[2]{ hi[s].x, hi[s].y }, c[2]{ p.x, p.y };
+				return predicate_detail::orient2d(a, b, c);
+			}
+
+			/**
+			 *  Whether the event point lies on s, within the rounding of
+			 *  computed intersection points.
+			 */
+			inline
+			auto contains(std::uint32_t s, const Sweep_Point& e) const -> bool {
+				const auto& p{ lo[s] };
+				const auto& q{ hi[s] };
+				const auto scale{ std::max({ std::fabs(p.x), std::fabs(p.y), std::fabs(q.x),
+											 std::fabs(q.y), std::fabs(e.x), std::fabs(e.y), 1. }) };
+				const auto tol{ 64.*std::numeric_limits<double>::epsilon()*scale };
+				if(e.x < std::min(p.x, q.x)-tol || e.x > std::max(p.x, q.x)+tol
+				|| e.y < std::min(p.y, q.y)-tol || e.y > std::max(p.y, q.y)+tol) return false;
+				const auto dx{ q.x-p.x }, dy{ q.y-p.y };
+				const auto area{ dx*(e.y-p.y) - dy*(e.x-p.x) };
+				return std::fabs(area) <= tol*std::sqrt(dx*dx + dy*dy);
+			}
+
+			/**
+			 *  Crossing of two non-parallel segments in double, so nearby
+			 *  crossings along steep segments keep their order as events.
+			 */
+			inline
+			auto crossing(std::uint32_t s, std::uint32_t t) const -> Sweep_Point {
+				// endpoints touching the other segment are the crossing exactly
+				if(side(s, lo[t]) == 0.) return lo[t];
+				if(side(s, hi[t]) == 0.) return hi[t];
+				if(side(t, lo[s]) == 0.) return lo[s];
+				if(side(t, hi[s]) == 0.) return hi[s];
+				const auto sx{ hi[s].x-lo[s].x }, sy{ hi[s].y-lo[s].y };
+				const auto tx{ hi[t].x-lo[t].x }, ty{ hi[t].y-lo[t].y };
+				const auto den{ sx*ty - sy*tx };
+				const auto along{ ((lo[t].x-lo[s].x)*ty - (lo[t].y-lo[s].y)*tx)/den };
+				const auto f{ std::min(std::max(along, 0.), 1.) };
+				return Sweep_Point{ lo[s].x + f*sx, lo[s].y + f*sy };
+			}
+
+			inline
+			auto turn(std::uint32_t s, std::uint32_t t) const -> double {
+				const auto sx{ hi[s].x-lo[s].x }, sy{ hi[s].y-lo[s].y };
+				const auto tx{ hi[t].x-lo[t].x }, ty{ hi[t].y-lo[t].y };
+				return sx*ty - sy*tx;
+			}
+
+			inline
+			auto below(std::uint32_t s, std::uint32_t t) const -> bool {
+				if(s == t) return false;
+				auto order{ 0. };
+				if(through[s] && through[t]) order = turn(s, t);
+				else if(through[s]) order = -side(t, sweep);
+				else if(through[t]) order = side(s, sweep);
+				else if(lo[t] < lo[s]){
+					// the later starting segment's left end against the other
+					order = -side(t, lo[s]);
+					if(order == 0.) order = -side(t, hi[s]);
+				}
+				else{
+					order = side(s, lo[t]);
+					if(order == 0.) order = side(s, hi[t]);
+				}
+				if(order == 0.) order = turn(s, t);
+				if(order != 0.) return order > 0.;
+				return s < t;
+			}
+		};
+
+		/**
+		 *  Status order. probe stands for the event point itself and sorts
+		 *  before every segment passing through it.
+		 */
+		struct Sweep_Below {
+			static constexpr std::uint32_t probe{ 0xffffffffu };
+			const Sweep_State* state;
+
+			inline
+			auto operator()(std::uint32_t s, std::uint32_t t) const -> bool {
+				if(t == probe)
+					return s != probe && !state->contains(s, state->sweep) && state->side(s, state->sweep) > 0.;
+				if(s == probe)
+					return state->contains(t, state->sweep) || state->side(t, state->sweep) < 0.;
+				return state->below(s, t);
+			}
+		};
+	}
+
+	/**
+	 *  Bentley–Ottmann sweep, reports every intersecting pair among the
+	 *  segments in O((n+k) log n). Each pair is reported once, a < b, at
+	 *  the leftmost shared point. Non-collinear segments that only share
+	 *  an endpoint, as in meshes, are skipped unless shared_endpoints.
+	 */
+	inline
+	auto segment_intersections(const Line2* segments, std::size_t count, bool shared_endpoints=false)
+	-> std::vector<Segment_Intersection> {
+		using namespace segment_detail;
+		using Event = Sweep_Event;
+		using Status = std::set<std::uint32_t, Sweep_Below>;
+
+		Sweep_State state;
+		state.lo.resize(count);
+		state.hi.resize(count);
+		state.through.assign(count, 0);
+
+		std::vector<Event> queue;
+		queue.reserve(2*count);
+		const auto later{ std::greater<Event>() };
+		for(std::size_t n{0}; n<count; ++n){
+			auto p{ Sweep_Point{ segments[n].getFrom().getX(), segments[n].getFrom().getY() } };
+			auto q{ Sweep_Point{ segments[n].getTo().getX(), segments[n].getTo().getY() } };
+			if(q < p) std::swap(p, q);
+			state.lo[n] = p;
+			state.hi[n] = q;
+			const auto id{ static_cast<std::uint32_t>(n) };
+			queue.push_back(Event{ p, id, id, Event::start });
+			queue.push_back(Event{ q, id, id, Event::end });
+		}
+		std::make_heap(queue.begin(), queue.end(), later);
+
+		Status status{ Sweep_Below{ &state } };
+		std::vector<Status::iterator> where(count, status.end());
+		std::vector<std::uint8_t> live(count, 0), mark(count, 0);
+		std::vector<std::uint32_t> upper, lower, crossing, all, inserted;
+		std::vector<Segment_Intersection> found;
+
+		auto shares_endpoint{ [&](std::uint32_t s, std::uint32_t t){
+			return state.lo[s] == state.lo[t] || state.lo[s] == state.hi[t]
+				|| state.hi[s] == state.lo[t] || state.hi[s] == state.hi[t];
+		}};
+		auto collinear{ [&](std::uint32_t s, std::uint32_t t){
+			return orient2d(segments[s].getFrom(), segments[s].getTo(), segments[t].getFrom()) == 0.
+				&& orient2d(segments[s].getFrom(), segments[s].getTo(), segments[t].getTo()) == 0.;
+		}};
+		auto report{ [&](std::uint32_t s, std::uint32_t t, const Vector2& p){
+			if(!shared_endpoints && shares_endpoint(s, t) && !collinear(s, t)) return;
+			found.push_back(Segment_Intersection{ std::min(s, t), std::max(s, t), p });
+		}};
+		auto check{ [&](Status::iterator s, Status::iterator t){
+			if(s == status.end() || t == status.end()) return;
+			const auto& l1{ segments[*s] };
+			const auto& l2{ segments[*t] };
+			if(!l1.intersects(l2) || collinear(*s, *t)) return;
+			const auto point{ state.crossing(*s, *t) };
+			if(state.sweep < point){
+				queue.push_back(Event{ point, *s, *t, Event::cross });
+				std::push_heap(queue.begin(), queue.end(), later);
+			}
+			else report(*s, *t, Vector2(float(point.x), float(point.y)));
+		}};
+
+		while(!queue.empty()){
+			const auto point{ queue.front().point };
+			upper.clear(); lower.clear(); crossing.clear();
+			while(!queue.empty() && queue.front().point == point){
+				const auto event{ queue.front() };
+				std::pop_heap(queue.begin(), queue.end(), later);
+				queue.pop_back();
+				if(event.kind == Event::start) upper.push_back(event.a);
+				else if(event.kind == Event::end) lower.push_back(event.a);
+				else{ crossing.push_back(event.a); crossing.push_back(event.b); }
+			}
+			state.sweep = point;
+
+			// segments through the point: ending, starting and passing
+			all.clear();
+			auto add{ [&](std::uint32_t s){ if(!mark[s]){ mark[s] = 1; all.push_back(s); } } };
+			for(auto s : lower) add(s);
+			for(auto s : upper) add(s);
+			for(auto it{ status.lower_bound(Sweep_Below::probe) };
+				it != status.end() && state.contains(*it, point); ++it) add(*it);
+			for(auto s : crossing) if(live[s]) add(s);
+
+			const auto vec{ Vector2(float(point.x), float(point.y)) };
+			for(std::size_t i{0}; i<all.size(); ++i)
+				for(auto j{i+1}; j<all.size(); ++j) report(all[i], all[j], vec);
+
+			for(auto s : lower) mark[s] = 2;
+			for(auto s : all){
+				if(live[s]){
+					status.erase(where[s]);
+					where[s] = status.end();
+					live[s] = 0;
+				}
+			}
+
+			inserted.clear();
+			for(auto s : all){
+				const auto ended{ mark[s] == 2 };
+				mark[s] = 0;
+				if(ended) continue;
+				state.through[s] = 1;
+				inserted.push_back(s);
+			}
+			for(auto s : inserted){
+				where[s] = status.insert(s).first;
+				live[s] = 1;
+			}
+
+			if(inserted.empty()){
+				const auto above{ status.lower_bound(Sweep_Below::probe) };
+				if(above != status.begin()) check(std::prev(above), above);
+			}
+			else{
+				auto lowest{ where[inserted.front()] };
+				while(lowest != status.begin() && state.through[*std::prev(lowest)]) --lowest;
+				auto highest{ where[inserted.front()] };
+				while(std::next(highest) != status.end() && state.through[*std::next(highest)]) ++highest;
+				if(lowest != status.begin()) check(std::prev(lowest), lowest);
+				check(highest, std::next(highest));
+			}
+			for(auto s : inserted) state.through[s] = 0;
+		}
+
+		std::stable_sort(found.begin(), found.end(), [](const auto& l, const auto& r){
+			return l.a < r.a || (l.a == r.a && l.b < r.b);
+		});
+		found.erase(std::unique(found.begin(), found.end(), [](const auto& l, const auto& r){
+			return l.a == r.a && l.b == r.b;
+		}), found.end());
+		return found;
+	}
+
+	/**
+	 *  Scratch memory for convex_hull. Reusing one workspace keeps its
+	 *  buffers allocated between calls, parts hold the per chunk scratch of
+	 *  the parallel path.
+	 */
+	struct Hull_Workspace {
+		static constexpr std::uint32_t npos{ 0xffffffffu };
+
+		struct Face {
+			std::uint32_t v[3];
+			std::uint32_t neighbor[3];
+			std::uint32_t outside;
+			std::uint32_t visited;
+			double normal[3];
+			bool alive;
+		};
+
+		std::vector<std::uint32_t> order;
+		std::vector<std::uint32_t> chain;
+
+		std::vector<Face> faces;
+		std::vector<std::uint32_t> free_faces;
+		std::vector<std::uint32_t> next_point;
+		std::vector<std::uint32_t> pending;
+		std::vector<std::uint32_t> visible;
+		std::vector<std::uint32_t> orphans;
+		std::vector<std::uint32_t> created;
+		std::vector<std::uint32_t> start_slot;
+		std::vector<std::uint32_t> end_slot;
+		std::vector<std::uint32_t> triangles;
+		std::uint32_t stamp{ 0 };
+
+		std::vector<Hull_Workspace> parts;
+		std::vector<std::uint32_t> merged;
+	};
+
+	namespace hull_detail {
+		static constexpr std::size_t parallel_threshold{ 1u << 16 };
+
+		/**
+		 *  Andrew's monotone chain over the ids in order, which must be
+		 *  sorted by x then y. Writes the counterclockwise hull to out,
+		 *  which needs room for count+1 ids.
+		 */
+		inline
+		auto monotone_chain(const Vector2* points, const std::uint32_t* order, std::size_t count,
+							std::uint32_t* out) -> std::size_t {
+			if(count < 3){
+				std::size_t k{ 0 };
+				for(std::size_t n{0}; n<count; ++n){
+					const auto& p{ points[order[n]] };
+					if(k && points[out[k-1]].getX() == p.getX() && points[out[k-1]].getY() == p.getY()) continue;
+					out[k++] = order[n];
+				}
+				return k;
+			}
+			std::size_t k{ 0 };
+			for(std::size_t n{0}; n<count; ++n){
+				while(k >= 2 && orient2d(points[out[k-2]], points[out[k-1]], points[order[n]]) <= 0.) --k;
+				out[k++] = order[n];
+			}
+			const auto lower{ k+1 };
+			for(auto n{count-1}; n-- > 0;){
+				while(k >= lower && orient2d(points[out[k-2]], points[out[k-1]], points[order[n]]) <= 0.) --k;
+				out[k++] = order[n];
+			}
+			// all points equal leaves the same point on both chains
+			const auto& first{ points[out[0]] };
+			if(k == 3 && first.getX() == points[out[1]].getX() && first.getY() == points[out[1]].getY()) return 1;
+			return k-1;
+		}
+
+		inline
+		auto sort_xy(const Vector2* points, std::uint32_t* begin, std::uint32_t* end) -> void {
+			std::sort(begin, end, [points](std::uint32_t a, std::uint32_t b){
+				const auto& p{ points[a] };
+				const auto& q{ points[b] };
+				return p.getX() < q.getX() || (p.getX() == q.getX() && p.getY() < q.getY());
+			});
+		}
+
+		inline
+		auto hull2(const Vector2* points, std::uint32_t* ids, std::size_t count, Hull_Workspace& ws)
+		-> std::size_t {
+			sort_xy(points, ids, ids+count);
+			ws.chain.resize(count+1);
+			return monotone_chain(points, ids, count, ws.chain.data());
+		}
+
+		inline
+		auto plane_distance(const Hull_Workspace::Face& face, const Vector3* points,
+							const std::uint32_t* ids, std::uint32_t q) -> double {
+			const auto& a{ points[ids[face.v[0]]] };
+			const auto& p{ points[ids[q]] };
+			return face.normal[0]*(double(p.getX())-a.getX())
+				 + face.normal[1]*(double(p.getY())-a.getY())
+				 + face.normal[2]*(double(p.getZ())-a.getZ());
+		}
+
+		/**
+		 *  p lies strictly outside the counterclockwise face.
+		 */
+		inline
+		auto outside(const Hull_Workspace::Face& face, const Vector3* points,
+					 const std::uint32_t* ids, std::uint32_t q) -> bool {
+			return orient3d(points[ids[face.v[0]]], points[ids[face.v[1]]],
+							points[ids[face.v[2]]], points[ids[q]]) < 0.;
+		}
+
+		inline
+		auto add_face(Hull_Workspace& ws, const Vector3* points, const std::uint32_t* ids,
+					  std::uint32_t a, std::uint32_t b, std::uint32_t c) -> std::uint32_t {
+			std::uint32_t f;
+			if(!ws.free_faces.empty()){
+				f = ws.free_faces.back();
+				ws.free_faces.pop_back();
+			}
+			else{
+				f = static_cast<std::uint32_t>(ws.faces.size());
+				ws.faces.emplace_back();
+			}
+			auto& face{ ws.faces[f] };
+			face.v[0] = a; face.v[1] = b; face.v[2] = c;
+			face.neighbor[0] = face.neighbor[1] = face.neighbor[2] = Hull_Workspace::npos;
+			face.outside = Hull_Workspace::npos;
+			face.visited = 0;
+			face.alive = true;
+
+			const auto& pa{ points[ids[a]] };
+			const auto& pb{ points[ids[b]] };
+			const auto& pc{ points[ids[c]] };
+			const double u[3]{ double(pb.getX())-pa.getX(), double(pb.getY())-pa.getY(), double(pb.getZ())-pa.getZ() };
+			const double v[3]{ double(pc.getX())-pa.getX(), double(pc.getY())-pa.getY(), double(pc.getZ())-pa.getZ() };
+			face.normal[0] = u[1]*v[2] - u[2]*v[1];
+			face.normal[1] = u[2]*v[0] - u[0]*v[2];
+			face.normal[2] = u[0]*v[1] - u[1]*v[0];
+			return f;
+		}
+
+		/**
+		 *  Hands every orphan point to the first of the faces it is outside
+		 *  of, points inside all of them are dropped.
+		 */
+		inline
+		auto assign(Hull_Workspace& ws, const Vector3* points, const std::uint32_t* ids,
+					const std::uint32_t* faces, std::size_t face_count) -> void {
+			for(auto q : ws.orphans)
+				for(std::size_t n{0}; n<face_count; ++n){
+					auto& face{ ws.faces[faces[n]] };
+					if(!outside(face, points, ids, q)) continue;
+					if(face.outside == Hull_Workspace::npos) ws.pending.push_back(faces[n]);
+					ws.next_point[q] = face.outside;
+					face.outside = q;
+					break;
+				}
+			ws.orphans.clear();
+		}
+
+		/**
+		 *  Quickhull over points[ids[0..count)], appends counterclockwise
+		 *  triangles as local indices to ws.triangles. Returns false if the
+		 *  points are coplanar.
+		 */
+		inline
+		auto quickhull(const Vector3* points, const std::uint32_t* ids, std::size_t count,
+					   Hull_Workspace& ws) -> bool {
+			constexpr auto npos{ Hull_Workspace::npos };
+			ws.faces.clear();
+			ws.free_faces.clear();
+			ws.pending.clear();
+			ws.orphans.clear();
+			ws.triangles.clear();
+			ws.stamp = 0;
+			if(count < 4) return false;
+			const auto n{ static_cast<std::uint32_t>(count) };
+			auto at{ [&](std::uint32_t q) -> const Vector3& { return points[ids[q]]; } };
+
+			// initial tetrahedron from extreme points
+			std::uint32_t i0{ 0 }, i1{ 0 }, i2{ 0 }, i3{ 0 };
+			for(std::uint32_t q{1}; q<n; ++q)
+				if(at(q).getX() < at(i0).getX()) i0 = q;
+			auto best{ 0.0 };
+			for(std::uint32_t q{0}; q<n; ++q){
+				const auto d{ double((at(q)-at(i0)).squared_length()) };
+				if(d > best){ best = d; i1 = q; }
+			}
+			if(best == 0.) return false;
+			best = 0.;
+			for(std::uint32_t q{0}; q<n; ++q){
+				const auto d{ double((at(i1)-at(i0)).cross_prod(at(q)-at(i0)).squared_length()) };
+				if(d > best){ best = d; i2 = q; }
+			}
+			if(best == 0.) return false;
+			best = 0.;
+			for(std::uint32_t q{0}; q<n; ++q){
+				const auto d{ std::fabs(orient3d(at(i0), at(i1), at(i2), at(q))) };
+				if(d > best){ best = d; i3 = q; }
+			}
+			if(best == 0.) return false;
+			if(orient3d(at(i0), at(i1), at(i2), at(i3)) < 0.) std::swap(i1, i2);
+
+			const std::uint32_t tetra[4][3]{ {i0, i1, i2}, {i0, i3, i1}, {i1, i3, i2}, {i2, i3, i0} };
+			std::uint32_t initial[4];
+			for(int f{0}; f<4; ++f) initial[f] = add_face(ws, points, ids, tetra[f][0], tetra[f][1], tetra[f][2]);
+			for(int f{0}; f<4; ++f)
+				for(int e{0}; e<3; ++e)
+					for(int g{0}; g<4; ++g)
+						for(int k{0}; k<3; ++k)
+							if(tetra[g][k] == tetra[f][(e+1)%3] && tetra[g][(k+1)%3] == tetra[f][e])
+								ws.faces[initial[f]].neighbor[e] = initial[g];
+
+			ws.next_point.assign(count, npos);
+			ws.start_slot.assign(count, npos);
+			ws.end_slot.assign(count, npos);
+			for(std::uint32_t q{0}; q<n; ++q)
+				if(q != i0 && q != i1 && q != i2 && q != i3) ws.orphans.push_back(q);
+			assign(ws, points, ids, initial, 4);
+
+			while(!ws.pending.empty()){
+				const auto start{ ws.pending.back() };
+				ws.pending.pop_back();
+				if(!ws.faces[start].alive || ws.faces[start].outside == npos) continue;
+
+				// the farthest outside point becomes the new apex
+				auto apex{ ws.faces[start].outside };
+				auto farthest{ -1.0 };
+				for(auto q{ws.faces[start].outside}; q != npos; q = ws.next_point[q]){
+					const auto d{ plane_distance(ws.faces[start], points, ids, q) };
+					if(d > farthest){ farthest = d; apex = q; }
+				}
+
+				// flood the faces the apex can see
+				const auto stamp{ ++ws.stamp };
+				ws.visible.clear();
+				ws.visible.push_back(start);
+				ws.faces[start].visited = stamp;
+				for(std::size_t v{0}; v<ws.visible.size(); ++v){
+					const auto& face{ ws.faces[ws.visible[v]] };
+					for(auto nb : face.neighbor){
+						auto& other{ ws.faces[nb] };
+						if(other.visited == stamp || !outside(other, points, ids, apex)) continue;
+						other.visited = stamp;
+						ws.visible.push_back(nb);
+					}
+				}
+
+				// cone from the horizon to the apex
+				ws.created.clear();
+				for(auto f : ws.visible){
+					for(int e{0}; e<3; ++e){
+						const auto nb{ ws.faces[f].neighbor[e] };
+						if(ws.faces[nb].visited == stamp) continue;
+						const auto a{ ws.faces[f].v[e] }, b{ ws.faces[f].v[(e+1)%3] };
+						const auto g{ add_face(ws, points, ids, a, b, apex) };
+						ws.faces[g].neighbor[0] = nb;
+						auto& beyond{ ws.faces[nb] };
+						for(auto& back : beyond.neighbor) if(back == f) back = g;
+						ws.start_slot[a] = g;
+						ws.end_slot[b] = g;
+						ws.created.push_back(g);
+					}
+				}
+				for(auto g : ws.created){
+					auto& face{ ws.faces[g] };
+					face.neighbor[1] = ws.start_slot[face.v[1]];
+					face.neighbor[2] = ws.end_slot[face.v[0]];
+				}
+
+				for(auto f : ws.visible){
+					auto& face{ ws.faces[f] };
+					for(auto q{face.outside}; q != npos; q = ws.next_point[q])
+						if(q != apex) ws.orphans.push_back(q);
+					face.alive = false;
+					face.outside = npos;
+					ws.free_faces.push_back(f);
+				}
+				assign(ws, points, ids, ws.created.data(), ws.created.size());
+			}
+
+			for(const auto& face : ws.faces)
+				if(face.alive)
+					for(auto v : face.v) ws.triangles.push_back(v);
+			return true;
+		}
+	}
+
+	/**
+	 *  Counterclockwise convex hull as indices into points, collinear
+	 *  points are left out. out needs room for count indices. With more
+	 *  than one thread, large inputs are split into chunks whose hulls are
+	 *  built in parallel and merged by hulling their vertices.
+	 */
+	inline
+	auto convex_hull(const Vector2* points, std::size_t count, std::uint32_t* out,
+					 Hull_Workspace& ws, unsigned thread_count=0) -> std::size_t {
+		const auto chunks{ std::min<std::size_t>(worker_count(thread_count),
+												 count/hull_detail::parallel_threshold) };
+		if(chunks <= 1){
+			ws.order.resize(count);
+			for(std::size_t n{0}; n<count; ++n) ws.order[n] = static_cast<std::uint32_t>(n);
+			const auto size{ hull_detail::hull2(points, ws.order.data(), count, ws) };
+			std::copy(ws.chain.begin(), ws.chain.begin()+size, out);
+			return size;
+		}
+
+		ws.parts.resize(chunks);
+		std::vector<std::size_t> sizes(chunks, 0);
+		const auto used{ parallel_for(count, hull_detail::parallel_threshold,
+			[&](std::size_t begin, std::size_t end, std::size_t chunk){
+				auto& part{ ws.parts[chunk] };
+				part.order.resize(end-begin);
+				for(auto n{begin}; n<end; ++n) part.order[n-begin] = static_cast<std::uint32_t>(n);
+				sizes[chunk] = hull_detail::hull2(points, part.order.data(), end-begin, part);
+			}, static_cast<unsigned>(chunks)) };
+
+		ws.merged.clear();
+		for(std::size_t c{0}; c<used; ++c)
+			ws.merged.insert(ws.merged.end(), ws.parts[c].chain.begin(), ws.parts[c].chain.begin()+sizes[c]);
+		const auto size{ hull_detail::hull2(points, ws.merged.data(), ws.merged.size(), ws) };
+		std::copy(ws.chain.begin(), ws.chain.begin()+size, out);
+		return size;
+	}
+
+	inline
+	auto convex_hull(const Vector2* points, std::size_t count, std::uint32_t* out,
+					 unsigned thread_count=0) -> std::size_t {
+		Hull_Workspace ws;
+		return convex_hull(points, count, out, ws, thread_count);
+	}
+
+	/**
+	 *  Quickhull, triangles gets three indices into points per hull face,
+	 *  counterclockwise seen from outside. Coplanar points on faces are
+	 *  left out. Returns the triangle count, 0 if the points are coplanar.
+	 *  The parallel path works like the 2D one.
+	 */
+	inline
+	auto convex_hull(const Vector3* points, std::size_t count, std::vector<std::uint32_t>& triangles,
+					 Hull_Workspace& ws, unsigned thread_count=0) -> std::size_t {
+		triangles.clear();
+		const auto chunks{ std::min<std::size_t>(worker_count(thread_count),
+												 count/hull_detail::parallel_threshold) };
+		ws.merged.clear();
+		if(chunks <= 1){
+			for(std::size_t n{0}; n<count; ++n) ws.merged.push_back(static_cast<std::uint32_t>(n));
+		}
+		else{
+			ws.parts.resize(chunks);
+			const auto used{ parallel_for(count, hull_detail::parallel_threshold,
+				[&](std::size_t begin, std::size_t end, std::size_t chunk){
+					auto& part{ ws.parts[chunk] };
+					part.order.resize(end-begin);
+					for(auto n{begin}; n<end; ++n) part.order[n-begin] = static_cast<std::uint32_t>(n);
+					part.chain.clear();
+					if(!hull_detail::quickhull(points, part.order.data(), end-begin, part)){
+						part.chain = part.order;
+						return;
+					}
+					// hull vertices of the chunk, each once
+					const auto stamp{ ++part.stamp };
+					part.next_point.assign(end-begin, 0);
+					for(auto v : part.triangles)
+						if(part.next_point[v] != stamp){
+							part.next_point[v] = stamp;
+							part.chain.push_back(part.order[v]);
+						}
+				}, static_cast<unsigned>(chunks)) };
+			for(std::size_t c{0}; c<used; ++c)
+				ws.merged.insert(ws.merged.end(), ws.parts[c].chain.begin(), ws.parts[c].chain.end());
+		}
+
+		if(!hull_detail::quickhull(points, ws.merged.data(), ws.merged.size(), ws)) return 0;
+		triangles.reserve(ws.triangles.size());
+		for(auto v : ws.triangles) triangles.push_back(ws.merged[v]);
+		return triangles.size()/3;
+	}
+
+	inline
+	auto convex_hull(const Vector3* points, std::size_t count, std::vector<std::uint32_t>& triangles,
+					 unsigned thread_count=0) -> std::size_t {
+		Hull_Workspace ws;
+		return convex_hull(points, count, triangles, ws, thread_count);
+	}
+
+	/**
+	 *  Incremental constrained Delaunay triangulation of a Vector2 set.
+	 *  Points are inserted in Morton order with Bowyer–Watson, triangles
+	 *  live in flat half-edge arrays where edge 3t+k leaves vertex k of t,
+	 *  and ghost triangles on one infinite vertex close the hull. Vertices
+	 *  are stored in insertion order, the interface uses input indices.
+	 */
+	class Delaunay_Triangulation {
+	public:
+		static constexpr std::uint32_t npos{ 0xffffffffu };
+		static constexpr std::uint32_t infinite{ 0xfffffffeu };
+
+	private:
+		struct Cavity_Edge {
+			std::uint32_t a;
+			std::uint32_t b;
+			std::uint32_t outer;
+			std::uint8_t constrained;
+		};
+
+		std::vector<Vector2> points;
+		std::vector<std::uint32_t> external;
+		std::vector<std::uint32_t> internal;
+		std::vector<std::uint32_t> vertex;
+		std::vector<std::uint32_t> twin;
+		std::vector<std::uint8_t> constrained;
+		std::vector<std::uint32_t> incident;
+		std::vector<std::uint32_t> free_triangles;
+
+		std::vector<std::uint32_t> mark;
+		std::vector<std::uint32_t> into;
+		std::vector<std::uint32_t> cavity;
+		std::vector<std::uint32_t> created;
+		std::vector<Cavity_Edge> rim;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> split;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> crossing;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> fresh;
+		std::uint32_t stamp{ 0 };
+		std::uint32_t last{ npos };
+		std::uint32_t walk{ 0 };
+
+		static inline
+		auto next(std::uint32_t e) -> std::uint32_t {
+			return e%3 == 2 ? e-2 : e+1;
+		}
+
+		static inline
+		auto prev(std::uint32_t e) -> std::uint32_t {
+			return e%3 == 0 ? e+2 : e-1;
+		}
+
+		static inline
+		auto same(const Vector2& p, const Vector2& q) -> bool {
+			return p.getX() == q.getX() && p.getY() == q.getY();
+		}
+
+		/**
+		 *  Whether p lies strictly inside segment ab, given it is collinear.
+		 */
+		static inline
+		auto between(const Vector2& a, const Vector2& b, const Vector2& p) -> bool {
+			const double abx{ double(b.getX())-a.getX() }, aby{ double(b.getY())-a.getY() };
+			return (double(p.getX())-a.getX())*abx + (double(p.getY())-a.getY())*aby > 0.
+				&& (double(p.getX())-b.getX())*abx + (double(p.getY())-b.getY())*aby < 0.;
+		}
+
+		inline
+		auto slot(std::uint32_t v) const -> std::uint32_t {
+			return v == infinite ? 0 : v+1;
+		}
+
+		inline
+		auto is_ghost(std::uint32_t t) const -> bool {
+			return vertex[3*t] == infinite || vertex[3*t+1] == infinite || vertex[3*t+2] == infinite;
+		}
+
+		inline
+		auto allocate() -> std::uint32_t {
+			if(!free_triangles.empty()){
+				const auto t{ free_triangles.back() };
+				free_triangles.pop_back();
+				return t;
+			}
+			const auto t{ static_cast<std::uint32_t>(vertex.size()/3) };
+			vertex.resize(vertex.size()+3);
+			twin.resize(twin.size()+3);
+			constrained.resize(constrained.size()+3);
+			mark.push_back(0);
+			return t;
+		}
+
+		inline
+		auto make(std::uint32_t t, std::uint32_t a, std::uint32_t b, std::uint32_t c) -> void {
+			vertex[3*t] = a;
+			vertex[3*t+1] = b;
+			vertex[3*t+2] = c;
+			if(a != infinite) incident[a] = 3*t;
+			if(b != infinite) incident[b] = 3*t+1;
+			if(c != infinite) incident[c] = 3*t+2;
+		}
+
+		inline
+		auto link(std::uint32_t e, std::uint32_t f) -> void {
+			twin[e] = f;
+			twin[f] = e;
+			constrained[e] = constrained[f];
+		}
+
+		/**
+		 *  Ghost triangles stand for the half-plane beyond their hull edge,
+		 *  real ones for their circumcircle.
+		 */
+		inline
+		auto conflict(std::uint32_t t, const Vector2& p) const -> bool {
+			const auto* v{ &vertex[3*t] };
+			for(int k{0}; k<3; ++k){
+				if(v[k] != infinite) continue;
+				const auto& a{ points[v[(k+1)%3]] };
+				const auto& b{ points[v[(k+2)%3]] };
+				const auto side{ orient2d(a, b, p) };
+				return side > 0. || (side == 0. && between(a, b, p));
+			}
+			return incircle(points[v[0]], points[v[1]], points[v[2]], p) > 0.;
+		}
+
+		/**
+		 *  Visibility walk from the last created triangle. Returns the real
+		 *  triangle holding p or the ghost whose hull edge p lies beyond.
+		 */
+		inline
+		auto locate(const Vector2& p) -> std::uint32_t {
+			auto t{ last };
+			if(t == npos || vertex[3*t] == npos || is_ghost(t)){
+				t = 0;
+				while(vertex[3*t] == npos || is_ghost(t)) ++t;
+			}
+			for(auto moved{ true }; moved;){
+				if(is_ghost(t)) return t;
+				moved = false;
+				const auto start{ walk++%3 };
+				for(std::uint32_t k{0}; k<3; ++k){
+					const auto e{ 3*t + (start+k)%3 };
+					if(orient2d(points[vertex[e]], points[vertex[next(e)]], p) < 0.){
+						t = twin[e]/3;
+						moved = true;
+						break;
+					}
+				}
+			}
+			return t;
+		}
+
+		/**
+		 *  Bowyer–Watson step for points[id]. The cavity does not grow past
+		 *  constrained edges unless the point lies on them, such edges are
+		 *  split in two. Returns the vertex already at that position if any.
+		 */
+		inline
+		auto insert_vertex(std::uint32_t id) -> std::uint32_t {
+			const auto& p{ points[id] };
+			const auto start{ locate(p) };
+			if(!is_ghost(start))
+				for(int k{0}; k<3; ++k)
+					if(same(points[vertex[3*start+k]], p)) return vertex[3*start+k];
+
+			stamp += 2;
+			cavity.clear();
+			rim.clear();
+			split.clear();
+			mark[start] = stamp;
+			cavity.push_back(start);
+			for(std::size_t n{0}; n<cavity.size(); ++n){
+				const auto c{ cavity[n] };
+				for(std::uint32_t k{0}; k<3; ++k){
+					const auto e{ 3*c+k };
+					const auto neighbor{ twin[e]/3 };
+					if(mark[neighbor] == stamp) continue;
+					if(constrained[e]){
+						const auto& a{ points[vertex[e]] };
+						const auto& b{ points[vertex[next(e)]] };
+						if(orient2d(a, b, p) != 0. || !between(a, b, p)){
+							rim.push_back(Cavity_Edge{ vertex[e], vertex[next(e)], twin[e], 1 });
+							continue;
+						}
+						split.emplace_back(vertex[e], vertex[next(e)]);
+					}
+					else if(mark[neighbor] == stamp+1 || !conflict(neighbor, p)){
+						mark[neighbor] = stamp+1;
+						rim.push_back(Cavity_Edge{ vertex[e], vertex[next(e)], twin[e], 0 });
+						continue;
+					}
+					mark[neighbor] = stamp;
+					cavity.push_back(neighbor);
+				}
+			}
+
+			for(auto c : cavity){
+				vertex[3*c] = npos;
+				free_triangles.push_back(c);
+			}
+			created.clear();
+			for(const auto& edge : rim){
+				const auto t{ allocate() };
+				make(t, edge.a, edge.b, id);
+				link(3*t, edge.outer);
+				constrained[3*t+1] = 0;
+				constrained[3*t+2] = 0;
+				into[slot(edge.a)] = 3*t+2;
+				created.push_back(t);
+			}
+			for(auto t : created){
+				const auto e{ 3*t+1 };
+				twin[e] = into[slot(vertex[e])];
+				twin[twin[e]] = e;
+				if(!is_ghost(t)) last = t;
+			}
+			for(const auto& edge : split){
+				for(auto v : { edge.first, edge.second }){
+					const auto e{ into[slot(v)] };
+					constrained[e] = 1;
+					constrained[twin[e]] = 1;
+				}
+			}
+			return id;
+		}
+
+		/**
+		 *  Outgoing half-edge a→b, npos if the edge is not in the mesh.
+		 */
+		inline
+		auto find_edge(std::uint32_t a, std::uint32_t b) const -> std::uint32_t {
+			const auto first{ incident[a] };
+			if(first == npos) return npos;
+			auto e{ first };
+			do{
+				if(vertex[next(e)] == b) return e;
+				e = twin[prev(e)];
+			} while(e != first);
+			return npos;
+		}
+
+		/**
+		 *  Replaces the diagonal of the two triangles on e by the other one.
+		 */
+		inline
+		auto flip(std::uint32_t e) -> void {
+			const auto f{ twin[e] };
+			const auto t1{ e/3 }, t2{ f/3 };
+			const auto a{ vertex[e] }, b{ vertex[next(e)] };
+			const auto c{ vertex[prev(e)] }, d{ vertex[prev(f)] };
+			const auto bc{ twin[next(e)] }, ca{ twin[prev(e)] };
+			const auto ad{ twin[next(f)] }, db{ twin[prev(f)] };
+			make(t1, c, a, d);
+			make(t2, d, b, c);
+			link(3*t1, ca);
+			link(3*t1+1, ad);
+			link(3*t2, db);
+			link(3*t2+1, bc);
+			twin[3*t1+2] = 3*t2+2;
+			twin[3*t2+2] = 3*t1+2;
+			constrained[3*t1+2] = 0;
+			constrained[3*t2+2] = 0;
+			last = t1;
+		}
+
+		/**
+		 *  Forces the edge from→to when the segment meets no vertex on the
+		 *  way (Sloan), then restores the Delaunay property around it.
+		 */
+		inline
+		auto force_edge(std::uint32_t from, std::uint32_t to) -> void {
+			const auto& u{ points[from] };
+			const auto& v{ points[to] };
+			std::size_t head{ 0 };
+			fresh.clear();
+			while(head < crossing.size()){
+				const auto edge{ crossing[head++] };
+				const auto e{ find_edge(edge.first, edge.second) };
+				const auto& a{ points[edge.first] };
+				const auto& b{ points[edge.second] };
+				const auto c{ vertex[prev(e)] }, d{ vertex[prev(twin[e])] };
+				const auto& pc{ points[c] };
+				const auto& pd{ points[d] };
+				const auto side_a{ orient2d(pc, pd, a) }, side_b{ orient2d(pc, pd, b) };
+				if(!((side_a < 0. && side_b > 0.) || (side_a > 0. && side_b < 0.))){
+					crossing.push_back(edge);
+					continue;
+				}
+				flip(e);
+				const auto crosses{ c != from && c != to && d != from && d != to
+								 && orient2d(u, v, pc)*orient2d(u, v, pd) < 0. };
+				if(crosses) crossing.emplace_back(c, d);
+				else fresh.emplace_back(c, d);
+			}
+			crossing.clear();
+
+			const auto e{ find_edge(from, to) };
+			constrained[e] = 1;
+			constrained[twin[e]] = 1;
+
+			for(auto swapped{ true }; swapped;){
+				swapped = false;
+				for(auto& edge : fresh){
+					const auto f{ find_edge(edge.first, edge.second) };
+					if(constrained[f]) continue;
+					const auto c{ vertex[prev(f)] }, d{ vertex[prev(twin[f])] };
+					if(c == infinite || d == infinite) continue;
+					if(incircle(points[edge.first], points[edge.second], points[c], points[d]) > 0.){
+						flip(f);
+						edge = std::make_pair(c, d);
+						swapped = true;
+					}
+				}
+			}
+		}
+
+		/**
+		 *  Seeds the mesh from the first three non-collinear points and
+		 *  inserts the rest. Does nothing while all points are collinear.
+		 */
+		inline
+		auto bootstrap() -> void {
+			const auto count{ static_cast<std::uint32_t>(points.size()) };
+			if(count < 3) return;
+
+			const std::uint32_t first{ 0 };
+			std::uint32_t second{ 1 };
+			while(second < count && same(points[second], points[first])) ++second;
+			auto third{ second+1 };
+			while(third < count && orient2d(points[first], points[second], points[third]) == 0.) ++third;
+			if(third >= count) return;
+
+			auto b{ second }, c{ third };
+			if(orient2d(points[first], points[b], points[c]) < 0.) std::swap(b, c);
+			vertex.reserve(6*count + 12);
+			twin.reserve(6*count + 12);
+			constrained.reserve(6*count + 12);
+			mark.reserve(2*count + 4);
+
+			const auto t{ allocate() };
+			make(t, first, b, c);
+			std::uint32_t ghost[3];
+			for(std::uint32_t k{0}; k<3; ++k){
+				ghost[k] = allocate();
+				make(ghost[k], vertex[3*t+(k+1)%3], vertex[3*t+k], infinite);
+				link(3*ghost[k], 3*t+k);
+			}
+			for(std::uint32_t k{0}; k<3; ++k){
+				twin[3*ghost[k]+1] = 3*ghost[(k+2)%3]+2;
+				twin[3*ghost[(k+2)%3]+2] = 3*ghost[k]+1;
+			}
+			last = t;
+
+			for(std::uint32_t n{1}; n<count; ++n)
+				if(n != b && n != c) internal[external[n]] = insert_vertex(n);
+		}
+
+	public:
+		/**
+		 *  Triangulates the points, duplicates are left out. Input that is
+		 *  entirely collinear has no triangles.
+		 */
+		inline
+		Delaunay_Triangulation(const Vector2* input, std::size_t count)
+		:external(count), internal(count), incident(count, npos), into(count+1, npos){
+			morton_order(input, count, external.data());
+			points.reserve(count);
+			for(std::uint32_t n{0}; n<count; ++n){
+				points.push_back(input[external[n]]);
+				internal[external[n]] = n;
+			}
+			bootstrap();
+		}
+
+		/**
+		 *  Adds a point and returns its index, or the index of the point
+		 *  already at that position.
+		 */
+		inline
+		auto insert_point(const Vector2& point) -> std::uint32_t {
+			const auto id{ static_cast<std::uint32_t>(points.size()) };
+			points.push_back(point);
+			incident.push_back(npos);
+			into.push_back(npos);
+			const auto found{ last == npos ? id : insert_vertex(id) };
+			if(found != id){
+				points.pop_back();
+				incident.pop_back();
+				into.pop_back();
+				return external[found];
+			}
+			external.push_back(static_cast<std::uint32_t>(internal.size()));
+			internal.push_back(id);
+			if(last == npos){
+				// the first point off the line starts the mesh
+				bootstrap();
+				return external[internal[external[id]]];
+			}
+			return external[id];
+		}
+
+		/**
+		 *  Makes the segment between two vertices an edge that later flips
+		 *  and insertions keep. A segment through other vertices is split
+		 *  at them. Constraints must not cross each other.
+		 */
+		inline
+		auto insert_constraint(std::uint32_t a, std::uint32_t b) -> void {
+			auto from{ internal[a] };
+			const auto to{ internal[b] };
+			if(incident[from] == npos || incident[to] == npos) return;
+			const auto& u{ points[from] };
+			const auto& v{ points[to] };
+			while(from != to){
+				const auto e{ find_edge(from, to) };
+				if(e != npos){
+					constrained[e] = 1;
+					constrained[twin[e]] = 1;
+					return;
+				}
 
-	inline 
-	auto quadratic_bezier(const float& p0, const float& p1, const float& p2, const float& progress) -> float {
-		auto pr1{ fabs(p1-p0)*progress };	
-		auto pr2{ fabs(p2-p1)*progress };
+				// the triangle around from that the segment leaves through
+				crossing.clear();
+				auto stop{ to };
+				auto h{ incident[from] };
+				for(;;){
+					const auto c{ vertex[next(h)] }, d{ vertex[prev(h)] };
+					if(c != infinite){
+						const auto side_c{ orient2d(u, v, points[c]) };
+						if(side_c == 0. && between(points[from], v, points[c])){
+							stop = c;
+							break;
+						}
+						if(d != infinite && side_c < 0. && orient2d(u, v, points[d]) > 0.){
+							crossing.emplace_back(c, d);
+							break;
+						}
+					}
+					h = twin[prev(h)];
+				}
 
-		auto l0{ lerp(p1, p0, pr1) };
-		auto l1{ lerp(p2, p1, pr2) };
+				// walk the crossed edges, right end first
+				if(stop == to){
+					auto edge{ next(h) };
+					for(;;){
+						const auto o{ twin[edge] };
+						const auto w{ vertex[prev(o)] };
+						if(w == to) break;
+						const auto side{ orient2d(u, v, points[w]) };
+						if(side == 0.){
+							stop = w;
+							break;
+						}
+						edge = side < 0. ? prev(o) : next(o);
+						crossing.emplace_back(vertex[edge], vertex[next(edge)]);
+					}
+				}
 
-		auto pr3{ fabs(l1-l0)*progress };
-		return lerp(l1, l0, pr3);
-	}
+				if(crossing.empty()){
+					const auto f{ find_edge(from, stop) };
+					constrained[f] = 1;
+					constrained[twin[f]] = 1;
+				}
+				else force_edge(from, stop);
+				from = stop;
+			}
+		}
+
+		inline
+		auto insert_constraint(const Line2& segment) -> void {
+			const auto from{ insert_point(segment.getFrom()) };
+			const auto to{ insert_point(segment.getTo()) };
+			insert_constraint(from, to);
+		}
+
+		inline
+		auto insert_constraints(const Line2* segments, std::size_t count) -> void {
+			for(std::size_t n{0}; n<count; ++n) insert_constraint(segments[n]);
+		}
+
+		inline
+		auto size() const -> std::size_t {
+			return internal.size();
+		}
+
+		inline
+		auto getPoint(std::uint32_t index) const -> const Vector2& {
+			return points[internal[index]];
+		}
+
+		inline
+		auto has_edge(std::uint32_t a, std::uint32_t b) const -> bool {
+			return find_edge(internal[a], internal[b]) != npos;
+		}
 
-	auto quadratic_bezier(const Vector2& p0, const Vector2& p1, const Vector2& p2, const float& progress) -> Vector2 {
-		auto pr1{ (p1-p0).length()*progress };	
-		auto pr2{ (p2-p1).length()*progress };
+		inline
+		auto is_constrained(std::uint32_t a, std::uint32_t b) const -> bool {
+			const auto e{ find_edge(internal[a], internal[b]) };
+			return e != npos && constrained[e];
+		}
+
+		inline
+		auto triangle_count() const -> std::size_t {
+			std::size_t count{ 0 };
+			for(std::uint32_t t{0}; t<vertex.size()/3; ++t)
+				count += vertex[3*t] != npos && !is_ghost(t);
+			return count;
+		}
+
+		/**
+		 *  Writes three counterclockwise vertex indices per triangle, out
+		 *  needs room for 3*triangle_count(). Returns the triangle count.
+		 */
+		inline
+		auto triangles(std::uint32_t* out) const -> std::size_t {
+			std::size_t count{ 0 };
+			for(std::uint32_t t{0}; t<vertex.size()/3; ++t){
+				if(vertex[3*t] == npos || is_ghost(t)) continue;
+				for(int k{0}; k<3; ++k) out[3*count+k] = external[vertex[3*t+k]];
+				++count;
+			}
+			return count;
+		}
 
-		auto l0{ lerp(p1, p0, pr1) };
-		auto l1{ lerp(p2, p1, pr2) };
+		inline
+		auto triangles() const -> std::vector<std::uint32_t> {
+			std::vector<std::uint32_t> out(3*triangle_count());
+			triangles(out.data());
+			return out;
+		}
+	};
 
-		auto pr3{ (l0-l1).length()*progress };
-		return lerp(l1, l0, pr3);
+	/**
+	 *  Clips every segment against the rectangle. The visible parts are
+	 *  packed into out and their source indices into kept, both need room
+	 *  for count entries. Returns the number of segments written.
+	 */
+	inline
+	auto clip_segments(const Line2* segments, std::size_t count, const Rect& rectangle,
+					   Line2* out, std::uint32_t* kept, unsigned thread_count=0) -> std::size_t {
+		std::vector<std::size_t> first(worker_count(thread_count)), written(first.size());
+		const auto chunks{ parallel_for(count, 1u << 12,
+			[&](std::size_t begin, std::size_t end, std::size_t chunk){
+				auto slot{ begin };
+				for(auto n{begin}; n<end; ++n)
+					if(segments[n].clip(rectangle, out[slot])) kept[slot++] = static_cast<std::uint32_t>(n);
+				first[chunk] = begin;
+				written[chunk] = slot-begin;
+			}, thread_count)
+		};
+
+		// every chunk wrote at its own offset, close the gaps
+		std::size_t total{ chunks ? written[0] : 0 };
+		for(std::size_t c{1}; c<chunks; ++c){
+			std::copy(out+first[c], out+first[c]+written[c], out+total);
+			std::copy(kept+first[c], kept+first[c]+written[c], kept+total);
+			total += written[c];
+		}
+		return total;
 	}
 
-	auto quadratic_bezier(const Vector3& p0, const Vector3& p1, const Vector3& p2, const float& progress) -> Vector3 {
-		auto pr1{ (p1-p0).length()*progress };	
-		auto pr2{ (p2-p1).length()*progress };
+	namespace clip_detail {
+		constexpr std::size_t overflow{ ~std::size_t{0} };
 
-		auto l0{ lerp(p1, p0, pr1) };
-		auto l1{ lerp(p2, p1, pr2) };
+		/**
+		 *  One Sutherland–Hodgman pass against the line p[axis] = value,
+		 *  keeping the side above it when keep_above. Crossings are snapped
+		 *  onto the line. Returns overflow instead of writing past capacity.
+		 */
+		inline
+		auto clip_axis(const Vector2* in, std::size_t count, int axis, float value, bool keep_above,
+					   Vector2* out, std::size_t capacity) -> std::size_t {
+			std::size_t written{ 0 };
+			if(!count || count == overflow) return count;
+			auto inside{ [&](const Vector2& p){ return keep_above ? p[axis] >= value : p[axis] <= value; } };
+			auto prev{ in[count-1] };
+			auto prev_inside{ inside(prev) };
+			for(std::size_t n{0}; n<count; ++n){
+				const auto cur{ in[n] };
+				const auto cur_inside{ inside(cur) };
+				if(written + (cur_inside != prev_inside) + cur_inside > capacity) return overflow;
+				if(cur_inside != prev_inside){
+					const auto t{ (value-prev[axis])/(cur[axis]-prev[axis]) };
+					auto crossing{ prev + t*(cur-prev) };
+					crossing[axis] = value;
+					out[written++] = crossing;
+				}
+				if(cur_inside) out[written++] = cur;
+				prev = cur;
+				prev_inside = cur_inside;
+			}
+			return written;
+		}
 
-		auto pr3{ (l0-l1).length()*progress };
-		return lerp(l1, l0, pr3);
+		/**
+		 *  One pass against the directed edge from→to, keeping its left side.
+		 */
+		inline
+		auto clip_edge(const Vector2* in, std::size_t count, const Vector2& from, const Vector2& to,
+					   Vector2* out, std::size_t capacity) -> std::size_t {
+			std::size_t written{ 0 };
+			if(!count || count == overflow) return count;
+			auto prev{ in[count-1] };
+			auto prev_side{ orient2d(from, to, prev) };
+			for(std::size_t n{0}; n<count; ++n){
+				const auto cur{ in[n] };
+				const auto cur_side{ orient2d(from, to, cur) };
+				const auto crosses{ (cur_side >= 0.) != (prev_side >= 0.) };
+				if(written + crosses + (cur_side >= 0.) > capacity) return overflow;
+				if(crosses){
+					const auto t{ static_cast<float>(prev_side/(prev_side-cur_side)) };
+					out[written++] = prev + t*(cur-prev);
+				}
+				if(cur_side >= 0.) out[written++] = cur;
+				prev = cur;
+				prev_side = cur_side;
+			}
+			return written;
+		}
 	}
 
+	/**
+	 *  Worst case vertex count after passes clipping passes. A pass adds a
+	 *  crossing for every edge coming back inside, so concave input can
+	 *  grow by half of its vertices per pass.
+	 */
 	inline constexpr
-	auto min(float& a, float& b) -> float& {
-		return a<b?a:b;
+	auto clip_capacity(std::size_t count, std::size_t passes) -> std::size_t {
+		for(std::size_t p{0}; p<passes; ++p) count += count/2;
+		return count;
 	}
 
-	inline constexpr
-	auto max(float& a, float& b) -> float& {
-		return a>b?a:b;
+	/**
+	 *  Sutherland–Hodgman clip of a polygon against the rectangle, out and
+	 *  scratch hold capacity vertices each, clip_capacity(count, 4) is
+	 *  always enough. Concave input stays one polygon, parts it splits into
+	 *  are joined along the border. Returns the vertex count of the result,
+	 *  0 if nothing is left or it would not fit.
+	 */
+	inline
+	auto clip_polygon(const Vector2* polygon, std::size_t count, const Rect& rectangle,
+					  Vector2* out, Vector2* scratch, std::size_t capacity) -> std::size_t {
+		using namespace clip_detail;
+		auto size{ clip_axis(polygon, count, 0, rectangle.getXMin(), true, scratch, capacity) };
+		size = clip_axis(scratch, size, 0, rectangle.getXMax(), false, out, capacity);
+		size = clip_axis(out, size, 1, rectangle.getYMin(), true, scratch, capacity);
+		size = clip_axis(scratch, size, 1, rectangle.getYMax(), false, out, capacity);
+		return size < 3 || size == overflow ? 0 : size;
 	}
 
-    inline 
-    auto powZ(const float& b, const int& exp)-> float {
-        if(b == 0) [[unlikely]] {
-            if(exp<0){
-                return std::round_toward_infinity;
-            }
-            return 1;
-        }
-        if(exp == 0) return 0;
+	/**
+	 *  Same against a convex counterclockwise polygon of clip_count
+	 *  vertices, clip_capacity(count, clip_count) is always enough.
+	 */
+	inline
+	auto clip_polygon(const Vector2* polygon, std::size_t count, const Vector2* clipper, std::size_t clip_count,
+					  Vector2* out, Vector2* scratch, std::size_t capacity) -> std::size_t {
+		// alternate buffers so the last pass lands in out
+		const auto* in{ polygon };
+		auto* target{ clip_count%2 ? out : scratch };
+		auto size{ count };
+		for(std::size_t e{0}; e<clip_count && size && size != clip_detail::overflow; ++e){
+			size = clip_detail::clip_edge(in, size, clipper[e], clipper[(e+1)%clip_count], target, capacity);
+			in = target;
+			target = target == out ? scratch : out;
+		}
+		if(size < 3 || size == clip_detail::overflow) return 0;
+		if(in != out) std::copy(in, in+size, out);
+		return size;
+	}
 
-        auto base{b};
-        for(int i{1}; i<exp; ++i){
-            base *= b;
-        }
+	namespace region_detail {
+		/**
+		 *  Rect test for one word of up to 32 points given as SoA lanes.
+		 */
+		inline
+		auto rect_word(const Rect& rect, const float* xs, const float* ys, std::size_t lanes) -> std::uint32_t {
+			const auto x_min{ rect.getXMin() }, x_max{ rect.getXMax() };
+			const auto y_min{ rect.getYMin() }, y_max{ rect.getYMax() };
+			std::uint32_t inside[32];
+			for(std::size_t l{0}; l<lanes; ++l)
+				inside[l] = static_cast<std::uint32_t>((xs[l] >= x_min) & (xs[l] <= x_max)
+													 & (ys[l] >= y_min) & (ys[l] <= y_max));
+			std::uint32_t mask{ 0 };
+			for(std::size_t l{0}; l<lanes; ++l) mask |= inside[l] << l;
+			return mask;
+		}
 
-        if(exp<0){
-            return 1/b;
-        }
-        return base;
-    }
+		/**
+		 *  Winding contribution of edge a→b for a point, counting the edge
+		 *  when it passes to the right of the point (half-open in y).
+		 */
+		inline
+		auto crossing(double ax, double ay, double bx, double by, double px, double py) -> int {
+			const auto side{ (bx-ax)*(py-ay) - (by-ay)*(px-ax) };
+			return ((ay <= py) & (py < by) & (side > 0.)) - ((by <= py) & (py < ay) & (side < 0.));
+		}
+	}
 
-	inline 
-	auto pow(const float& b, const float& exp) -> float {
-  		 return __builtin_powf(b, exp); 
+	/**
+	 *  Rect membership of SoA points, bit n%32 of masks[n/32] is set when
+	 *  point n lies inside or on the border. Returns the inside count.
+	 */
+	inline
+	auto contains_batch(const Rect& rect, const float* xs, const float* ys, std::size_t count,
+						std::uint32_t* masks, unsigned thread_count=0) -> std::size_t {
+		std::atomic<std::size_t> inside{ 0 };
+		parallel_for((count+31)/32, 512, [&](std::size_t begin, std::size_t end, std::size_t){
+			std::size_t local{ 0 };
+			for(auto word{begin}; word<end; ++word){
+				const auto base{ word*32 };
+				const auto mask{ region_detail::rect_word(rect, xs+base, ys+base, std::min<std::size_t>(32, count-base)) };
+				masks[word] = mask;
+				for(auto m{mask}; m; m &= m-1) ++local;
+			}
+			inside += local;
+		}, thread_count);
+		return inside;
+	}
+
+	/**
+	 *  Same for Vector2 points, gathered into lanes one word at a time.
+	 */
+	inline
+	auto contains_batch(const Rect& rect, const Vector2* points, std::size_t count,
+						std::uint32_t* masks, unsigned thread_count=0) -> std::size_t {
+		std::atomic<std::size_t> inside{ 0 };
+		parallel_for((count+31)/32, 512, [&](std::size_t begin, std::size_t end, std::size_t){
+			std::size_t local{ 0 };
+			float xs[32], ys[32];
+			for(auto word{begin}; word<end; ++word){
+				const auto base{ word*32 };
+				const auto lanes{ std::min<std::size_t>(32, count-base) };
+				for(std::size_t l{0}; l<lanes; ++l){
+					xs[l] = points[base+l].getX();
+					ys[l] = points[base+l].getY();
+				}
+				const auto mask{ region_detail::rect_word(rect, xs, ys, lanes) };
+				masks[word] = mask;
+				for(auto m{mask}; m; m &= m-1) ++local;
+			}
+			inside += local;
+		}, thread_count);
+		return inside;
+	}
+
+	/**
+	 *  Winding number of the closed polygon around p, zero outside for
+	 *  either orientation. Points on the border may count either way.
+	 */
+	inline
+	auto winding_number(const Vector2& p, const Vector2* polygon, std::size_t count) -> int {
+		int winding{ 0 };
+		for(std::size_t n{0}; n<count; ++n){
+			const auto& a{ polygon[n] };
+			const auto& b{ polygon[n+1 < count ? n+1 : 0] };
+			winding += region_detail::crossing(a.getX(), a.getY(), b.getX(), b.getY(), p.getX(), p.getY());
+		}
+		return winding;
+	}
+
+	/**
+	 *  winding_number for many points, the edge loop runs over a word of
+	 *  32 points at a time so it vectorises. O(points*edges), see
+	 *  Polygon_Slabs for large polygons.
+	 */
+	inline
+	auto winding_numbers(const Vector2* points, std::size_t count, const Vector2* polygon,
+						 std::size_t polygon_count, std::int32_t* out, unsigned thread_count=0) -> void {
+		parallel_for((count+31)/32, 16, [&](std::size_t begin, std::size_t end, std::size_t){
+			double xs[32], ys[32];
+			std::int32_t winding[32];
+			for(auto word{begin}; word<end; ++word){
+				const auto base{ word*32 };
+				const auto lanes{ std::min<std::size_t>(32, count-base) };
+				for(std::size_t l{0}; l<lanes; ++l){
+					xs[l] = points[base+l].getX();
+					ys[l] = points[base+l].getY();
+					winding[l] = 0;
+				}
+				for(std::size_t n{0}; n<polygon_count; ++n){
+					const auto& a{ polygon[n] };
+					const auto& b{ polygon[n+1 < polygon_count ? n+1 : 0] };
+					const double ax{ a.getX() }, ay{ a.getY() }, bx{ b.getX() }, by{ b.getY() };
+					for(std::size_t l{0}; l<lanes; ++l)
+						winding[l] += region_detail::crossing(ax, ay, bx, by, xs[l], ys[l]);
+				}
+				std::copy(winding, winding+lanes, out+base);
+			}
+		}, thread_count);
+	}
+
+	/**
+	 *  Horizontal slabs between the distinct vertex heights of a polygon,
+	 *  each listing the edges spanning it ordered by x. A query finds its
+	 *  slab and the edges right of it with two binary searches, so
+	 *  winding numbers cost O(log n). Slabs whose edges cross (self
+	 *  intersecting input) fall back to scanning their edges. Memory is
+	 *  the number of slabs each edge spans, summed over the edges.
+	 */
+	class Polygon_Slabs {
+		struct Edge {
+			Vector2 lower;
+			Vector2 upper;
+			std::int32_t winding;
+		};
+
+		std::vector<float> heights;
+		std::vector<Edge> edges;
+		std::vector<std::uint32_t> slab_start;
+		std::vector<std::uint32_t> slab_edges;
+		std::vector<std::int32_t> suffix;
+		std::vector<std::uint8_t> ordered;
+
+		static inline
+		auto x_at(const Edge& e, double y) -> double {
+			const double dy{ double(e.upper.getY())-e.lower.getY() };
+			return e.lower.getX() + (double(e.upper.getX())-e.lower.getX())*(y-e.lower.getY())/dy;
+		}
+
+		static inline
+		auto right_of(const Edge& e, const Vector2& p) -> bool {
+			return orient2d(e.lower, e.upper, p) > 0.;
+		}
+
+		inline
+		auto build() -> void {
+			for(const auto& e : edges){
+				heights.push_back(e.lower.getY());
+				heights.push_back(e.upper.getY());
+			}
+			std::sort(heights.begin(), heights.end());
+			heights.erase(std::unique(heights.begin(), heights.end()), heights.end());
+			const auto slabs{ heights.empty() ? 0 : heights.size()-1 };
+
+			auto slab_of{ [&](float y){
+				return static_cast<std::size_t>(std::lower_bound(heights.begin(), heights.end(), y) - heights.begin());
+			}};
+			slab_start.assign(slabs+1, 0);
+			for(const auto& e : edges)
+				for(auto s{ slab_of(e.lower.getY()) }; s<slab_of(e.upper.getY()); ++s) ++slab_start[s+1];
+			for(std::size_t s{0}; s<slabs; ++s) slab_start[s+1] += slab_start[s];
+			slab_edges.resize(slab_start[slabs]);
+			std::vector<std::uint32_t> fill(slab_start.begin(), slab_start.end()-1);
+			for(std::uint32_t n{0}; n<edges.size(); ++n)
+				for(auto s{ slab_of(edges[n].lower.getY()) }; s<slab_of(edges[n].upper.getY()); ++s)
+					slab_edges[fill[s]++] = n;
+
+			suffix.resize(slab_edges.size());
+			ordered.assign(slabs, 1);
+			for(std::size_t s{0}; s<slabs; ++s){
+				auto* first{ slab_edges.data()+slab_start[s] };
+				auto* last{ slab_edges.data()+slab_start[s+1] };
+				const auto bottom{ double(heights[s]) }, top{ double(heights[s+1]) };
+				const auto middle{ (bottom+top)/2. };
+				std::sort(first, last, [&](std::uint32_t l, std::uint32_t r){
+					return x_at(edges[l], middle) < x_at(edges[r], middle);
+				});
+				// edges that swap order inside the slab cross each other
+				for(auto* e{first}; e+1<last; ++e)
+					if(x_at(edges[e[0]], bottom) > x_at(edges[e[1]], bottom)
+					|| x_at(edges[e[0]], top) > x_at(edges[e[1]], top)) ordered[s] = 0;
+				std::int32_t sum{ 0 };
+				for(auto n{ slab_start[s+1] }; n>slab_start[s]; --n){
+					sum += edges[slab_edges[n-1]].winding;
+					suffix[n-1] = sum;
+				}
+			}
+		}
+
+		inline
+		auto add_ring(const Vector2* vertices, std::size_t begin, std::size_t end) -> void {
+			for(auto n{begin}; n<end; ++n){
+				const auto& a{ vertices[n] };
+				const auto& b{ vertices[n+1 < end ? n+1 : begin] };
+				if(a.getY() == b.getY()) continue;
+				if(a.getY() < b.getY()) edges.push_back(Edge{ a, b, 1 });
+				else edges.push_back(Edge{ b, a, -1 });
+			}
+		}
+
+	public:
+		inline
+		Polygon_Slabs(const Vector2* polygon, std::size_t count){
+			add_ring(polygon, 0, count);
+			build();
+		}
+
+		/**
+		 *  Several closed rings, ring r ends before vertex ring_ends[r].
+		 *  Holes wound against their outer ring cancel its winding.
+		 */
+		inline
+		Polygon_Slabs(const Vector2* vertices, const std::uint32_t* ring_ends, std::size_t ring_count){
+			for(std::size_t r{0}; r<ring_count; ++r)
+				add_ring(vertices, r ? ring_ends[r-1] : 0, ring_ends[r]);
+			build();
+		}
+
+		inline
+		auto winding_number(const Vector2& p) const -> int {
+			const auto y{ p.getY() };
+			if(heights.empty() || y < heights.front() || y >= heights.back()) return 0;
+			const auto s{ static_cast<std::size_t>(std::upper_bound(heights.begin(), heights.end(), y) - heights.begin()) - 1 };
+			const auto begin{ slab_start[s] }, end{ slab_start[s+1] };
+			if(!ordered[s]){
+				int winding{ 0 };
+				for(auto n{begin}; n<end; ++n)
+					if(right_of(edges[slab_edges[n]], p)) winding += edges[slab_edges[n]].winding;
+				return winding;
+			}
+			const auto* first{ slab_edges.data()+begin };
+			const auto* right{ std::partition_point(first, slab_edges.data()+end, [&](std::uint32_t e){
+				return !right_of(edges[e], p);
+			})};
+			const auto n{ static_cast<std::size_t>(right-slab_edges.data()) };
+			return n < end ? suffix[n] : 0;
+		}
+
+		inline
+		auto contains(const Vector2& p) const -> bool {
+			return winding_number(p) != 0;
+		}
+
+		inline
+		auto winding_numbers(const Vector2* points, std::size_t count, std::int32_t* out,
+							 unsigned thread_count=0) const -> void {
+			parallel_for(count, 4096, [&](std::size_t begin, std::size_t end, std::size_t){
+				for(auto n{begin}; n<end; ++n) out[n] = winding_number(points[n]);
+			}, thread_count);
+		}
+
+		/**
+		 *  Nonzero rule membership, same mask layout as contains_batch.
+		 */
+		inline
+		auto contains_batch(const Vector2* points, std::size_t count, std::uint32_t* masks,
+							unsigned thread_count=0) const -> std::size_t {
+			std::atomic<std::size_t> inside{ 0 };
+			parallel_for((count+31)/32, 128, [&](std::size_t begin, std::size_t end, std::size_t){
+				std::size_t local{ 0 };
+				for(auto word{begin}; word<end; ++word){
+					const auto base{ word*32 };
+					const auto lanes{ std::min<std::size_t>(32, count-base) };
+					std::uint32_t mask{ 0 };
+					for(std::size_t l{0}; l<lanes; ++l)
+						mask |= static_cast<std::uint32_t>(winding_number(points[base+l]) != 0) << l;
+					masks[word] = mask;
+					for(auto m{mask}; m; m &= m-1) ++local;
+				}
+				inside += local;
+			}, thread_count);
+			return inside;
+		}
+	};
+
+	namespace triangulate_detail {
+		/**
+		 *  Sweep order, higher first and leftmost among equal heights.
+		 */
+		inline
+		auto above(const Vector2& p, const Vector2& q) -> bool {
+			return p.getY() > q.getY() || (p.getY() == q.getY() && p.getX() < q.getX());
+		}
+
+		inline
+		auto emit(const Vector2* vertices, std::uint32_t a, std::uint32_t b, std::uint32_t c,
+				  std::uint32_t* out, std::size_t& count) -> void {
+			if(orient2d(vertices[a], vertices[b], vertices[c]) < 0.) std::swap(b, c);
+			out[3*count] = a;
+			out[3*count+1] = b;
+			out[3*count+2] = c;
+			++count;
+		}
+
+		/**
+		 *  Left to right order of the downward boundary edges the sweep line
+		 *  cuts. They never cross, so testing the lower of the two upper
+		 *  vertices against the other edge decides. Points compare as the
+		 *  gap between the edges passing west and east of them.
+		 */
+		struct Status_Order {
+			using is_transparent = void;
+
+			const Vector2* vertices;
+			const std::uint32_t* next;
+
+			inline
+			auto side(std::uint32_t e, const Vector2& p) const -> double {
+				return orient2d(vertices[e], vertices[next[e]], p);
+			}
+
+			inline
+			auto operator()(std::uint32_t l, std::uint32_t r) const -> bool {
+				if(l == r) return false;
+				const auto lower_l{ !above(vertices[l], vertices[r]) };
+				const auto e{ lower_l ? r : l }, o{ lower_l ? l : r };
+				auto s{ side(e, vertices[o]) };
+				if(s == 0.) s = side(e, vertices[next[o]]);
+				if(s == 0.) return l < r;
+				// positive when the other edge lies east of e
+				return lower_l ? s < 0. : s > 0.;
+			}
+
+			inline
+			auto operator()(std::uint32_t e, const Vector2& p) const -> bool {
+				return side(e, p) > 0.;
+			}
+
+			inline
+			auto operator()(const Vector2& p, std::uint32_t e) const -> bool {
+				return side(e, p) < 0.;
+			}
+		};
+
+		/**
+		 *  Free list of equally sized nodes cut from chunks that live as long
+		 *  as the pool, the status set of a reused workspace allocates
+		 *  nothing once warmed up. Serves a single node type.
+		 */
+		struct Node_Pool {
+			std::size_t stride{ 0 };
+			std::vector<std::vector<std::max_align_t>> chunks;
+			std::vector<void*> free_nodes;
+
+			Node_Pool() = default;
+			Node_Pool(Node_Pool&&) = default;
+			auto operator=(Node_Pool&&) -> Node_Pool& = default;
+
+			// the free list points into the chunks, a copy starts empty
+			inline
+			Node_Pool(const Node_Pool&){}
+
+			inline
+			auto operator=(const Node_Pool&) -> Node_Pool& {
+				return *this;
+			}
+
+			inline
+			auto allocate(std::size_t size) -> void* {
+				const auto units{ (size + sizeof(std::max_align_t)-1)/sizeof(std::max_align_t) };
+				if(units != stride){
+					stride = units;
+					chunks.clear();
+					free_nodes.clear();
+				}
+				if(free_nodes.empty()){
+					constexpr std::size_t per_chunk{ 256 };
+					chunks.emplace_back(per_chunk*stride);
+					for(auto k{per_chunk}; k-- > 0;) free_nodes.push_back(chunks.back().data() + k*stride);
+				}
+				const auto node{ free_nodes.back() };
+				free_nodes.pop_back();
+				return node;
+			}
+
+			inline
+			auto release(void* node) -> void {
+				free_nodes.push_back(node);
+			}
+		};
+
+		template<typename T>
+		struct Pool_Allocator {
+			using value_type = T;
+
+			Node_Pool* pool;
+
+			inline explicit
+			Pool_Allocator(Node_Pool* pool)
+			:pool{pool}{}
+
+			template<typename U>
+			inline
+			Pool_Allocator(const Pool_Allocator<U>& other)
+			:pool{other.pool}{}
+
+			inline
+			auto allocate(std::size_t count) -> T* {
+				if(count != 1) return static_cast<T*>(::operator new(count*sizeof(T)));
+				return static_cast<T*>(pool->allocate(sizeof(T)));
+			}
+
+			inline
+			auto deallocate(T* node, std::size_t count) -> void {
+				if(count != 1) ::operator delete(node);
+				else pool->release(node);
+			}
+
+			template<typename U>
+			inline
+			auto operator==(const Pool_Allocator<U>& other) const -> bool {
+				return pool == other.pool;
+			}
+
+			template<typename U>
+			inline
+			auto operator!=(const Pool_Allocator<U>& other) const -> bool {
+				return pool != other.pool;
+			}
+		};
+
+		using Status = std::set<std::uint32_t, Status_Order, Pool_Allocator<std::uint32_t>>;
+	}
+
+	/**
+	 *  Scratch memory for triangulate_polygon. Reusing one workspace keeps
+	 *  its buffers allocated between calls.
+	 */
+	struct Triangulation_Workspace {
+		static constexpr std::uint32_t npos{ 0xffffffffu };
+
+		std::vector<std::uint32_t> next;
+		std::vector<std::uint32_t> prev;
+		std::vector<std::uint32_t> order;
+		std::vector<std::uint32_t> helper;
+		std::vector<std::uint8_t> merge;
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> diagonals;
+
+		std::vector<std::uint32_t> source;
+		std::vector<std::uint32_t> target;
+		std::vector<std::uint32_t> diagonal_start;
+		std::vector<std::uint32_t> diagonal_edges;
+		std::vector<std::uint8_t> visited;
+
+		std::vector<std::uint32_t> face;
+		std::vector<std::uint32_t> sorted;
+		std::vector<std::uint8_t> side;
+		std::vector<std::uint32_t> stack;
+		std::vector<std::uint32_t> ear_next;
+		std::vector<std::uint32_t> ear_prev;
+
+		triangulate_detail::Node_Pool status_nodes;
+		std::vector<triangulate_detail::Status::iterator> slot;
+	};
+
+	namespace triangulate_detail {
+		/**
+		 *  The edge following e around its face, the first one leaving its
+		 *  end clockwise from the way back.
+		 */
+		inline
+		auto next_edge(const Vector2* vertices, const Triangulation_Workspace& ws, std::uint32_t e) -> std::uint32_t {
+			const auto b{ ws.target[e] };
+			const auto first{ ws.diagonal_start[b] }, last{ ws.diagonal_start[b+1] };
+			if(first == last) return b;
+			const auto& pivot{ vertices[b] };
+			const auto& back{ vertices[ws.source[e]] };
+			auto half{ [&](std::uint32_t h){
+				const auto& p{ vertices[ws.target[h]] };
+				const auto s{ orient2d(pivot, back, p) };
+				if(s < 0.) return 0;
+				if(s > 0.) return 2;
+				const auto same_way{ (double(p.getX())-pivot.getX())*(double(back.getX())-pivot.getX())
+								   + (double(p.getY())-pivot.getY())*(double(back.getY())-pivot.getY()) > 0. };
+				return same_way ? 3 : 1;
+			}};
+			auto best{ b };
+			auto best_half{ half(b) };
+			for(auto n{first}; n<last; ++n){
+				const auto h{ ws.diagonal_edges[n] };
+				const auto h_half{ half(h) };
+				if(h_half < best_half
+				|| (h_half == best_half && orient2d(pivot, vertices[ws.target[h]], vertices[ws.target[best]]) < 0.)){
+					best = h;
+					best_half = h_half;
+				}
+			}
+			return best;
+		}
+
+		/**
+		 *  Stack triangulation of a y-monotone face. Returns false, writing
+		 *  nothing, when the face is not monotone.
+		 */
+		inline
+		auto monotone(const Vector2* vertices, Triangulation_Workspace& ws,
+					  std::uint32_t* out, std::size_t& count) -> bool {
+			const auto& face{ ws.face };
+			const auto m{ face.size() };
+			std::size_t top{ 0 }, bottom{ 0 };
+			for(std::size_t n{1}; n<m; ++n){
+				if(above(vertices[face[n]], vertices[face[top]])) top = n;
+				if(above(vertices[face[bottom]], vertices[face[n]])) bottom = n;
+			}
+			// counterclockwise from the top one chain descends, the other climbs back
+			for(auto n{top}; n != bottom; n = (n+1)%m)
+				if(!above(vertices[face[n]], vertices[face[(n+1)%m]])) return false;
+			for(auto n{bottom}; n != top; n = (n+1)%m)
+				if(!above(vertices[face[(n+1)%m]], vertices[face[n]])) return false;
+
+			ws.sorted.clear();
+			ws.side.clear();
+			ws.sorted.push_back(face[top]);
+			ws.side.push_back(0);
+			auto left{ (top+1)%m }, right{ (top+m-1)%m };
+			while(left != bottom || right != bottom){
+				const auto take_left{ right == bottom || (left != bottom && above(vertices[face[left]], vertices[face[right]])) };
+				ws.sorted.push_back(face[take_left ? left : right]);
+				ws.side.push_back(take_left ? 0 : 1);
+				if(take_left) left = (left+1)%m;
+				else right = (right+m-1)%m;
+			}
+			ws.sorted.push_back(face[bottom]);
+			ws.side.push_back(2);
+
+			const auto& u{ ws.sorted };
+			auto& stack{ ws.stack };
+			stack.assign({ 0, 1 });
+			for(std::uint32_t k{2}; k+1<m; ++k){
+				if(ws.side[k] != ws.side[stack.back()]){
+					while(stack.size() > 1){
+						const auto top_k{ stack.back() };
+						stack.pop_back();
+						emit(vertices, u[k], u[top_k], u[stack.back()], out, count);
+					}
+					stack.assign({ k-1, k });
+					continue;
+				}
+				auto last{ stack.back() };
+				stack.pop_back();
+				while(!stack.empty()){
+					const auto& p{ vertices[u[k]] };
+					const auto& q{ vertices[u[last]] };
+					const auto& r{ vertices[u[stack.back()]] };
+					const auto inside{ ws.side[k] == 0 ? orient2d(r, q, p) > 0. : orient2d(p, q, r) > 0. };
+					if(!inside) break;
+					emit(vertices, u[k], u[last], u[stack.back()], out, count);
+					last = stack.back();
+					stack.pop_back();
+				}
+				stack.push_back(last);
+				stack.push_back(k);
+			}
+			for(std::size_t n{0}; n+1<stack.size(); ++n)
+				emit(vertices, u[m-1], u[stack[n]], u[stack[n+1]], out, count);
+			return true;
+		}
+
+		/**
+		 *  O(m²) ear clipping of a counterclockwise face. When no ear is
+		 *  left, as on degenerate input, a vertex is cut off regardless.
+		 */
+		inline
+		auto ear_clip(const Vector2* vertices, Triangulation_Workspace& ws,
+					  std::uint32_t* out, std::size_t& count) -> void {
+			const auto& face{ ws.face };
+			const auto m{ static_cast<std::uint32_t>(face.size()) };
+			ws.ear_next.resize(m);
+			ws.ear_prev.resize(m);
+			for(std::uint32_t n{0}; n<m; ++n){
+				ws.ear_next[n] = (n+1)%m;
+				ws.ear_prev[n] = (n+m-1)%m;
+			}
+			auto is_ear{ [&](std::uint32_t p, std::uint32_t i, std::uint32_t q){
+				const auto& a{ vertices[face[p]] };
+				const auto& b{ vertices[face[i]] };
+				const auto& c{ vertices[face[q]] };
+				if(orient2d(a, b, c) <= 0.) return false;
+				for(auto j{ ws.ear_next[q] }; j != p; j = ws.ear_next[j]){
+					const auto& v{ vertices[face[j]] };
+					if(face[j] == face[p] || face[j] == face[i] || face[j] == face[q]) continue;
+					if(orient2d(a, b, v) >= 0. && orient2d(b, c, v) >= 0. && orient2d(c, a, v) >= 0.) return false;
+				}
+				return true;
+			}};
+
+			std::uint32_t i{ 0 }, remaining{ m }, stall{ 0 };
+			while(remaining > 3){
+				const auto p{ ws.ear_prev[i] }, q{ ws.ear_next[i] };
+				if(is_ear(p, i, q) || stall > remaining){
+					emit(vertices, face[p], face[i], face[q], out, count);
+					ws.ear_next[p] = q;
+					ws.ear_prev[q] = p;
+					--remaining;
+					stall = 0;
+				}
+				else ++stall;
+				i = q;
+			}
+			emit(vertices, face[ws.ear_prev[i]], face[i], face[ws.ear_next[i]], out, count);
+		}
+	}
+
+	/**
+	 *  Triangulates a polygon with holes. Ring 0 is the outer boundary,
+	 *  ring r ends before vertex ring_ends[r] and has at least three
+	 *  vertices, either orientation is accepted. Split and merge vertices
+	 *  get diagonals in one top to bottom sweep, the monotone faces are
+	 *  then cut with the stack method and any face that is not monotone
+	 *  falls back to ear clipping. O(n log n) for valid input. out
+	 *  receives counterclockwise triangles of input indices and needs room
+	 *  for 3*(n + 2*holes - 2) of them. Returns the triangle count.
+	 */
+	inline
+	auto triangulate_polygon(const Vector2* vertices, const std::uint32_t* ring_ends, std::size_t ring_count,
+							 std::uint32_t* out, Triangulation_Workspace& ws) -> std::size_t {
+		using namespace triangulate_detail;
+		constexpr auto npos{ Triangulation_Workspace::npos };
+		const auto n{ ring_count ? ring_ends[ring_count-1] : 0u };
+		if(n < 3) return 0;
+
+		// the outer ring counterclockwise and holes clockwise put the interior left of every edge
+		ws.next.resize(n);
+		ws.prev.resize(n);
+		for(std::size_t r{0}; r<ring_count; ++r){
+			const auto begin{ r ? ring_ends[r-1] : 0u }, end{ ring_ends[r] };
+			auto twice_area{ 0. };
+			for(auto v{begin}; v<end; ++v){
+				const auto& a{ vertices[v] };
+				const auto& b{ vertices[v+1 < end ? v+1 : begin] };
+				twice_area += double(a.getX())*b.getY() - double(b.getX())*a.getY();
+			}
+			const auto reverse{ (r == 0) == (twice_area < 0.) };
+			for(auto v{begin}; v<end; ++v){
+				const auto succ{ v+1 < end ? v+1 : begin };
+				const auto pred{ v > begin ? v-1 : end-1 };
+				ws.next[v] = reverse ? pred : succ;
+				ws.prev[v] = reverse ? succ : pred;
+			}
+		}
+
+		ws.order.resize(n);
+		for(std::uint32_t v{0}; v<n; ++v) ws.order[v] = v;
+		std::sort(ws.order.begin(), ws.order.end(), [&](std::uint32_t l, std::uint32_t r){
+			return above(vertices[l], vertices[r]);
+		});
+		ws.helper.assign(n, npos);
+		ws.merge.assign(n, 0);
+		ws.diagonals.clear();
+		Status status(Status_Order{ vertices, ws.next.data() }, Pool_Allocator<std::uint32_t>(&ws.status_nodes));
+		auto& slot{ ws.slot };
+		slot.assign(n, status.end());
+		for(auto v : ws.order){
+			const auto p{ ws.prev[v] }, q{ ws.next[v] };
+			const auto& pv{ vertices[v] };
+			const auto p_below{ above(pv, vertices[p]) }, q_below{ above(pv, vertices[q]) };
+			const auto convex{ orient2d(vertices[p], pv, vertices[q]) > 0. };
+			auto resolve{ [&](std::uint32_t e){
+				if(ws.helper[e] != npos && ws.merge[ws.helper[e]]) ws.diagonals.emplace_back(v, ws.helper[e]);
+			}};
+			auto remove{ [&](std::uint32_t e){
+				if(slot[e] == status.end()) return;
+				status.erase(slot[e]);
+				slot[e] = status.end();
+			}};
+			auto help_left{ [&](bool split){
+				const auto right{ status.lower_bound(pv) };
+				if(right == status.begin()) return;
+				const auto e{ *std::prev(right) };
+				if(split) ws.diagonals.emplace_back(v, ws.helper[e]);
+				else resolve(e);
+				ws.helper[e] = v;
+			}};
+
+			if(p_below && q_below){
+				// start or split
+				if(!convex) help_left(true);
+				slot[v] = status.insert(v).first;
+				ws.helper[v] = v;
+			}
+			else if(!p_below && !q_below){
+				// end or merge
+				resolve(p);
+				remove(p);
+				if(!convex){
+					ws.merge[v] = 1;
+					help_left(false);
+				}
+			}
+			else if(!p_below){
+				// on a left chain, the interior is to the right
+				resolve(p);
+				remove(p);
+				slot[v] = status.insert(v).first;
+				ws.helper[v] = v;
+			}
+			else help_left(false);
+		}
+
+		// faces of the boundary plus diagonals, edge v leaves v along the ring
+		const auto diagonal_count{ static_cast<std::uint32_t>(ws.diagonals.size()) };
+		const auto edge_count{ n + 2*diagonal_count };
+		ws.source.resize(edge_count);
+		ws.target.resize(edge_count);
+		ws.diagonal_start.assign(n+1, 0);
+		ws.diagonal_edges.resize(2*diagonal_count);
+		for(std::uint32_t v{0}; v<n; ++v){
+			ws.source[v] = v;
+			ws.target[v] = ws.next[v];
+		}
+		for(const auto& d : ws.diagonals){
+			++ws.diagonal_start[d.first+1];
+			++ws.diagonal_start[d.second+1];
+		}
+		for(std::uint32_t v{0}; v<n; ++v) ws.diagonal_start[v+1] += ws.diagonal_start[v];
+		ws.stack.assign(ws.diagonal_start.begin(), ws.diagonal_start.end()-1);
+		for(std::uint32_t k{0}; k<diagonal_count; ++k){
+			const auto a{ ws.diagonals[k].first }, b{ ws.diagonals[k].second };
+			const auto h{ n + 2*k };
+			ws.source[h] = a;
+			ws.target[h] = b;
+			ws.source[h+1] = b;
+			ws.target[h+1] = a;
+			ws.diagonal_edges[ws.stack[a]++] = h;
+			ws.diagonal_edges[ws.stack[b]++] = h+1;
+		}
+
+		std::size_t count{ 0 };
+		ws.visited.assign(edge_count, 0);
+		for(std::uint32_t h{0}; h<edge_count; ++h){
+			if(ws.visited[h]) continue;
+			ws.face.clear();
+			auto e{ h };
+			do{
+				ws.visited[e] = 1;
+				ws.face.push_back(ws.source[e]);
+				e = next_edge(vertices, ws, e);
+			} while(e != h && !ws.visited[e]);
+			if(ws.face.size() < 3) continue;
+			if(ws.face.size() == 3) emit(vertices, ws.face[0], ws.face[1], ws.face[2], out, count);
+			else if(!monotone(vertices, ws, out, count)) ear_clip(vertices, ws, out, count);
+		}
+		return count;
+	}
+
+	inline
+	auto triangulate_polygon(const Vector2* vertices, const std::uint32_t* ring_ends, std::size_t ring_count,
+							 std::uint32_t* out) -> std::size_t {
+		Triangulation_Workspace ws;
+		return triangulate_polygon(vertices, ring_ends, ring_count, out, ws);
+	}
+
+	/**
+	 *  Simple polygon without holes, out needs room for 3*(count-2).
+	 */
+	inline
+	auto triangulate_polygon(const Vector2* polygon, std::size_t count, std::uint32_t* out,
+							 Triangulation_Workspace& ws) -> std::size_t {
+		const auto end{ static_cast<std::uint32_t>(count) };
+		return triangulate_polygon(polygon, &end, 1, out, ws);
 	}
 }
 }
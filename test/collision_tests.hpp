@@ -0,0 +1,271 @@
+#pragma once
+
+#include "../header/dropMath.hpp"
+#include "Timer.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+inline
+auto collision_tests() -> bool {
+	{
+		using Vector3 = drop::math::Vector3;
+		using Line3 = drop::math::Line3;
+		auto segments{ Timer("Line3 Closest Points") };
+
+		auto a{ Line3(Vector3(0.f, 0.f, 0.f), Vector3(4.f, 0.f, 0.f)) };
+		auto b{ Line3(Vector3(1.f, 2.f, -1.f), Vector3(1.f, 2.f, 1.f)) };
+		float s, t;
+		const auto d2{ a.closest_points(b, s, t) };
+		std::cout << "Segments are " << std::sqrt(d2) << " apart at s = " << s
+				  << ", t = " << t << std::endl;
+		if(std::fabs(d2-4.f) > 0.0001f || std::fabs(s-0.25f) > 0.0001f
+		|| std::fabs(t-0.5f) > 0.0001f) return false;
+
+		if(a.closest_point(Vector3(-3.f, 1.f, 0.f)) != Vector3(0.f, 0.f, 0.f)) return false;
+		if(std::fabs(a.squared_distance(Vector3(2.f, 3.f, 4.f)) - 25.f) > 0.0001f) return false;
+
+		// brute force sampling never finds points closer than closest_points
+		for(int n{0}; n<200; ++n){
+			auto random{ []{ return Vector3(rand()%200*0.05f-5.f, rand()%200*0.05f-5.f, rand()%200*0.05f-5.f); } };
+			auto p{ Line3(random(), random()) };
+			auto q{ Line3(random(), random()) };
+			const auto best{ p.closest_points(q, s, t) };
+			for(int i{0}; i<=20; ++i)
+				for(int j{0}; j<=20; ++j){
+					const auto x{ p.getFrom() + p.getDir()*(i/20.f) };
+					const auto y{ q.getFrom() + q.getDir()*(j/20.f) };
+					if((x-y).squared_length() < best - 0.0001f) return false;
+				}
+		}
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		using Matrix_3x3 = drop::math::Matrix_3x3;
+		using Sphere = drop::math::Sphere;
+		using Capsule = drop::math::Capsule;
+		using OBB = drop::math::OBB;
+		auto shapes{ Timer("Sphere, Capsule and OBB Overlaps") };
+
+		const auto c{ std::cos(drop::math::PI/4.f) }, sn{ std::sin(drop::math::PI/4.f) };
+		auto rotated{ Matrix_3x3(Vector3(c, sn, 0.f), Vector3(-sn, c, 0.f), Vector3(0.f, 0.f, 1.f)) };
+		auto diamond{ OBB(Vector3(0.f, 0.f, 0.f), rotated, Vector3(1.f, 1.f, 1.f)) };
+		auto box{ OBB(Vector3(2.5f, 0.f, 0.f), Matrix_3x3::identity(), Vector3(1.f, 1.f, 1.f)) };
+		if(intersects(diamond, box)) return false;
+		auto closer{ OBB(Vector3(2.3f, 0.f, 0.f), Matrix_3x3::identity(), Vector3(1.f, 1.f, 1.f)) };
+		if(!intersects(diamond, closer)) return false;
+
+		if(!intersects(Sphere(Vector3(0.f, 0.f, 0.f), 1.f), Sphere(Vector3(1.5f, 0.f, 0.f), 0.6f))) return false;
+		if(intersects(Sphere(Vector3(0.f, 3.f, 0.f), 1.f), Capsule(Vector3(-5.f, 0.f, 0.f), Vector3(5.f, 0.f, 0.f), 1.9f))) return false;
+		if(!intersects(Capsule(Vector3(-5.f, 0.f, 0.f), Vector3(5.f, 0.f, 0.f), 1.f),
+					   Capsule(Vector3(0.f, 1.5f, -5.f), Vector3(0.f, 1.5f, 5.f), 0.6f))) return false;
+
+		// capsule passing the diamond's corner at (sqrt 2, 0) from above
+		auto past_corner{ Capsule(Vector3(1.6f, -3.f, 1.5f), Vector3(1.6f, 3.f, 1.5f), 0.5f) };
+		if(intersects(past_corner, diamond)) return false;
+		auto touching{ Capsule(Vector3(1.6f, -3.f, 1.2f), Vector3(1.6f, 3.f, 1.2f), 0.3f) };
+		if(!intersects(diamond, touching)) return false;
+
+		// every pair against a sampled reference
+		std::vector<Vector3> grid;
+		for(int x{-30}; x<=30; ++x)
+			for(int y{-30}; y<=30; ++y)
+				for(int z{-30}; z<=30; ++z)
+					grid.emplace_back(x*0.1f, y*0.1f, z*0.1f);
+		auto sampled{ [&](auto&& in_a, auto&& in_b){
+			for(auto& p : grid) if(in_a(p) && in_b(p)) return true;
+			return false;
+		}};
+		std::size_t checked{ 0 };
+		for(int n{0}; n<60; ++n){
+			auto random{ [](float range){ return Vector3((rand()%200-100)*0.01f*range,
+				(rand()%200-100)*0.01f*range, (rand()%200-100)*0.01f*range); } };
+			auto axis{ random(1.f) };
+			if(axis.squared_length() < 0.01f) continue;
+			axis._normalize();
+			auto side{ axis.cross_prod(Vector3(0.3f, 0.9f, 0.1f)) };
+			if(side.squared_length() < 0.01f) continue;
+			side._normalize();
+			auto orientation{ Matrix_3x3(axis, side, axis.cross_prod(side)) };
+			auto obb{ OBB(random(1.f), orientation, Vector3(0.3f+rand()%10*0.1f, 0.3f, 0.5f)) };
+			auto sphere{ Sphere(random(1.5f), 0.3f+rand()%10*0.1f) };
+			auto capsule{ Capsule(random(2.f), random(2.f), 0.2f+rand()%5*0.1f) };
+			auto in_obb{ [&](const Vector3& p){ return obb.contains(p); } };
+			auto in_sphere{ [&](const Vector3& p){ return sphere.contains(p); } };
+			auto in_capsule{ [&](const Vector3& p){ return capsule.contains(p); } };
+
+			// sampling can only miss thin overlaps, never report false ones
+			if(sampled(in_obb, in_sphere) && !intersects(sphere, obb)) return false;
+			if(sampled(in_obb, in_capsule) && !intersects(capsule, obb)) return false;
+			if(sampled(in_sphere, in_capsule) && !intersects(sphere, capsule)) return false;
+			auto shrunk{ Capsule(capsule.getSegment(), capsule.getRadius()+0.2f) };
+			if(intersects(capsule, obb) && !sampled(in_obb, [&](const Vector3& p){ return shrunk.contains(p); }))
+				return false;
+			++checked;
+		}
+		std::cout << checked << " random shape triples agree with sampling" << std::endl;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		using Line3 = drop::math::Line3;
+		using Capsule = drop::math::Capsule;
+		using Sphere = drop::math::Sphere;
+		auto hitreg{ Timer("Shot vs 10k Capsules") };
+
+		std::vector<Capsule> players;
+		std::vector<float> fx, fy, fz, dx, dy, dz, radii;
+		for(int n{0}; n<10000; ++n){
+			auto feet{ Vector3(rand()%1000*0.1f, 0.f, rand()%1000*0.1f) };
+			auto head{ feet + Vector3(rand()%5*0.1f, 1.8f, 0.f) };
+			players.emplace_back(feet, head, 0.4f);
+			fx.push_back(feet.getX()); fy.push_back(feet.getY()); fz.push_back(feet.getZ());
+			const auto d{ head-feet };
+			dx.push_back(d.getX()); dy.push_back(d.getY()); dz.push_back(d.getZ());
+			radii.push_back(0.4f);
+		}
+		auto shot{ Line3(Vector3(0.f, 1.f, 0.f), Vector3(100.f, 1.2f, 100.f)) };
+
+		std::vector<std::uint32_t> masks((players.size()+31)/32), soa_masks(masks.size());
+		const auto hits{ drop::math::intersects_batch(shot, players.data(), players.size(), masks.data()) };
+		const auto soa_hits{ drop::math::intersects_batch(shot, fx.data(), fy.data(), fz.data(),
+			dx.data(), dy.data(), dz.data(), radii.data(), players.size(), soa_masks.data()) };
+		std::cout << "The shot passes through " << hits << " players" << std::endl;
+		if(hits != soa_hits || masks != soa_masks) return false;
+		for(std::size_t n{0}; n<players.size(); ++n)
+			if(((masks[n/32] >> (n%32)) & 1u) != intersects(shot, players[n])) return false;
+
+		auto blast{ Sphere(Vector3(50.f, 0.f, 50.f), 5.f) };
+		drop::math::intersects_batch(blast, players.data(), players.size(), masks.data());
+		for(std::size_t n{0}; n<players.size(); ++n)
+			if(((masks[n/32] >> (n%32)) & 1u) != intersects(blast, players[n])) return false;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		using Matrix_3x3 = drop::math::Matrix_3x3;
+		using Sphere = drop::math::Sphere;
+		using OBB = drop::math::OBB;
+		auto gjk{ Timer("GJK/EPA") };
+
+		auto a{ Sphere(Vector3(0.f, 0.f, 0.f), 1.f) };
+		auto b{ Sphere(Vector3(3.f, 4.f, 0.f), 2.f) };
+		const auto far{ drop::math::gjk_distance(a, b) };
+		std::cout << "Sphere distance: " << far.distance << std::endl;
+		if(far.intersecting || std::fabs(far.distance - 2.f) > 1e-3f) return false;
+
+		auto c{ Sphere(Vector3(1.5f, 0.f, 0.f), 1.f) };
+		drop::math::GJK_Simplex simplex;
+		const auto overlap{ drop::math::gjk_penetration(a, c, simplex) };
+		std::cout << "Sphere penetration: " << overlap.depth << " along " << overlap.normal << std::endl;
+		if(!overlap.valid || std::fabs(overlap.depth - 0.5f) > 2e-2f) return false;
+		if(overlap.normal.getX() < 0.95f) return false;
+
+		auto box{ OBB(drop::math::AABB3(Vector3(-1.f, -1.f, -1.f), Vector3(1.f, 1.f, 1.f))) };
+		auto shifted{ OBB(drop::math::AABB3(Vector3(0.7f, -0.5f, -0.5f), Vector3(1.7f, 0.5f, 0.5f))) };
+		const auto boxes{ drop::math::gjk_penetration(box, shifted, simplex) };
+		std::cout << "Box penetration: " << boxes.depth << " along " << boxes.normal << std::endl;
+		if(!boxes.valid || std::fabs(boxes.depth - 0.3f) > 1e-3f) return false;
+
+		// random boxes agree with the SAT test
+		int checked{ 0 };
+		for(int n{0}; n<500; ++n){
+			const auto angle{ rand()%628*0.01f };
+			const auto rotation{ Matrix_3x3(
+				cosf(angle), -sinf(angle), 0.f,
+				sinf(angle), cosf(angle), 0.f,
+				0.f, 0.f, 1.f) };
+			auto p{ OBB(Vector3(rand()%40*0.1f, rand()%40*0.1f, rand()%40*0.1f), rotation,
+						Vector3(0.5f + rand()%10*0.1f, 0.5f, 0.5f + rand()%5*0.1f)) };
+			auto q{ OBB(Vector3(rand()%40*0.1f, rand()%40*0.1f, rand()%40*0.1f), Matrix_3x3(),
+						Vector3(0.5f, 0.5f + rand()%10*0.1f, 0.5f)) };
+			const auto result{ drop::math::gjk_distance(p, q) };
+			if(result.intersecting != intersects(p, q)){
+				// disagreements are only allowed at grazing contact
+				if(result.distance > 1e-3f) return false;
+				continue;
+			}
+			if(!result.intersecting && std::fabs(sqrtf(p.squared_distance(result.point_b)) - result.distance) > 1e-3f)
+				return false;
+			++checked;
+		}
+		std::cout << checked << " random box pairs agree with SAT" << std::endl;
+
+		// a sphere sliding past a box reuses last frame's simplex
+		int cold{ 0 }, warm{ 0 };
+		drop::math::GJK_Simplex cached;
+		for(int frame{0}; frame<100; ++frame){
+			auto moving{ Sphere(Vector3(-3.f + frame*0.06f, 2.f, 0.3f), 0.5f) };
+			drop::math::GJK_Simplex fresh;
+			const auto r0{ drop::math::gjk_distance(box, moving, fresh) };
+			const auto r1{ drop::math::gjk_distance(box, moving, cached) };
+			if(std::fabs(r0.distance - r1.distance) > 1e-3f) return false;
+			cold += r0.iterations;
+			warm += r1.iterations;
+		}
+		std::cout << "Iterations cold: " << cold << " warm: " << warm << std::endl;
+		if(warm > cold) return false;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		using AABB3 = drop::math::AABB3;
+		using Sphere = drop::math::Sphere;
+		using OBB = drop::math::OBB;
+		auto swept{ Timer("Swept Shapes") };
+
+		auto ball{ Sphere(Vector3(0.2f, 5.f, 0.2f), 1.f) };
+		const auto down{ Vector3(0.f, -10.f, 0.f) };
+		const auto floor{ drop::math::Normal_Plane3(Vector3(0.f, 1.f, 0.f), Vector3(0.f, 0.f, 0.f)) };
+		if(std::fabs(drop::math::sweep(ball, down, floor) - 0.4f) > 1e-5f) return false;
+
+		const auto v0{ Vector3(0.f, 0.f, 0.f) }, v1{ Vector3(1.f, 0.f, 0.f) }, v2{ Vector3(0.f, 0.f, 1.f) };
+		if(std::fabs(drop::math::sweep(ball, down, v0, v1, v2) - 0.4f) > 1e-5f) return false;
+		const auto edge{ drop::math::sweep(Sphere(Vector3(-0.5f, 5.f, 0.5f), 1.f), down, v0, v1, v2) };
+		std::cout << "Edge contact at: " << edge << std::endl;
+		if(std::fabs(edge - (5.f - sqrtf(0.75f))/10.f) > 1e-4f) return false;
+
+		// a fast bullet against a thin wall does not tunnel
+		auto wall{ AABB3(Vector3(10.f, -5.f, -5.f), Vector3(10.01f, 5.f, 5.f)) };
+		auto bullet{ Sphere(Vector3(0.f, 0.f, 0.f), 0.05f) };
+		const auto bullet_t{ drop::math::sweep(bullet, Vector3(1000.f, 0.f, 0.f), wall) };
+		if(std::fabs(bullet_t - 9.95f/1000.f) > 1e-5f) return false;
+
+		const auto crate{ AABB3(Vector3(0.f, 0.f, 0.f), Vector3(1.f, 1.f, 1.f)) };
+		const auto box_t{ drop::math::sweep(crate, Vector3(10.f, 0.f, 0.f),
+			AABB3(Vector3(5.f, 0.5f, 0.f), Vector3(6.f, 1.5f, 1.f))) };
+		if(std::fabs(box_t - 0.4f) > 1e-5f) return false;
+
+		// random sweeps agree with stepping the discrete test
+		const auto box{ AABB3(Vector3(-1.f, -0.5f, -2.f), Vector3(1.f, 0.5f, 2.f)) };
+		const auto obb{ OBB(box) };
+		std::vector<Sphere> balls;
+		std::vector<Vector3> motions;
+		for(int n{0}; n<300; ++n){
+			balls.emplace_back(Vector3(rand()%100*0.1f-5.f, rand()%100*0.1f-5.f, rand()%100*0.1f-5.f),
+							   0.2f + rand()%10*0.1f);
+			motions.emplace_back(rand()%200*0.1f-10.f, rand()%200*0.1f-10.f, rand()%200*0.1f-10.f);
+		}
+		std::vector<float> fractions(balls.size()), advanced(balls.size());
+		const auto hits{ drop::math::sweep_batch(balls.data(), motions.data(), balls.size(), box,
+												 fractions.data(), 4) };
+		drop::math::time_of_impact_batch(balls.data(), motions.data(), balls.size(), obb,
+										 advanced.data(), 4);
+		for(std::size_t n{0}; n<balls.size(); ++n){
+			auto first{ drop::math::inf };
+			for(int step{0}; step<=2000; ++step){
+				const auto t{ step/2000.f };
+				if(intersects(Sphere(balls[n].getCenter() + motions[n]*t, balls[n].getRadius()), obb)){
+					first = t;
+					break;
+				}
+			}
+			if(fractions[n] != drop::math::sweep(balls[n], motions[n], box)) return false;
+			if(first == drop::math::inf){
+				if(fractions[n] <= 1.f && fractions[n] < 0.999f) return false;
+				continue;
+			}
+			if(fractions[n] > first + 1e-3f || fractions[n] < first - 1e-3f) return false;
+			if(std::fabs(advanced[n] - fractions[n]) > 1e-3f) return false;
+		}
+		std::cout << hits << " of " << balls.size() << " swept spheres hit the box" << std::endl;
+	}
+	return true;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "../header/dropMath.hpp"
+#include "Timer.hpp"
+
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+inline
+auto curve_tests() -> bool {
+	using Vector2 = drop::math::Vector2;
+	using Vector3 = drop::math::Vector3;
+	auto random{ []{ return rand()%2000*0.01f-10.f; } };
+	auto close{ [](const auto& a, const auto& b, float tolerance){
+		return (a-b).length() <= tolerance;
+	}};
+	{
+		auto evaluation{ Timer("Curve Evaluation") };
+
+		const auto p0{ Vector3(0.f, 0.f, 0.f) }, p1{ Vector3(1.f, 2.f, 0.f) };
+		const auto p2{ Vector3(3.f, 2.f, 1.f) }, p3{ Vector3(4.f, 0.f, -1.f) };
+		for(int n{0}; n<=20; ++n){
+			const auto t{ n/20.f };
+			// de Casteljau as reference
+			const auto a{ p0 + (p1-p0)*t }, b{ p1 + (p2-p1)*t }, c{ p2 + (p3-p2)*t };
+			const auto ab{ a + (b-a)*t }, bc{ b + (c-b)*t };
+			if(!close(drop::math::quadratic_bezier(p0, p1, p2, t), ab, 1e-5f)) return false;
+			if(!close(drop::math::cubic_bezier(p0, p1, p2, p3, t), ab + (bc-ab)*t, 1e-5f)) return false;
+			if(std::fabs(drop::math::quadratic_bezier(0.f, 1.f, 4.f, t) - (2.f*(1.f-t)*t + 4.f*t*t)) > 1e-5f) return false;
+
+			// derivatives against central differences
+			const auto h{ 1e-2f };
+			const auto d{ (drop::math::cubic_bezier(p0, p1, p2, p3, t+h) - drop::math::cubic_bezier(p0, p1, p2, p3, t-h))*(.5f/h) };
+			if(!close(drop::math::cubic_bezier_derivative(p0, p1, p2, p3, t), d, 1e-2f)) return false;
+			const auto dd{ (drop::math::cubic_bezier_derivative(p0, p1, p2, p3, t+h)
+						  - drop::math::cubic_bezier_derivative(p0, p1, p2, p3, t-h))*(.5f/h) };
+			if(!close(drop::math::cubic_bezier_second_derivative(p0, p1, p2, p3, t), dd, 1e-2f)) return false;
+			const auto dq{ (drop::math::quadratic_bezier(p0, p1, p2, t+h) - drop::math::quadratic_bezier(p0, p1, p2, t-h))*(.5f/h) };
+			if(!close(drop::math::quadratic_bezier_derivative(p0, p1, p2, t), dq, 1e-2f)) return false;
+
+			// Catmull-Rom through its Bezier and Hermite forms
+			Vector3 control[4];
+			drop::math::catmull_rom_to_bezier(p0, p1, p2, p3, control);
+			const auto spline{ drop::math::catmull_rom(p0, p1, p2, p3, t) };
+			if(!close(drop::math::cubic_bezier(control[0], control[1], control[2], control[3], t), spline, 1e-5f)) return false;
+			if(!close(drop::math::cubic_bezier_derivative(control[0], control[1], control[2], control[3], t),
+					  drop::math::catmull_rom_derivative(p0, p1, p2, p3, t), 1e-4f)) return false;
+		}
+		if(!close(drop::math::catmull_rom(p0, p1, p2, p3, 0.f), p1, 1e-6f)
+		|| !close(drop::math::catmull_rom(p0, p1, p2, p3, 1.f), p2, 1e-6f)) return false;
+		const auto m0{ Vector2(1.f, 3.f) }, m1{ Vector2(-2.f, 1.f) };
+		const auto from{ Vector2(0.f, 0.f) }, to{ Vector2(5.f, 1.f) };
+		if(!close(drop::math::hermite(from, m0, to, m1, 1.f), to, 1e-6f)
+		|| !close(drop::math::hermite_derivative(from, m0, to, m1, 0.f), m0, 1e-6f)
+		|| !close(drop::math::hermite_derivative(from, m0, to, m1, 1.f), m1, 1e-6f)) return false;
+	}
+	{
+		auto batched{ Timer("Batched Curve Evaluation") };
+
+		const std::size_t count{ 100000 };
+		std::vector<Vector2> control;
+		std::vector<float> t;
+		for(std::size_t n{0}; n<count; ++n){
+			for(int k{0}; k<4; ++k) control.emplace_back(random(), random());
+			t.push_back(rand()%1001*0.001f);
+		}
+		std::vector<Vector2> points(count), tangents(count);
+		drop::math::cubic_bezier_batch(control.data(), t.data(), count, points.data(), tangents.data(), 4);
+		for(std::size_t n{0}; n<count; ++n){
+			const auto* c{ control.data()+4*n };
+			if(!close(points[n], drop::math::cubic_bezier(c[0], c[1], c[2], c[3], t[n]), 1e-3f)) return false;
+			if(!close(tangents[n], drop::math::cubic_bezier_derivative(c[0], c[1], c[2], c[3], t[n]), 1e-3f)) return false;
+		}
+
+		const auto p0{ Vector3(random(), random(), random()) }, p1{ Vector3(random(), random(), random()) };
+		const auto p2{ Vector3(random(), random(), random()) }, p3{ Vector3(random(), random(), random()) };
+		std::vector<Vector3> samples(count);
+		drop::math::cubic_bezier_batch(p0, p1, p2, p3, t.data(), count, samples.data(), nullptr, 4);
+		for(std::size_t n{0}; n<count; ++n)
+			if(!close(samples[n], drop::math::cubic_bezier(p0, p1, p2, p3, t[n]), 1e-3f)) return false;
+	}
+	{
+		auto arc_length{ Timer("Arc Length Tables") };
+
+		const auto p0{ Vector2(0.f, 0.f) }, p1{ Vector2(10.f, 40.f) }, p2{ Vector2(50.f, -20.f) }, p3{ Vector2(60.f, 30.f) };
+		const auto table{ drop::math::Arc_Length_Table(p0, p1, p2, p3, 32) };
+		// reference length from a fine polyline
+		auto reference{ 0. };
+		const int steps{ 100000 };
+		for(int n{0}; n<steps; ++n)
+			reference += (drop::math::cubic_bezier(p0, p1, p2, p3, (n+1.f)/steps)
+						- drop::math::cubic_bezier(p0, p1, p2, p3, float(n)/steps)).length();
+		std::cout << "Arc length " << table.length() << ", polyline " << reference << std::endl;
+		if(std::fabs(table.length()-reference) > 1e-3*reference) return false;
+
+		// equal arc length steps give equal chords, forwards and back
+		const std::size_t count{ 1000 };
+		std::vector<float> distances(count), t(count);
+		for(std::size_t n{0}; n<count; ++n) distances[n] = table.length()*n/(count-1);
+		table.parameters(distances.data(), count, t.data(), 4);
+		const auto chord{ table.length()/(count-1) };
+		drop::math::Arc_Length_Table::Cursor cursor;
+		for(std::size_t n{1}; n<count; ++n){
+			const auto step{ (drop::math::cubic_bezier(p0, p1, p2, p3, t[n]) - drop::math::cubic_bezier(p0, p1, p2, p3, t[n-1])).length() };
+			if(std::fabs(step-chord) > 1e-2f*chord || t[n] < t[n-1]) return false;
+			if(std::fabs(table.distance(t[n])-distances[n]) > 1e-3f*table.length()) return false;
+			if(table.parameter(distances[count-1-n], cursor) != t[count-1-n]) return false;
+		}
+
+		// a cusp, the speed is zero halfway
+		const auto cusp{ drop::math::Arc_Length_Table(Vector3(0.f, 0.f, 0.f), Vector3(2.f, 2.f, 0.f), Vector3(0.f, 0.f, 0.f), 16) };
+		if(std::fabs(cusp.length() - 2.f*std::sqrt(2.f)) > 1e-3f) return false;
+		for(std::size_t n{1}; n<count; ++n)
+			if(cusp.parameter(cusp.length()*n/count) < cusp.parameter(cusp.length()*(n-1)/count)) return false;
+
+		std::stringstream baked;
+		baked << table;
+		drop::math::Arc_Length_Table loaded;
+		if(!(baked >> loaded) || loaded.getSegments() != 32 || loaded.length() != table.length()) return false;
+		for(std::size_t n{0}; n<count; ++n)
+			if(loaded.parameter(distances[n]) != t[n]) return false;
+		std::stringstream broken("3 0 1");
+		if(broken >> loaded || loaded.getSegments() != 32) return false;
+		std::stringstream negative("-1 0 1"), huge("100000000000 0 1");
+		if(negative >> loaded || huge >> loaded || loaded.getSegments() != 32) return false;
+	}
+	{
+		using Line2 = drop::math::Line2;
+		using Line3 = drop::math::Line3;
+		auto flattening{ Timer("Curve Flattening") };
+
+		// straight for most of its length, then a tight hook
+		const auto p0{ Vector2(0.f, 0.f) }, p1{ Vector2(80.f, 0.f) }, p2{ Vector2(100.f, 0.f) }, p3{ Vector2(100.f, 20.f) };
+		const auto tolerance{ 0.05f };
+		const auto bound{ drop::math::flatten_bound(p0, p1, p2, p3, tolerance) };
+		std::vector<Line2> polyline(bound, Line2(p0, p0));
+		const auto segments{ drop::math::flatten_bezier(p0, p1, p2, p3, tolerance, polyline.data()) };
+		std::cout << segments << " segments, uniform bound " << bound << std::endl;
+		if(segments >= bound || !close(polyline[0].getFrom(), p0, 0.f) || !close(polyline[segments-1].getTo(), p3, 0.f)) return false;
+		for(std::size_t n{1}; n<segments; ++n)
+			if(!close(polyline[n-1].getTo(), polyline[n].getFrom(), 0.f)) return false;
+		// every curve point lies within tolerance of the polyline
+		for(int n{0}; n<=1000; ++n){
+			const auto q{ drop::math::cubic_bezier(p0, p1, p2, p3, n/1000.f) };
+			auto nearest{ drop::math::inf };
+			for(std::size_t k{0}; k<segments; ++k){
+				const auto a{ polyline[k].getFrom() }, d{ polyline[k].getTo()-a };
+				const auto along{ std::min(std::max((q-a).dot_prod(d)/std::max(d.squared_length(), 1e-12f), 0.f), 1.f) };
+				nearest = std::min(nearest, (a + d*along - q).length());
+			}
+			if(nearest > tolerance*1.01f) return false;
+		}
+
+		// many curves at once match one at a time
+		const std::size_t count{ 20000 };
+		std::vector<Vector3> control;
+		for(std::size_t n{0}; n<count*3; ++n) control.emplace_back(random(), random(), random());
+		const auto room{ drop::math::flatten_beziers_bound<2>(control.data(), count, 0.01f) };
+		const auto origin{ Vector3(0.f, 0.f, 0.f) };
+		std::vector<Line3> lines(room, Line3(origin, origin)), single(1 << 16, Line3(origin, origin));
+		std::vector<std::uint32_t> first(count+1);
+		const auto total{ drop::math::flatten_beziers<2>(control.data(), count, 0.01f, lines.data(), first.data(), 4) };
+		std::cout << total << " segments for " << count << " quadratics, room for " << room << std::endl;
+		if(first[count] != total || total > room) return false;
+		for(std::size_t n{0}; n<count; ++n){
+			const auto* c{ control.data()+3*n };
+			const auto size{ drop::math::flatten_bezier(c[0], c[1], c[2], 0.01f, single.data()) };
+			if(size != first[n+1]-first[n]) return false;
+			for(std::size_t k{0}; k<size; ++k)
+				if(!close(single[k].getFrom(), lines[first[n]+k].getFrom(), 0.f)
+				|| !close(single[k].getTo(), lines[first[n]+k].getTo(), 0.f)) return false;
+		}
+	}
+	return true;
+}
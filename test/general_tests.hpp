@@ -2,6 +2,7 @@
 
 #include "../header/dropMath.hpp"
 #include "Timer.hpp"
+#include <cassert>
 
 bool general_tests(){
 	{
@@ -196,5 +197,33 @@ bool general_tests(){
 
 		std::cout << "Searched Vector is: " << res << std::endl;
 	}
+	{
+		using Matrix_2x3 = drop::math::Matrix_2x3;
+		using Vector2 = drop::math::Vector2;
+		using Rect = drop::math::Rect;
+
+		auto affine{ Timer("Matrix_2x3 Affine Tests") };
+
+		auto move{ Matrix_2x3::translation({3.f, -2.f}) };
+		auto scale{ Matrix_2x3::scale(2.f, 4.f) };
+		auto m{ move*scale };
+
+		std::cout << "Scale then translate:\n" << m << std::endl;
+		assert(m.applyTo(Vector2(1.f, 1.f)) == Vector2(5.f, 2.f));
+		if(m.inverted().applyTo(Vector2(5.f, 2.f)) != Vector2(1.f, 1.f)) return false;
+		if(m*m.inverted() != Matrix_2x3::identity()) return false;
+
+		Vector2 points[3]{ {0.f, 0.f}, {1.f, 0.f}, {0.f, 1.f} };
+		Vector2 moved[3];
+		m.transform_points(points, moved, 3);
+		for(int n{0}; n<3; ++n)
+			if(moved[n] != m.applyTo(points[n])) return false;
+
+		Rect rects[1]{ Rect(0.f, 0.f, 1.f, 1.f) };
+		Vector2 corners[4];
+		drop::math::transform_rects(m, rects, corners, 1);
+		if(corners[0] != Vector2(3.f, -2.f)) return false;
+		if(corners[2] != Vector2(5.f, 2.f)) return false;
+	}
 	return true;
 }
@@ -0,0 +1,534 @@
+#pragma once
+
+#include "../header/dropMath.hpp"
+#include "Timer.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+inline
+auto geometry_tests() -> bool {
+	{
+		using Vector2 = drop::math::Vector2;
+		using Line2 = drop::math::Line2;
+		auto segments{ Timer("Segment Intersection") };
+
+		auto a{ Line2(Vector2(0.f, 0.f), Vector2(4.f, 4.f)) };
+		auto b{ Line2(Vector2(0.f, 4.f), Vector2(4.f, 0.f)) };
+		auto c{ Line2(Vector2(5.f, 5.f), Vector2(6.f, 6.f)) };
+		auto d{ Line2(Vector2(2.f, 2.f), Vector2(8.f, 8.f)) };
+		auto e{ Line2(Vector2(4.f, 4.f), Vector2(5.f, 0.f)) };
+		std::cout << "Crossing at: " << a.intersect_point(b) << std::endl;
+		if(!a.intersects(b) || std::fabs(a.intersect_fraction(b) - 0.5f) > 1e-6f) return false;
+		if(a.intersects(c) || a.intersect_fraction(c) != drop::math::inf) return false;
+		if(!a.intersects(d) || std::fabs(a.intersect_fraction(d) - 0.5f) > 1e-6f) return false;
+		if(!a.intersects(e) || a.intersect_fraction(e) != 1.f) return false;
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Line2 = drop::math::Line2;
+		auto sweep{ Timer("Bentley-Ottmann Sweep") };
+
+		auto brute_force{ [](const std::vector<Line2>& lines){
+			std::size_t pairs{ 0 };
+			for(std::size_t i{0}; i<lines.size(); ++i)
+				for(auto j{i+1}; j<lines.size(); ++j)
+					pairs += lines[i].intersects(lines[j]);
+			return pairs;
+		}};
+
+		std::vector<Line2> lines;
+		for(int n{0}; n<2000; ++n){
+			const auto p{ Vector2(rand()%10000*0.01f, rand()%10000*0.01f) };
+			lines.emplace_back(p, p + Vector2(rand()%1000*0.01f-5.f, rand()%1000*0.01f-5.f));
+		}
+		const auto found{ drop::math::segment_intersections(lines.data(), lines.size()) };
+		std::cout << found.size() << " crossings among " << lines.size() << " random segments" << std::endl;
+		if(found.size() != brute_force(lines)) return false;
+		for(const auto& hit : found)
+			if(hit.a >= hit.b || !lines[hit.a].intersects(lines[hit.b])) return false;
+
+		// long segments crossing all over, steep ones collect many close crossings
+		for(int trial{0}; trial<8; ++trial){
+			lines.clear();
+			for(int n{0}; n<400; ++n)
+				lines.emplace_back(Vector2(rand()%100000*0.001f, rand()%100000*0.001f),
+								   Vector2(rand()%100000*0.001f, rand()%100000*0.001f));
+			if(drop::math::segment_intersections(lines.data(), lines.size()).size() != brute_force(lines))
+				return false;
+		}
+		lines.clear();
+		lines.emplace_back(Vector2(30.6266632f, 17.5378399f), Vector2(50.7821198f, 39.1041031f));
+		lines.emplace_back(Vector2(38.3129921f, 10.651782f), Vector2(38.3111877f, 98.3998566f));
+		if(drop::math::segment_intersections(lines.data(), lines.size()).size() != 1) return false;
+
+		// axis aligned grid, every event shares its x with many others
+		lines.clear();
+		for(int n{0}; n<40; ++n){
+			lines.emplace_back(Vector2(-1.f, float(n)), Vector2(40.f, float(n)));
+			lines.emplace_back(Vector2(float(n), -1.f), Vector2(float(n), 40.f));
+		}
+		// three segments through one point and a T junction
+		lines.emplace_back(Vector2(50.f, 0.f), Vector2(60.f, 10.f));
+		lines.emplace_back(Vector2(50.f, 10.f), Vector2(60.f, 0.f));
+		lines.emplace_back(Vector2(50.f, 5.f), Vector2(60.f, 5.f));
+		lines.emplace_back(Vector2(55.f, 5.f), Vector2(55.f, 12.f));
+		const auto grid{ drop::math::segment_intersections(lines.data(), lines.size()) };
+		std::cout << grid.size() << " crossings on the grid" << std::endl;
+		if(grid.size() != 40*40 + 6) return false;
+
+		// a closed fan only shares endpoints
+		lines.clear();
+		for(int n{0}; n<16; ++n){
+			const auto angle{ n*0.3926991f };
+			lines.emplace_back(Vector2(0.f, 0.f), Vector2(cosf(angle), sinf(angle)));
+		}
+		if(!drop::math::segment_intersections(lines.data(), lines.size()).empty()) return false;
+		if(drop::math::segment_intersections(lines.data(), lines.size(), true).size() != 16*15/2) return false;
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Vector3 = drop::math::Vector3;
+		auto predicates{ Timer("Robust Predicates") };
+		using Int = long long;
+		auto sign{ [](auto v){ return (v > 0) - (v < 0); } };
+
+		// points just off the line through (12, 12) and (24, 24), one float ulp apart
+		const auto ulp{ 1.f/(1 << 24) };
+		int mismatches{ 0 }, naive_mismatches{ 0 };
+		for(int i{0}; i<64; ++i)
+			for(int j{0}; j<64; ++j){
+				const auto a{ Vector2(0.5f + i*ulp*2.f, 0.5f + j*ulp*2.f) };
+				const auto b{ Vector2(12.f, 12.f) }, c{ Vector2(24.f, 24.f) };
+				// exact reference in units of ulp
+				const Int ax{ (1 << 23) + 2*i }, ay{ (1 << 23) + 2*j };
+				const Int bx{ Int(12) << 24 }, cx{ Int(24) << 24 };
+				const auto reference{ sign((ax-cx)*(bx-cx) - (ay-cx)*(bx-cx)) };
+				mismatches += sign(drop::math::orient2d(a, b, c)) != reference;
+				const auto naive{ (a.getX()-c.getX())*(b.getY()-c.getY()) - (a.getY()-c.getY())*(b.getX()-c.getX()) };
+				naive_mismatches += sign(naive) != reference;
+			}
+		std::cout << "orient2d mismatches: " << mismatches << " (naive float: " << naive_mismatches << ")" << std::endl;
+		if(mismatches) return false;
+
+		// cospherical and cocircular points far from the origin
+		const auto base{ float(1 << 20) };
+		const auto o3{ Vector3(base, base, base) };
+		auto at{ [&](float x, float y, float z){ return o3 + Vector3(x, y, z)*5.f; } };
+		if(drop::math::insphere(at(1, 0, 0), at(0, 1, 0), at(0, 0, 1), at(-1, 0, 0), at(0, -1, 0)) != 0.) return false;
+		if(drop::math::insphere(at(1, 0, 0), at(0, 1, 0), at(0, 0, 1), at(-1, 0, 0), at(0, 0, 0)) == 0.) return false;
+		if(drop::math::orient3d(at(1, 0, 0), at(0, 1, 0), at(-1, 0, 0), at(0, -1, 0)) != 0.) return false;
+		const auto o2{ Vector2(base, base) };
+		if(drop::math::incircle(o2+Vector2(3.f, 0.f), o2+Vector2(0.f, 3.f), o2+Vector2(-3.f, 0.f), o2+Vector2(0.f, -3.f)) != 0.)
+			return false;
+
+		// the exact fallback against integer determinants, half of the
+		// inputs sit far from the origin so the expansions carry tails
+		auto r{ []{ return (rand()%512 - 256)/8.; } };
+		for(int n{0}; n<2000; ++n){
+			const auto offset{ n%2 ? 1048576. : 0. };
+			double p[5][3];
+			Int q[5][3];
+			for(int k{0}; k<5; ++k)
+				for(int a{0}; a<3; ++a){
+					p[k][a] = n%4 == 0 && k == 4 ? p[k%3][a] : offset + r();
+					q[k][a] = static_cast<Int>((p[k][a]-offset)*8.);
+				}
+			using namespace drop::math::predicate_detail;
+			auto d{ [&](int k, int l, int a){ return q[k][a]-q[l][a]; } };
+
+			const auto o2d{ (d(0, 2, 0))*(d(1, 2, 1)) - (d(0, 2, 1))*(d(1, 2, 0)) };
+			if(sign(orient2d_exact(p[0], p[1], p[2])) != sign(o2d)) return false;
+
+			auto det3{ [&](int a, int b, int c, int o){
+				return d(a, o, 2)*(d(b, o, 0)*d(c, o, 1) - d(c, o, 0)*d(b, o, 1))
+					 + d(b, o, 2)*(d(c, o, 0)*d(a, o, 1) - d(a, o, 0)*d(c, o, 1))
+					 + d(c, o, 2)*(d(a, o, 0)*d(b, o, 1) - d(b, o, 0)*d(a, o, 1));
+			}};
+			if(sign(orient3d_exact(p[0], p[1], p[2], p[3])) != sign(det3(0, 1, 2, 3))) return false;
+
+			auto lift2{ [&](int k, int o){ return d(k, o, 0)*d(k, o, 0) + d(k, o, 1)*d(k, o, 1); } };
+			const auto icc{ lift2(0, 3)*(d(1, 3, 0)*d(2, 3, 1) - d(2, 3, 0)*d(1, 3, 1))
+						  + lift2(1, 3)*(d(2, 3, 0)*d(0, 3, 1) - d(0, 3, 0)*d(2, 3, 1))
+						  + lift2(2, 3)*(d(0, 3, 0)*d(1, 3, 1) - d(1, 3, 0)*d(0, 3, 1)) };
+			if(sign(incircle_exact(p[0], p[1], p[2], p[3])) != sign(icc)) return false;
+
+			auto lift3{ [&](int k){ return lift2(k, 4) + d(k, 4, 2)*d(k, 4, 2); } };
+			const auto isp{ -lift3(0)*det3(1, 2, 3, 4) + lift3(1)*det3(0, 2, 3, 4)
+							- lift3(2)*det3(0, 1, 3, 4) + lift3(3)*det3(0, 1, 2, 4) };
+			if(sign(insphere_exact(p[0], p[1], p[2], p[3], p[4])) != sign(isp)) return false;
+		}
+
+		// orient2d on doubles no float can hold, nearly collinear so the
+		// products round and only the split fallback gets the sign
+		for(int n{0}; n<2000; ++n){
+			const Int ax{ rand()%(1 << 28) + (1 << 28) }, ay{ rand()%(1 << 28) + (1 << 28) };
+			const Int dx{ rand()%(1 << 12) + 1 }, dy{ rand()%(1 << 12) + 1 };
+			const Int m{ rand()%(1 << 14) + 1 };
+			const Int bx{ ax + m*dx + rand()%3 - 1 }, by{ ay + m*dy + rand()%3 - 1 };
+			const Int cx{ ax + 2*m*dx }, cy{ ay + 2*m*dy };
+			const double a[2]{ double(ax), double(ay) }, b[2]{ double(bx), double(by) }, c[2]{ double(cx), double(cy) };
+			const auto reference{ sign((ax-cx)*(by-cy) - (ay-cy)*(bx-cx)) };
+			if(sign(drop::math::predicate_detail::orient2d(a, b, c)) != reference) return false;
+		}
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Vector3 = drop::math::Vector3;
+		auto hulls{ Timer("Convex Hulls") };
+
+		std::vector<Vector2> flat;
+		for(int n{0}; n<200000; ++n){
+			const auto angle{ rand()%10000*0.000628f };
+			const auto radius{ sqrtf(rand()%10000*0.0001f)*10.f };
+			flat.emplace_back(cosf(angle)*radius, sinf(angle)*radius);
+		}
+		drop::math::Hull_Workspace ws;
+		std::vector<std::uint32_t> hull(flat.size()), parallel_hull(flat.size());
+		const auto size{ drop::math::convex_hull(flat.data(), flat.size(), hull.data(), ws) };
+		const auto parallel_size{ drop::math::convex_hull(flat.data(), flat.size(), parallel_hull.data(), ws, 4) };
+		std::cout << "2D hull of " << flat.size() << " points has " << size << " vertices" << std::endl;
+		if(size != parallel_size || !std::equal(hull.begin(), hull.begin()+size, parallel_hull.begin())) return false;
+		for(std::size_t n{0}; n<size; ++n){
+			const auto& a{ flat[hull[n]] };
+			const auto& b{ flat[hull[(n+1)%size]] };
+			if(drop::math::orient2d(a, b, flat[hull[(n+2)%size]]) <= 0.) return false;
+			for(std::size_t p{0}; p<flat.size(); p += 97)
+				if(drop::math::orient2d(a, b, flat[p]) < 0.) return false;
+		}
+
+		// repeated points collapse to one vertex, or two for a doubled segment
+		const Vector2 same[]{ Vector2(1.f, 2.f), Vector2(1.f, 2.f), Vector2(1.f, 2.f), Vector2(1.f, 2.f) };
+		if(drop::math::convex_hull(same, 4, hull.data(), ws) != 1 || drop::math::convex_hull(same, 2, hull.data(), ws) != 1)
+			return false;
+		const Vector2 ends[]{ Vector2(1.f, 2.f), Vector2(3.f, 2.f), Vector2(1.f, 2.f), Vector2(3.f, 2.f) };
+		if(drop::math::convex_hull(ends, 4, hull.data(), ws) != 2) return false;
+
+		auto check_hull{ [](const std::vector<Vector3>& points, const std::vector<std::uint32_t>& tris){
+			// closed two-manifold with every point on the inner side of every face
+			std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+			for(std::size_t t{0}; t<tris.size(); t += 3)
+				for(int e{0}; e<3; ++e) edges.emplace_back(tris[t+e], tris[t+(e+1)%3]);
+			std::sort(edges.begin(), edges.end());
+			if(std::adjacent_find(edges.begin(), edges.end()) != edges.end()) return -1.;
+			for(const auto& e : edges)
+				if(!std::binary_search(edges.begin(), edges.end(), std::make_pair(e.second, e.first))) return -1.;
+			auto volume{ 0. };
+			for(std::size_t t{0}; t<tris.size(); t += 3){
+				const auto& a{ points[tris[t]] };
+				const auto& b{ points[tris[t+1]] };
+				const auto& c{ points[tris[t+2]] };
+				for(std::size_t p{0}; p<points.size(); p += 31)
+					if(drop::math::orient3d(a, b, c, points[p]) < 0.) return -1.;
+				volume += drop::math::orient3d(a, b, c, Vector3(0.f, 0.f, 0.f))/6.;
+			}
+			return volume;
+		}};
+
+		std::vector<Vector3> cloud;
+		for(int n{0}; n<200000; ++n)
+			cloud.emplace_back(rand()%2001*0.001f-1.f, rand()%2001*0.001f-1.f, rand()%2001*0.001f-1.f);
+		std::vector<std::uint32_t> tris, parallel_tris;
+		const auto faces{ drop::math::convex_hull(cloud.data(), cloud.size(), tris, ws) };
+		const auto parallel_faces{ drop::math::convex_hull(cloud.data(), cloud.size(), parallel_tris, ws, 4) };
+		const auto volume{ check_hull(cloud, tris) };
+		std::cout << "3D hull of " << cloud.size() << " points has " << faces << " faces, volume " << volume << std::endl;
+		if(volume < 7.9 || volume > 8.) return false;
+		if(std::fabs(check_hull(cloud, parallel_tris) - volume) > 1e-6 || parallel_faces == 0) return false;
+
+		// a grid has coplanar points on every face
+		std::vector<Vector3> grid;
+		for(int x{0}; x<10; ++x)
+			for(int y{0}; y<10; ++y)
+				for(int z{0}; z<10; ++z) grid.emplace_back(float(x), float(y), float(z));
+		drop::math::convex_hull(grid.data(), grid.size(), tris, ws);
+		if(check_hull(grid, tris) != 729.) return false;
+		const auto plane{ std::vector<Vector3>{ Vector3(0.f, 0.f, 1.f), Vector3(1.f, 0.f, 1.f),
+												Vector3(0.f, 1.f, 1.f), Vector3(1.f, 1.f, 1.f) } };
+		if(drop::math::convex_hull(plane.data(), plane.size(), tris) != 0) return false;
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Line2 = drop::math::Line2;
+		auto delaunay{ Timer("Delaunay Triangulation") };
+
+		auto check_mesh{ [](const drop::math::Delaunay_Triangulation& mesh, double area){
+			// counterclockwise triangles that tile the given area
+			const auto tris{ mesh.triangles() };
+			auto total{ 0. };
+			for(std::size_t t{0}; t<tris.size(); t += 3){
+				const auto twice{ drop::math::orient2d(mesh.getPoint(tris[t]), mesh.getPoint(tris[t+1]), mesh.getPoint(tris[t+2])) };
+				if(twice <= 0.) return false;
+				total += twice/2.;
+			}
+			return std::fabs(total - area) <= 1e-6*area;
+		}};
+
+		std::vector<Vector2> samples;
+		for(int n{0}; n<200000; ++n)
+			samples.emplace_back(rand()%100000*0.01f + rand()%1000*1e-5f, rand()%100000*0.01f + rand()%1000*1e-5f);
+		const auto random_mesh{ drop::math::Delaunay_Triangulation(samples.data(), samples.size()) };
+		std::vector<std::uint32_t> hull(samples.size());
+		const auto hull_size{ drop::math::convex_hull(samples.data(), samples.size(), hull.data()) };
+		std::cout << "Delaunay of " << samples.size() << " points has " << random_mesh.triangle_count() << " triangles" << std::endl;
+		std::vector<Vector2> unique_samples(samples);
+		std::sort(unique_samples.begin(), unique_samples.end(), [](const Vector2& l, const Vector2& r){
+			return l.getX() < r.getX() || (l.getX() == r.getX() && l.getY() < r.getY());
+		});
+		const auto unique{ std::unique(unique_samples.begin(), unique_samples.end(), [](const Vector2& l, const Vector2& r){
+			return l.getX() == r.getX() && l.getY() == r.getY();
+		}) - unique_samples.begin() };
+		if(random_mesh.triangle_count() != 2*std::size_t(unique)-2-hull_size) return false;
+
+		// empty circumcircles, checked against every point for a small set
+		const auto small{ drop::math::Delaunay_Triangulation(samples.data(), 2000) };
+		const auto small_tris{ small.triangles() };
+		for(std::size_t t{0}; t<small_tris.size(); t += 3)
+			for(std::size_t p{0}; p<2000; ++p)
+				if(drop::math::incircle(samples[small_tris[t]], samples[small_tris[t+1]], samples[small_tris[t+2]], samples[p]) > 0.)
+					return false;
+
+		// terrain grid, every cell is cocircular
+		std::vector<Vector2> grid;
+		for(int y{0}; y<300; ++y)
+			for(int x{0}; x<300; ++x) grid.emplace_back(float(x), float(y));
+		auto mesh{ drop::math::Delaunay_Triangulation(grid.data(), grid.size()) };
+		if(mesh.triangle_count() != 2*299*299 || !check_mesh(mesh, 299.*299.)) return false;
+
+		// constraints crossing many cells, through grid points and with new endpoints
+		mesh.insert_constraint(Line2(Vector2(0.f, 0.f), Vector2(299.f, 110.f)));
+		mesh.insert_constraint(Line2(Vector2(0.f, 0.f), Vector2(150.f, 150.f)));
+		mesh.insert_constraint(Line2(Vector2(10.5f, 200.25f), Vector2(280.25f, 290.5f)));
+		if(!mesh.is_constrained(0, 110*300+299) || !check_mesh(mesh, 299.*299.)) return false;
+		for(int n{0}; n<150; ++n)
+			if(!mesh.is_constrained(n*301, (n+1)*301)) return false;
+		if(mesh.size() != grid.size()+2 || !mesh.is_constrained(grid.size(), grid.size()+1)) return false;
+
+		// points inserted on a constraint split it
+		const auto middle{ mesh.insert_point(Vector2(145.375f, 245.375f)) };
+		if(!mesh.is_constrained(grid.size(), middle) || !mesh.is_constrained(middle, grid.size()+1)) return false;
+		if(mesh.insert_point(Vector2(5.f, 5.f)) != 5*301) return false;
+		if(!check_mesh(mesh, 299.*299.)) return false;
+
+		// built up one point at a time, from nothing and from a line
+		auto grown{ drop::math::Delaunay_Triangulation(nullptr, 0) };
+		grown.insert_point(Vector2(0.f, 0.f));
+		grown.insert_point(Vector2(4.f, 0.f));
+		grown.insert_point(Vector2(4.f, 3.f));
+		grown.insert_point(Vector2(0.f, 3.f));
+		if(grown.triangle_count() != 2 || !check_mesh(grown, 12.)) return false;
+		const Vector2 line[]{ Vector2(0.f, 0.f), Vector2(1.f, 1.f), Vector2(2.f, 2.f), Vector2(1.f, 1.f) };
+		auto raised{ drop::math::Delaunay_Triangulation(line, 4) };
+		if(raised.triangle_count() != 0) return false;
+		if(raised.insert_point(Vector2(2.f, 0.f)) != 4 || raised.insert_point(Vector2(2.f, 2.f)) != 2) return false;
+		if(raised.triangle_count() != 2 || !check_mesh(raised, 2.)) return false;
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Line2 = drop::math::Line2;
+		using Rect = drop::math::Rect;
+		auto clipping{ Timer("Clipping") };
+
+		const auto rect{ Rect(2.f, 3.f, 5.f, 2.f) };
+		auto clipped{ Line2(Vector2(), Vector2()) };
+		if(Line2(Vector2(2.f, 1.f), Vector2(5.f, 5.f)).intersect_fraction(rect) != 0.5f) return false;
+		if(Line2(Vector2(10.f, 4.f), Vector2(0.f, 4.f)).intersect_fraction(rect) != 0.3f) return false;
+		if(Line2(Vector2(3.f, 4.f), Vector2(0.f, 0.f)).intersect_fraction(rect) != 0.f) return false;
+		if(Line2(Vector2(0.f, 0.f), Vector2(1.f, 10.f)).intersect_fraction(rect) != drop::math::inf) return false;
+		if(!Line2(Vector2(0.f, 4.f), Vector2(10.f, 4.f)).clip(rect, clipped)) return false;
+		std::cout << "Clipped segment: " << clipped.getFrom() << " " << clipped.getTo() << std::endl;
+		if(clipped.getFrom() != Vector2(2.f, 4.f) || clipped.getTo() != Vector2(7.f, 4.f)) return false;
+
+		std::vector<Line2> segments, out(100000, clipped), parallel_out(100000, clipped);
+		std::vector<std::uint32_t> kept(100000), parallel_kept(100000);
+		for(int n{0}; n<100000; ++n)
+			segments.emplace_back(Vector2(rand()%1000*0.01f, rand()%1000*0.01f), Vector2(rand()%1000*0.01f, rand()%1000*0.01f));
+		const auto visible{ drop::math::clip_segments(segments.data(), segments.size(), rect, out.data(), kept.data()) };
+		const auto parallel_visible{ drop::math::clip_segments(segments.data(), segments.size(), rect,
+															   parallel_out.data(), parallel_kept.data(), 4) };
+		std::cout << visible << " of " << segments.size() << " segments are visible" << std::endl;
+		if(visible != parallel_visible || !std::equal(kept.begin(), kept.begin()+visible, parallel_kept.begin())) return false;
+		std::size_t expected{ 0 };
+		for(std::size_t n{0}; n<segments.size(); ++n){
+			if(!segments[n].clip(rect, clipped)) continue;
+			if(kept[expected] != n || out[expected].getFrom() != clipped.getFrom()) return false;
+			if(!rect.expanded(1e-4f).contains(clipped.getFrom()) || !rect.expanded(1e-4f).contains(clipped.getTo())) return false;
+			++expected;
+		}
+		if(expected != visible) return false;
+
+		auto area{ [](const Vector2* polygon, std::size_t count){
+			auto twice{ 0. };
+			for(std::size_t n{0}; n<count; ++n)
+				twice += double(polygon[n].getX())*polygon[(n+1)%count].getY()
+					   - double(polygon[(n+1)%count].getX())*polygon[n].getY();
+			return twice/2.;
+		}};
+		// a diamond around the rect loses its corners
+		const Vector2 diamond[4]{ Vector2(4.5f, -1.f), Vector2(10.f, 4.f), Vector2(4.5f, 9.f), Vector2(-1.f, 4.f) };
+		Vector2 polygon[16], scratch[16];
+		auto size{ drop::math::clip_polygon(diamond, 4, rect, polygon, scratch, 16) };
+		if(size != 4 || std::fabs(area(polygon, size) - 10.) > 1e-5) return false;
+		const Vector2 far_away[3]{ Vector2(20.f, 20.f), Vector2(30.f, 20.f), Vector2(20.f, 30.f) };
+		if(drop::math::clip_polygon(far_away, 3, rect, polygon, scratch, 16) != 0) return false;
+
+		// the rect as a convex clipper gives the same result
+		const Vector2 corners[4]{ Vector2(2.f, 3.f), Vector2(7.f, 3.f), Vector2(7.f, 5.f), Vector2(2.f, 5.f) };
+		size = drop::math::clip_polygon(diamond, 4, corners, 4, polygon, scratch, 16);
+		if(size != 4 || std::fabs(area(polygon, size) - 10.) > 1e-5) return false;
+		for(int n{0}; n<200; ++n){
+			Vector2 triangle[3];
+			for(auto& p : triangle) p = Vector2(rand()%1000*0.01f, rand()%1000*0.01f);
+			if(drop::math::orient2d(triangle[0], triangle[1], triangle[2]) < 0.) std::swap(triangle[1], triangle[2]);
+			const auto by_rect{ drop::math::clip_polygon(triangle, 3, rect, polygon, scratch, 16) };
+			const auto rect_area{ area(polygon, by_rect) };
+			const auto by_corners{ drop::math::clip_polygon(triangle, 3, corners, 4, polygon, scratch, 16) };
+			if(std::fabs(area(polygon, by_corners) - rect_area) > 1e-4) return false;
+			// and a triangle clipper against itself
+			const auto self{ drop::math::clip_polygon(triangle, 3, triangle, 3, polygon, scratch, 16) };
+			if(std::fabs(area(polygon, self) - area(triangle, 3)) > 1e-4) return false;
+		}
+
+		// a comb whose teeth poke out of the left side, every tooth adds two crossings
+		std::vector<Vector2> comb{ Vector2(6.f, 3.1f), Vector2(6.f, 4.9f) };
+		for(int k{0}; k<20; ++k) comb.emplace_back(k%2 ? 4.f : 0.f, 4.9f - k*0.09f);
+		const auto room{ drop::math::clip_capacity(comb.size(), 4) };
+		std::vector<Vector2> teeth(room), spare(room);
+		const auto comb_size{ drop::math::clip_polygon(comb.data(), comb.size(), rect, teeth.data(), spare.data(), room) };
+		const auto comb_area{ area(teeth.data(), comb_size) };
+		std::cout << "Comb clipped to " << comb_size << " vertices" << std::endl;
+		if(comb_size <= comb.size()+4) return false;
+		if(drop::math::clip_polygon(comb.data(), comb.size(), corners, 4, teeth.data(), spare.data(), room) != comb_size
+		|| std::fabs(area(teeth.data(), comb_size) - comb_area) > 1e-4) return false;
+		// too little room gives up instead of writing past the end
+		teeth.resize(comb.size()+4);
+		spare.resize(comb.size()+4);
+		if(drop::math::clip_polygon(comb.data(), comb.size(), rect, teeth.data(), spare.data(), comb.size()+4) != 0) return false;
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Rect = drop::math::Rect;
+		auto regions{ Timer("Point Classification") };
+
+		std::vector<Vector2> points;
+		std::vector<float> xs, ys;
+		for(int n{0}; n<100000; ++n){
+			points.emplace_back(rand()%2000*0.01f-10.f, rand()%2000*0.01f-10.f);
+			xs.push_back(points.back().getX());
+			ys.push_back(points.back().getY());
+		}
+		const auto rect{ Rect(-2.f, -3.f, 5.f, 4.f) };
+		std::vector<std::uint32_t> masks((points.size()+31)/32), soa_masks(masks.size());
+		const auto in_rect{ drop::math::contains_batch(rect, points.data(), points.size(), masks.data(), 4) };
+		const auto soa_in_rect{ drop::math::contains_batch(rect, xs.data(), ys.data(), xs.size(), soa_masks.data()) };
+		std::cout << in_rect << " of " << points.size() << " points in the rect" << std::endl;
+		if(in_rect != soa_in_rect || masks != soa_masks) return false;
+		for(std::size_t n{0}; n<points.size(); ++n)
+			if(((masks[n/32] >> (n%32)) & 1u) != rect.contains(points[n])) return false;
+
+		// star shaped outer ring, a clockwise square hole and a self intersecting pentagram
+		std::vector<Vector2> rings;
+		for(int n{0}; n<300; ++n){
+			const auto angle{ n*6.2831853f/300.f };
+			const auto radius{ 5.f + rand()%400*0.01f };
+			rings.emplace_back(cosf(angle)*radius, sinf(angle)*radius);
+		}
+		rings.emplace_back(-1.f, -1.f);
+		rings.emplace_back(-1.f, 1.f);
+		rings.emplace_back(1.f, 1.f);
+		rings.emplace_back(1.f, -1.f);
+		for(int n{0}; n<5; ++n){
+			const auto angle{ n*2*6.2831853f/5.f };
+			rings.emplace_back(3.f+cosf(angle)*1.5f, 3.f+sinf(angle)*1.5f);
+		}
+		const std::uint32_t ring_ends[3]{ 300, 304, 309 };
+		const auto slabs{ drop::math::Polygon_Slabs(rings.data(), ring_ends, 3) };
+		if(slabs.winding_number(Vector2(0.f, 0.f)) != 0 || slabs.winding_number(Vector2(3.f, 3.f)) != 3
+		|| slabs.winding_number(Vector2(0.f, 4.f)) != 1 || slabs.winding_number(Vector2(50.f, 0.f)) != 0) return false;
+
+		std::vector<std::int32_t> brute(points.size()), fast(points.size());
+		const auto outer{ drop::math::Polygon_Slabs(rings.data(), 300) };
+		drop::math::winding_numbers(points.data(), points.size(), rings.data(), 300, brute.data(), 4);
+		outer.winding_numbers(points.data(), points.size(), fast.data(), 4);
+		if(brute != fast) return false;
+		for(std::size_t n{0}; n<points.size(); n += 101)
+			if(drop::math::winding_number(points[n], rings.data(), 300) != brute[n]) return false;
+
+		std::vector<std::int32_t> per_ring(points.size());
+		std::fill(brute.begin(), brute.end(), 0);
+		for(std::uint32_t r{0}, start{0}; r<3; start = ring_ends[r++]){
+			drop::math::winding_numbers(points.data(), points.size(), rings.data()+start, ring_ends[r]-start, per_ring.data());
+			for(std::size_t n{0}; n<points.size(); ++n) brute[n] += per_ring[n];
+		}
+		slabs.winding_numbers(points.data(), points.size(), fast.data());
+		if(brute != fast) return false;
+		const auto inside{ slabs.contains_batch(points.data(), points.size(), masks.data(), 4) };
+		std::cout << inside << " of " << points.size() << " points in the polygon" << std::endl;
+		for(std::size_t n{0}; n<points.size(); ++n)
+			if(((masks[n/32] >> (n%32)) & 1u) != (brute[n] != 0)) return false;
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		auto triangulation{ Timer("Polygon Triangulation") };
+
+		// spiky outer ring, four holes of either orientation and a comb with a split vertex per tooth
+		std::vector<Vector2> rings;
+		for(int n{0}; n<400; ++n){
+			const auto angle{ n*6.2831853f/400.f };
+			const auto radius{ 10.f + rand()%500*0.01f };
+			rings.emplace_back(cosf(angle)*radius, sinf(angle)*radius);
+		}
+		std::vector<std::uint32_t> ring_ends{ 400 };
+		for(int h{0}; h<4; ++h){
+			const auto x{ h%2 ? 3.f : -3.f }, y{ h/2 ? 3.f : -3.f };
+			for(int n{0}; n<7; ++n){
+				const auto angle{ (h%2 ? n : -n)*6.2831853f/7.f };
+				rings.emplace_back(x + cosf(angle)*(1.f + rand()%100*0.01f), y + sinf(angle)*(1.f + rand()%100*0.01f));
+			}
+			ring_ends.push_back(static_cast<std::uint32_t>(rings.size()));
+		}
+		std::vector<Vector2> comb{ Vector2(0.f, -1.f), Vector2(100.f, -1.f) };
+		for(int n{50}; n>=0; --n) comb.emplace_back(n*2.f, n%2 ? 10.f : 1.f);
+		const std::uint32_t comb_end{ static_cast<std::uint32_t>(comb.size()) };
+
+		auto check{ [](const std::vector<Vector2>& vertices, const std::uint32_t* ends, std::size_t ring_count){
+			auto area{ 0. };
+			for(std::uint32_t r{0}, start{0}; r<ring_count; start = ends[r++]){
+				auto twice{ 0. };
+				for(auto n{start}; n<ends[r]; ++n){
+					const auto& a{ vertices[n] };
+					const auto& b{ vertices[n+1 < ends[r] ? n+1 : start] };
+					twice += double(a.getX())*b.getY() - double(b.getX())*a.getY();
+				}
+				area += r ? -std::fabs(twice)/2. : std::fabs(twice)/2.;
+			}
+			const auto expected{ ends[ring_count-1] + 2*(ring_count-1) - 2 };
+			std::vector<std::uint32_t> indices(3*expected);
+			drop::math::Triangulation_Workspace workspace;
+			const auto count{ drop::math::triangulate_polygon(vertices.data(), ends, ring_count, indices.data(), workspace) };
+			const auto region{ drop::math::Polygon_Slabs(vertices.data(), ends, ring_count) };
+			auto covered{ 0. };
+			for(std::size_t t{0}; t<count; ++t){
+				const auto& a{ vertices[indices[3*t]] };
+				const auto& b{ vertices[indices[3*t+1]] };
+				const auto& c{ vertices[indices[3*t+2]] };
+				const auto twice{ drop::math::orient2d(a, b, c) };
+				if(twice <= 0. || !region.contains((a+b+c)/3.f)) return false;
+				covered += twice/2.;
+			}
+			std::cout << count << " triangles covering " << covered << " of " << area << std::endl;
+			return count == expected && std::fabs(covered-area) < 1e-4*area;
+		}};
+		if(!check(rings, ring_ends.data(), ring_ends.size())) return false;
+		if(!check(comb, &comb_end, 1)) return false;
+
+		// a reused workspace gives the same triangles without growing its status pool
+		drop::math::Triangulation_Workspace reused;
+		std::vector<std::uint32_t> first(3*comb.size()), second(3*comb.size());
+		const auto first_count{ drop::math::triangulate_polygon(comb.data(), comb.size(), first.data(), reused) };
+		const auto chunks{ reused.status_nodes.chunks.size() };
+		const auto second_count{ drop::math::triangulate_polygon(comb.data(), comb.size(), second.data(), reused) };
+		if(first_count != second_count || first != second || reused.status_nodes.chunks.size() != chunks) return false;
+	}
+	return true;
+}
@@ -0,0 +1,727 @@
+#pragma once
+
+#include "../header/dropMath.hpp"
+#include "Timer.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+inline
+auto spatial_tests() -> bool {
+	{
+		using AABB3 = drop::math::AABB3;
+		using Rect = drop::math::Rect;
+		using Matrix_4x4 = drop::math::Matrix_4x4;
+
+		auto boxes{ Timer("AABB3 and Rect Tests") };
+
+		auto a{ AABB3({0.f, 0.f, 0.f}, {2.f, 2.f, 2.f}) };
+		auto b{ AABB3({1.f, 1.f, 1.f}, {3.f, 3.f, 3.f}) };
+
+		std::cout << "A merged with B: " << a.merged(b) << std::endl;
+		assert(a.intersects(b));
+		if(a.intersected(b) != AABB3({1.f, 1.f, 1.f}, {2.f, 2.f, 2.f})) return false;
+		if(!a.merged(b).contains(a) || a.contains(b)) return false;
+
+		auto r{ Rect(2.f, 3.f, -2.f, -3.f) };
+		if(r.getMin() != drop::math::Vector2(0.f, 0.f)) return false;
+		if(!r.intersects(Rect(1.f, 1.f, 5.f, 5.f))) return false;
+
+		//rotate 90 degrees around z and move by (10, 0, 0)
+		auto m{ Matrix_4x4(
+				{0.f, 1.f, 0.f, 0.f},
+				{-1.f, 0.f, 0.f, 0.f},
+				{0.f, 0.f, 1.f, 0.f},
+				{10.f, 0.f, 0.f, 1.f})
+		};
+		auto moved{ AABB3({0.f, 0.f, 0.f}, {1.f, 2.f, 3.f}).transformed(m) };
+		std::cout << "Transformed box: " << moved << std::endl;
+		if(moved != AABB3({8.f, 0.f, 0.f}, {10.f, 1.f, 3.f})) return false;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+
+		auto bounds{ Timer("Point Bounds Reduction") };
+
+		std::vector<Vector3> points;
+		std::vector<float> xs, ys, zs;
+		for(int n{0}; n<200000; ++n){
+			auto p{ Vector3(rand()%2001-1000.f, rand()%2001-1000.f, rand()%2001-1000.f) };
+			points.push_back(p);
+			xs.push_back(p.getX()); ys.push_back(p.getY()); zs.push_back(p.getZ());
+		}
+		points[1234].set(-5000.f, 0.f, 7000.f);
+		xs[1234] = -5000.f; zs[1234] = 7000.f;
+
+		auto serial{ drop::math::compute_bounds(points.data(), points.size()) };
+		auto soa{ drop::math::compute_bounds(xs.data(), ys.data(), zs.data(), xs.size()) };
+		auto parallel{ drop::math::compute_bounds_parallel(points.data(), points.size(), 4) };
+
+		std::cout << "Bounds: " << serial << std::endl;
+		if(serial.getMin(0) != -5000.f || serial.getMax(2) != 7000.f) return false;
+		if(serial != soa || serial != parallel) return false;
+	}
+	{
+		using Rect = drop::math::Rect;
+		using Line2 = drop::math::Line2;
+		using Vector2 = drop::math::Vector2;
+
+		auto bvh_test{ Timer("Bvh2 Raycast, Overlap and Nearest") };
+
+		std::vector<Rect> level;
+		for(int n{0}; n<5000; ++n)
+			level.emplace_back(rand()%10000*0.1f, rand()%10000*0.1f,
+							   rand()%50*0.1f+0.1f, rand()%50*0.1f+0.1f);
+
+		auto bvh{ drop::math::Bvh2(level.data(), level.size()) };
+		for(int q{0}; q<200; ++q){
+			auto line{ Line2({rand()%1000*1.f, rand()%1000*1.f},
+							 {rand()%1000*1.f, rand()%1000*1.f}) };
+			auto hit{ bvh.raycast(line) };
+
+			auto best{ drop::math::inf };
+			for(auto& r : level){
+				auto bounds{ drop::math::AABB3(r) };
+				auto from{ line.getFrom() };
+				auto dir{ line.asVec2() };
+				auto t_enter{ 0.f }, t_exit{ 1.f };
+				for(int a{0}; a<2; ++a){
+					auto t0{ (bounds.getMin(a)-from[a])/dir[a] };
+					auto t1{ (bounds.getMax(a)-from[a])/dir[a] };
+					t_enter = std::max(t_enter, std::min(t0, t1));
+					t_exit = std::min(t_exit, std::max(t0, t1));
+				}
+				if(t_enter <= t_exit) best = std::min(best, t_enter);
+			}
+			if(best != hit.fraction && fabs(best - hit.fraction) > 0.0001f) return false;
+		}
+
+		auto region{ Rect(100.f, 100.f, 250.f, 80.f) };
+		std::vector<std::uint32_t> found;
+		bvh.query(region, found);
+		std::size_t expected{ 0 };
+		for(auto& r : level) expected += r.intersects(region);
+		std::cout << found.size() << " rects overlap the region" << std::endl;
+		if(found.size() != expected) return false;
+
+		auto p{ Vector2(512.3f, 77.7f) };
+		auto nearest{ bvh.nearest(p) };
+		auto best_sq{ drop::math::inf };
+		for(auto& r : level){
+			auto dx{ std::max(std::max(r.getXMin()-p.getX(), 0.f), p.getX()-r.getXMax()) };
+			auto dy{ std::max(std::max(r.getYMin()-p.getY(), 0.f), p.getY()-r.getYMax()) };
+			best_sq = std::min(best_sq, dx*dx+dy*dy);
+		}
+		if(fabs(nearest.distance - sqrtf(best_sq)) > 0.0001f) return false;
+	}
+	{
+		using AABB3 = drop::math::AABB3;
+		using Vector3 = drop::math::Vector3;
+
+		auto bvh_build{ Timer("Bvh3 Parallel SAH Build (200k boxes)") };
+
+		std::vector<AABB3> boxes;
+		for(int n{0}; n<200000; ++n){
+			auto c{ Vector3(rand()%10000*0.1f, rand()%10000*0.1f, rand()%10000*0.1f) };
+			boxes.emplace_back(c, c+Vector3(1.f, 1.f, 1.f));
+		}
+		auto bvh{ drop::math::Bvh3(boxes.data(), boxes.size(), 4) };
+
+		for(int q{0}; q<20; ++q){
+			auto from{ Vector3(rand()%1000*1.f, rand()%1000*1.f, rand()%1000*1.f) };
+			auto to{ Vector3(rand()%1000*1.f, rand()%1000*1.f, rand()%1000*1.f) };
+			auto hit{ bvh.raycast(drop::math::Line3(from, to)) };
+
+			auto best{ drop::math::inf };
+			auto dir{ from.to(to) };
+			for(auto& b : boxes){
+				auto t_enter{ 0.f }, t_exit{ 1.f };
+				for(int a{0}; a<3; ++a){
+					auto t0{ (b.getMin(a)-from[a])/dir[a] };
+					auto t1{ (b.getMax(a)-from[a])/dir[a] };
+					t_enter = std::max(t_enter, std::min(t0, t1));
+					t_exit = std::min(t_exit, std::max(t0, t1));
+				}
+				if(t_enter <= t_exit) best = std::min(best, t_enter);
+			}
+			if(best != hit.fraction && fabs(best - hit.fraction) > 0.0001f) return false;
+		}
+
+		std::vector<std::uint32_t> found;
+		auto region{ AABB3({100.f, 100.f, 100.f}, {200.f, 200.f, 200.f}) };
+		bvh.query(region, found);
+		std::size_t expected{ 0 };
+		for(auto& b : boxes) expected += b.intersects(region);
+		if(found.size() != expected) return false;
+	}
+	{
+		using AABB3 = drop::math::AABB3;
+		using Vector3 = drop::math::Vector3;
+
+		auto dynamic_tree{ Timer("Dynamic AABB Tree (2000 movers, 10 frames)") };
+
+		auto tree{ drop::math::Dynamic_AABB_Tree(0.5f) };
+		std::vector<Vector3> positions;
+		std::vector<std::int32_t> proxies;
+		for(std::uint32_t n{0}; n<2000; ++n){
+			positions.emplace_back(rand()%2000*0.1f, rand()%2000*0.1f, rand()%2000*0.1f);
+			proxies.push_back(tree.create_proxy(
+				AABB3(positions[n], positions[n]+Vector3(1.f, 1.f, 1.f)), n));
+		}
+
+		auto brute_pairs{ [&]{
+			std::size_t count{ 0 };
+			for(std::size_t a{0}; a<proxies.size(); ++a)
+				for(std::size_t b{a+1}; b<proxies.size(); ++b)
+					count += tree.getFatAABB(proxies[a]).intersects(tree.getFatAABB(proxies[b]));
+			return count;
+		}};
+
+		for(int frame{0}; frame<10; ++frame){
+			for(std::size_t n{0}; n<positions.size(); ++n){
+				auto step{ Vector3(rand()%21-10.f, rand()%21-10.f, rand()%21-10.f)*0.05f };
+				positions[n] += step;
+				auto box{ AABB3(positions[n], positions[n]+Vector3(1.f, 1.f, 1.f)) };
+				if(frame%2) tree.set_proxy_bounds(proxies[n], box);
+				else tree.move_proxy(proxies[n], box, step);
+			}
+			if(frame%2) tree.refit();
+
+			std::size_t reported{ 0 };
+			tree.update_pairs([&](std::int32_t a, std::int32_t b){
+				if(!tree.getFatAABB(a).intersects(tree.getFatAABB(b))) reported = 1u << 30;
+				++reported;
+			});
+			std::size_t all{ 0 };
+			tree.for_each_pair([&](std::int32_t, std::int32_t){ ++all; });
+			if(reported > all || all != brute_pairs()) return false;
+			if(frame%2 && reported != all) return false;
+		}
+
+		tree.destroy_proxy(proxies[7]);
+		std::cout << "Tree height with " << tree.size() << " proxies: "
+				  << tree.height() << std::endl;
+		if(tree.height() > 24) return false;
+	}
+	{
+		using AABB3 = drop::math::AABB3;
+		using Vector3 = drop::math::Vector3;
+		using Sweep_And_Prune = drop::math::Sweep_And_Prune;
+
+		auto sap_test{ Timer("Sweep and Prune (single and all axes)") };
+
+		for(auto axes : { Sweep_And_Prune::Axes::single, Sweep_And_Prune::Axes::all }){
+			auto sap{ Sweep_And_Prune(axes) };
+			std::vector<Vector3> positions;
+			std::vector<std::uint32_t> ids;
+			for(int n{0}; n<600; ++n){
+				positions.emplace_back(rand()%1000*0.1f, rand()%1000*0.1f, rand()%1000*0.1f);
+				ids.push_back(sap.add(AABB3(positions.back(), positions.back()+Vector3(3.f, 3.f, 3.f))));
+			}
+
+			std::unordered_set<std::uint64_t> tracked;
+			for(int frame{0}; frame<20; ++frame){
+				if(frame == 10){
+					std::uint32_t paired{ ids[0] };
+					sap.for_each_pair([&](std::uint32_t a, std::uint32_t){ paired = a; });
+					auto victim{ std::find(ids.begin(), ids.end(), paired) - ids.begin() };
+					sap.remove(ids[victim]);
+					ids.erase(ids.begin()+victim);
+					positions.erase(positions.begin()+victim);
+				}
+				for(std::size_t n{0}; n<ids.size(); ++n){
+					positions[n] += Vector3(rand()%3-1.f, rand()%3-1.f, rand()%3-1.f)*0.3f;
+					sap.set_bounds(ids[n], AABB3(positions[n], positions[n]+Vector3(3.f, 3.f, 3.f)));
+				}
+				sap.update();
+
+				for(auto& p : sap.removed_pairs())
+					tracked.erase((std::uint64_t(p.a) << 32) | p.b);
+				for(auto& p : sap.added_pairs())
+					tracked.insert((std::uint64_t(p.a) << 32) | p.b);
+
+				std::size_t expected{ 0 };
+				for(std::size_t a{0}; a<ids.size(); ++a)
+					for(std::size_t b{a+1}; b<ids.size(); ++b)
+						if(sap.getBounds(ids[a]).intersects(sap.getBounds(ids[b]))){
+							++expected;
+							if(!sap.contains_pair(ids[a], ids[b])) return false;
+						}
+				if(expected != sap.pair_count() || tracked.size() != expected) return false;
+			}
+			std::cout << "Persistent pairs: " << sap.pair_count() << std::endl;
+		}
+	}
+	{
+		using Vector2 = drop::math::Vector2;
+		using Vector3 = drop::math::Vector3;
+
+		auto grid_test{ Timer("Spatial Hash Grid Radius and kNN") };
+
+		std::vector<Vector2> boids;
+		for(int n{0}; n<20000; ++n)
+			boids.emplace_back(rand()%100000*0.01f, rand()%100000*0.01f);
+
+		auto grid{ drop::math::Spatial_Hash_Grid2(5.f) };
+		grid.build(boids.data(), boids.size(), 4);
+
+		for(int q{0}; q<50; ++q){
+			auto center{ boids[rand()%boids.size()] };
+			std::vector<std::uint32_t> found;
+			grid.query_radius(center, 7.5f, found);
+			std::size_t expected{ 0 };
+			for(auto& b : boids) expected += (b-center).squared_length() <= 7.5f*7.5f;
+			if(found.size() != expected) return false;
+
+			std::vector<std::uint32_t> nearest;
+			grid.k_nearest(center, 8, nearest);
+			std::vector<float> distances;
+			for(auto& b : boids) distances.push_back((b-center).squared_length());
+			std::sort(distances.begin(), distances.end());
+			if(nearest.size() != 8) return false;
+			for(std::size_t n{0}; n<nearest.size(); ++n)
+				if((boids[nearest[n]]-center).squared_length() != distances[n]) return false;
+		}
+
+		// far past the int32 cell range, the search starts at the occupied cells
+		{
+			const auto distant{ Vector2(1e12f, -3e11f) };
+			std::vector<std::uint32_t> nearest;
+			auto closest{ drop::math::inf };
+			for(auto& b : boids) closest = std::min(closest, (b-distant).squared_length());
+			if(grid.k_nearest(distant, 4, nearest) != 4) return false;
+			if((boids[nearest[0]]-distant).squared_length() != closest) return false;
+		}
+
+		std::vector<Vector3> crowd;
+		for(int n{0}; n<5000; ++n)
+			crowd.emplace_back(rand()%1000*0.1f, rand()%1000*0.1f, rand()%1000*0.1f);
+		auto grid3{ drop::math::Spatial_Hash_Grid3(4.f) };
+		grid3.build(crowd.data(), crowd.size());
+
+		std::vector<std::uint32_t> nearest;
+		auto far_away{ Vector3(500.f, 500.f, 500.f) };
+		grid3.k_nearest(far_away, 3, nearest);
+		auto best{ drop::math::inf };
+		for(auto& c : crowd) best = std::min(best, (c-far_away).squared_length());
+		std::cout << "Closest agent to the far query: " << crowd[nearest[0]] << std::endl;
+		if((crowd[nearest[0]]-far_away).squared_length() != best) return false;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		using KD_Tree3 = drop::math::KD_Tree3;
+		auto kd_test{ Timer("KD_Tree3 Batched kNN (100k points)") };
+
+		std::vector<Vector3> cloud;
+		for(int n{0}; n<100000; ++n)
+			cloud.emplace_back(rand()%10000*0.1f, rand()%10000*0.1f, rand()%10000*0.01f);
+		auto tree{ KD_Tree3(cloud.data(), cloud.size(), 4) };
+
+		std::vector<Vector3> queries;
+		for(int n{0}; n<200; ++n)
+			queries.emplace_back(rand()%12000*0.1f-100.f, rand()%10000*0.1f, rand()%1000*0.1f);
+
+		constexpr std::size_t k{ 6 };
+		std::vector<KD_Tree3::Neighbor> nearest(queries.size());
+		std::vector<KD_Tree3::Neighbor> knn(queries.size()*k);
+		std::vector<std::size_t> counts(queries.size());
+		tree.nearest_batch(queries.data(), queries.size(), nearest.data(), 4);
+		tree.k_nearest_batch(queries.data(), queries.size(), k, knn.data(), counts.data(), 4);
+
+		for(std::size_t q{0}; q<queries.size(); q += 10){
+			std::vector<float> distances;
+			for(auto& c : cloud) distances.push_back((c-queries[q]).squared_length());
+			std::vector<float> sorted{ distances };
+			std::sort(sorted.begin(), sorted.end());
+
+			if(distances[nearest[q].index] != sorted[0]) return false;
+			if(counts[q] != k) return false;
+			for(std::size_t n{0}; n<k; ++n)
+				if(distances[knn[q*k+n].index] != sorted[n]) return false;
+
+			std::vector<std::uint32_t> found;
+			tree.query_radius(queries[q], 15.f, found);
+			std::size_t expected{ 0 };
+			for(auto d : distances) expected += d <= 15.f*15.f;
+			if(found.size() != expected) return false;
+		}
+		std::cout << "Nearest to the first query: " << cloud[nearest[0].index]
+				  << " at " << nearest[0].distance << std::endl;
+	}
+	{
+		using Rect = drop::math::Rect;
+		using Vector2 = drop::math::Vector2;
+		auto loose_test{ Timer("Loose Quadtree and Octree (50k players, 5 frames)") };
+
+		auto world{ Rect(0.f, 0.f, 2000.f, 2000.f) };
+		auto tree{ drop::math::Loose_Quadtree(world) };
+		std::vector<Rect> players;
+		std::vector<std::uint32_t> ids;
+		for(int n{0}; n<50000; ++n){
+			players.emplace_back(rand()%20000*0.1f, rand()%20000*0.1f, 1.f+rand()%30*0.1f, 1.f);
+			ids.push_back(tree.insert(players.back()));
+		}
+
+		std::size_t stayed{ 0 };
+		for(int frame{0}; frame<5; ++frame){
+			for(std::size_t n{0}; n<players.size(); ++n){
+				const auto step{ Vector2((rand()%21-10)*0.05f, (rand()%21-10)*0.05f) };
+				players[n] = Rect(players[n].getMin()+step, players[n].getMax()+step);
+				stayed += tree.update(ids[n], players[n]);
+			}
+
+			auto region{ Rect(rand()%1800*1.f, rand()%1800*1.f, 150.f, 100.f) };
+			std::vector<std::uint32_t> found;
+			tree.query(region, found);
+			std::size_t expected{ 0 };
+			for(auto& p : players) expected += p.intersects(region);
+			if(found.size() != expected) return false;
+
+			auto center{ Vector2(rand()%2000*1.f, rand()%2000*1.f) };
+			std::size_t in_circle{ 0 }, expected_circle{ 0 };
+			tree.for_each_in_radius(center, 60.f, [&](std::uint32_t){ ++in_circle; });
+			for(auto& p : players){
+				const auto dx{ std::max(std::max(p.getXMin()-center.getX(), center.getX()-p.getXMax()), 0.f) };
+				const auto dy{ std::max(std::max(p.getYMin()-center.getY(), center.getY()-p.getYMax()), 0.f) };
+				expected_circle += dx*dx + dy*dy <= 60.f*60.f;
+			}
+			if(in_circle != expected_circle) return false;
+		}
+		std::cout << stayed << " of " << 5*players.size()
+				  << " updates stayed in their node" << std::endl;
+
+		for(std::size_t n{0}; n<ids.size(); n += 2) tree.remove(ids[n]);
+		if(tree.size() != players.size()/2) return false;
+		std::vector<std::uint32_t> everything;
+		tree.query(Rect(-10.f, -10.f, 2020.f, 2020.f), everything);
+		if(everything.size() != players.size()/2) return false;
+
+		using AABB3 = drop::math::AABB3;
+		using Vector3 = drop::math::Vector3;
+		auto octree{ drop::math::Loose_Octree(AABB3(Vector3(0.f, 0.f, 0.f), Vector3(100.f, 100.f, 100.f))) };
+		std::vector<AABB3> bodies;
+		for(int n{0}; n<5000; ++n){
+			auto p{ Vector3(rand()%1000*0.1f, rand()%1000*0.1f, rand()%1000*0.1f) };
+			bodies.emplace_back(p, p+Vector3(0.5f, 0.5f, 0.5f));
+			octree.insert(bodies.back());
+		}
+		auto slab{ AABB3(Vector3(-1.f, 40.f, -1.f), Vector3(101.f, 45.f, 101.f)) };
+		std::size_t classified{ 0 }, expected_slab{ 0 };
+		octree.for_each_classified([&slab](const AABB3& bounds){
+			if(!bounds.intersects(slab)) return drop::math::Containment::outside;
+			return slab.contains(bounds) ? drop::math::Containment::inside
+										 : drop::math::Containment::intersects;
+		}, [&](std::uint32_t){ ++classified; });
+		for(auto& b : bodies) expected_slab += b.intersects(slab);
+		if(classified != expected_slab) return false;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		auto curve_test{ Timer("Morton and Hilbert Curves") };
+
+		for(int n{0}; n<1000; ++n){
+			const auto x{ static_cast<std::uint32_t>(rand()) }, y{ static_cast<std::uint32_t>(rand()) };
+			const auto z{ static_cast<std::uint32_t>(rand()) & 0x1fffff };
+			std::uint32_t dx, dy, dz;
+			drop::math::morton_decode(drop::math::morton_encode(x, y), dx, dy);
+			if(dx != x || dy != y) return false;
+			drop::math::morton_decode(drop::math::morton_encode(x & 0x1fffff, y & 0x1fffff, z), dx, dy, dz);
+			if(dx != (x & 0x1fffff) || dy != (y & 0x1fffff) || dz != z) return false;
+		}
+		if(drop::math::morton_encode(3, 5) != 0x27) return false;
+
+		// consecutive Hilbert indices are always neighbouring cells
+		std::vector<std::pair<std::uint64_t, std::array<int, 3>>> cells;
+		for(int x{0}; x<8; ++x)
+			for(int y{0}; y<8; ++y)
+				for(int z{0}; z<8; ++z)
+					cells.push_back({ drop::math::hilbert_index(x, y, z, 3), { x, y, z } });
+		std::sort(cells.begin(), cells.end());
+		for(std::size_t n{0}; n<cells.size(); ++n){
+			if(cells[n].first != n) return false;
+			if(n == 0) continue;
+			int steps{ 0 };
+			for(int a{0}; a<3; ++a) steps += std::abs(cells[n].second[a]-cells[n-1].second[a]);
+			if(steps != 1) return false;
+		}
+		cells.clear();
+		for(int x{0}; x<16; ++x)
+			for(int y{0}; y<16; ++y)
+				cells.push_back({ drop::math::hilbert_index(x, y, 4), { x, y, 0 } });
+		std::sort(cells.begin(), cells.end());
+		for(std::size_t n{1}; n<cells.size(); ++n)
+			if(std::abs(cells[n].second[0]-cells[n-1].second[0])
+			 + std::abs(cells[n].second[1]-cells[n-1].second[1]) != 1) return false;
+
+		std::vector<float> xs, ys, zs;
+		std::vector<Vector3> points;
+		for(int n{0}; n<100000; ++n){
+			points.emplace_back(rand()%10000*0.1f, rand()%10000*0.1f, rand()%10000*0.1f);
+			xs.push_back(points.back().getX());
+			ys.push_back(points.back().getY());
+			zs.push_back(points.back().getZ());
+		}
+		const auto bounds{ drop::math::compute_bounds(points.data(), points.size()) };
+		std::vector<std::uint64_t> keys;
+		for(auto& p : points) keys.push_back(drop::math::hilbert_index(p, bounds, 10));
+
+		std::vector<std::uint32_t> order(points.size());
+		drop::math::radix_sort(keys.data(), keys.size(), order.data());
+		std::vector<std::uint32_t> expected(points.size());
+		for(std::size_t n{0}; n<expected.size(); ++n) expected[n] = static_cast<std::uint32_t>(n);
+		std::stable_sort(expected.begin(), expected.end(),
+			[&](std::uint32_t a, std::uint32_t b){ return keys[a] < keys[b]; });
+		if(order != expected) return false;
+
+		drop::math::reorder(order.data(), order.size(), xs.data(), ys.data(), zs.data(), keys.data());
+		for(std::size_t n{0}; n<xs.size(); ++n){
+			if(xs[n] != points[order[n]].getX() || zs[n] != points[order[n]].getZ()) return false;
+			if(n && keys[n-1] > keys[n]) return false;
+		}
+
+		drop::math::morton_order(points.data(), points.size(), order.data());
+		auto walk{ 0.f };
+		for(std::size_t n{1}; n<order.size(); ++n)
+			walk += (points[order[n]]-points[order[n-1]]).length();
+		std::cout << "Average step along the Morton order: " << walk/order.size() << std::endl;
+	}
+	{
+		using AABB3 = drop::math::AABB3;
+		using Vector3 = drop::math::Vector3;
+		using Line3 = drop::math::Line3;
+		using Vector2 = drop::math::Vector2;
+		using Line2 = drop::math::Line2;
+		using Rect = drop::math::Rect;
+		auto packet_test{ Timer("Packet Ray vs AABB Slab Tests") };
+
+		// reference: the scalar slab test on a single segment
+		auto reference{ [](const float* from, const float* dir, const AABB3& box, int dim){
+			auto enter{ 0.f }, exit{ 1.f };
+			for(int a{0}; a<dim; ++a){
+				if(dir[a] == 0.f){
+					if(from[a] < box.getMin(a) || from[a] > box.getMax(a)) return drop::math::inf;
+					continue;
+				}
+				const auto t0{ (box.getMin(a)-from[a])/dir[a] };
+				const auto t1{ (box.getMax(a)-from[a])/dir[a] };
+				enter = std::max(enter, std::min(t0, t1));
+				exit = std::min(exit, std::max(t0, t1));
+			}
+			return enter <= exit ? enter : drop::math::inf;
+		}};
+
+		std::vector<Line3> rays;
+		for(int n{0}; n<1003; ++n){
+			auto from{ Vector3(rand()%200*0.1f-10.f, rand()%200*0.1f-10.f, rand()%200*0.1f-10.f) };
+			auto to{ Vector3(rand()%200*0.1f-10.f, rand()%200*0.1f-10.f, n%7 ? rand()%200*0.1f-10.f : from.getZ()) };
+			rays.emplace_back(from, to);
+		}
+		auto box{ AABB3(Vector3(-3.f, -2.f, -4.f), Vector3(2.f, 5.f, 1.f)) };
+		std::vector<std::uint32_t> masks((rays.size()+3)/4);
+		std::vector<float> t_enter(rays.size());
+
+		auto check_rays{ [&](int width){
+			std::size_t expected_hits{ 0 };
+			for(std::size_t n{0}; n<rays.size(); ++n){
+				const auto dir{ rays[n].getDir() };
+				const float from[3]{ rays[n].getFrom().getX(), rays[n].getFrom().getY(), rays[n].getFrom().getZ() };
+				const float d[3]{ dir.getX(), dir.getY(), dir.getZ() };
+				const auto t{ reference(from, d, box, 3) };
+				const bool hit{ ((masks[n/width] >> (n%width)) & 1u) != 0 };
+				if(hit != (t != drop::math::inf)) return false;
+				if(hit && std::fabs(t-t_enter[n]) > 0.0001f) return false;
+				expected_hits += hit;
+			}
+			return expected_hits > 0;
+		}};
+		drop::math::raycast_batch<4>(rays.data(), rays.size(), box, masks.data(), t_enter.data());
+		if(!check_rays(4)) return false;
+		drop::math::raycast_batch<8>(rays.data(), rays.size(), box, masks.data(), t_enter.data());
+		if(!check_rays(8)) return false;
+		const auto hits{ drop::math::raycast_batch<16>(rays.data(), rays.size(), box, masks.data(), t_enter.data()) };
+		if(!check_rays(16)) return false;
+		std::cout << hits << " of " << rays.size() << " rays hit the box" << std::endl;
+
+		std::vector<AABB3> boxes;
+		for(int n{0}; n<999; ++n){
+			auto p{ Vector3(rand()%200*0.1f-10.f, rand()%200*0.1f-10.f, rand()%200*0.1f-10.f) };
+			boxes.emplace_back(p, p+Vector3(1.f+rand()%20*0.1f, 1.f, 2.f));
+		}
+		auto ray{ Line3(Vector3(-12.f, -1.f, 0.5f), Vector3(12.f, 1.f, -0.5f)) };
+		t_enter.resize(boxes.size());
+		masks.resize((boxes.size()+7)/8);
+		drop::math::raycast_batch<8>(ray, boxes.data(), boxes.size(), masks.data(), t_enter.data());
+		const auto dir{ ray.getDir() };
+		const float from[3]{ -12.f, -1.f, 0.5f };
+		const float d[3]{ dir.getX(), dir.getY(), dir.getZ() };
+		for(std::size_t n{0}; n<boxes.size(); ++n){
+			const auto t{ reference(from, d, boxes[n], 3) };
+			if(((masks[n/8] >> (n%8)) & 1u) != (t != drop::math::inf)) return false;
+		}
+
+		std::vector<Rect> walls;
+		for(int n{0}; n<37; ++n) walls.emplace_back(n*3.f, 0.f, 1.f, 2.f+n%3);
+		auto sight{ Line2(Vector2(-1.f, 2.5f), Vector2(120.f, 0.5f)) };
+		masks.assign((walls.size()+3)/4, 0);
+		t_enter.resize(walls.size());
+		drop::math::raycast_batch<4>(sight, walls.data(), walls.size(), masks.data(), t_enter.data());
+		const float from2[2]{ -1.f, 2.5f };
+		const float d2[2]{ 121.f, -2.f };
+		for(std::size_t n{0}; n<walls.size(); ++n){
+			const auto t{ reference(from2, d2, AABB3(walls[n]), 2) };
+			if(((masks[n/4] >> (n%4)) & 1u) != (t != drop::math::inf)) return false;
+			if(t != drop::math::inf && std::fabs(t-t_enter[n]) > 0.0001f) return false;
+		}
+
+		// a partial last packet with every box missed reports nothing
+		masks.assign(1, 0);
+		const auto missed{ Line3(Vector3(50.f, 50.f, 50.f), Vector3(60.f, 50.f, 50.f)) };
+		if(drop::math::raycast_batch<8>(missed, boxes.data(), 5, masks.data(), t_enter.data()) != 0 || masks[0] != 0) return false;
+		const auto above{ Line2(Vector2(-1.f, 10.f), Vector2(5.f, 10.f)) };
+		if(drop::math::raycast_batch<4>(above, walls.data(), 1, masks.data(), t_enter.data()) != 0 || masks[0] != 0) return false;
+		std::size_t first_hit{ 0 };
+		while(reference(from2, d2, AABB3(walls[first_hit]), 2) == drop::math::inf) ++first_hit;
+		if(drop::math::raycast_batch<4>(sight, walls.data()+first_hit, 1, masks.data(), t_enter.data()) != 1
+		|| masks[0] != 1u) return false;
+	}
+	{
+		using AABB3 = drop::math::AABB3;
+		using Vector3 = drop::math::Vector3;
+		using Vector4 = drop::math::Vector4;
+		using Matrix_4x4 = drop::math::Matrix_4x4;
+		using Containment = drop::math::Containment;
+		auto frustum_test{ Timer("Frustum Culling (100k boxes and spheres)") };
+
+		// OpenGL style perspective, 90 degree fov, camera at the origin looking down -z
+		const auto near_z{ 1.f }, far_z{ 500.f };
+		auto projection{ Matrix_4x4(
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.f, 0.f, 0.f,
+			0.f, 0.f, (far_z+near_z)/(near_z-far_z), -1.f,
+			0.f, 0.f, 2.f*far_z*near_z/(near_z-far_z), 0.f
+		)};
+		auto frustum{ drop::math::Frustum::from_matrix(projection) };
+		std::cout << "Near plane: " << frustum.getPlane(drop::math::Frustum::near_side) << std::endl;
+
+		for(int n{0}; n<2000; ++n){
+			auto p{ Vector3(rand()%2000*0.5f-500.f, rand()%2000*0.5f-500.f, rand()%2000*-0.3f) };
+			auto clip{ projection.applyTo(Vector4(p.getX(), p.getY(), p.getZ(), 1.f)) };
+			const auto w{ clip.getW() };
+			const auto inside{ std::fabs(clip.getX()) <= w && std::fabs(clip.getY()) <= w
+							&& std::fabs(clip.getZ()) <= w };
+			if(std::fabs(std::fabs(clip.getX())-w) < 0.01f || std::fabs(std::fabs(clip.getY())-w) < 0.01f)
+				continue;
+			if(frustum.contains(p) != inside) return false;
+		}
+
+		auto plane{ drop::math::Normal_Plane3(drop::math::Plane3(
+			Vector3(0.f, 0.f, 2.f), Vector3(1.f, 0.f, 0.f), Vector3(0.f, 1.f, 0.f))) };
+		if(std::fabs(plane.signed_distance(Vector3(5.f, 5.f, 7.f)) - 5.f) > 0.0001f) return false;
+
+		std::vector<AABB3> boxes;
+		std::vector<float> xs, ys, zs, radii;
+		for(int n{0}; n<100000; ++n){
+			auto p{ Vector3(rand()%2000*0.6f-600.f, rand()%2000*0.6f-600.f, rand()%2000*-0.3f+20.f) };
+			boxes.emplace_back(p, p+Vector3(1.f+rand()%40*0.1f, 2.f, 1.f));
+			xs.push_back(p.getX());
+			ys.push_back(p.getY());
+			zs.push_back(p.getZ());
+			radii.push_back(1.f+rand()%30*0.1f);
+		}
+
+		std::vector<std::uint32_t> masks((boxes.size()+31)/32);
+		const auto visible{ frustum.cull_boxes(boxes.data(), boxes.size(), masks.data(), 4) };
+		std::size_t expected{ 0 };
+		for(std::size_t n{0}; n<boxes.size(); ++n){
+			const auto hit{ frustum.intersects(boxes[n]) };
+			if(hit != (((masks[n/32] >> (n%32)) & 1u) != 0)) return false;
+			expected += hit;
+		}
+		if(visible != expected) return false;
+		std::cout << visible << " of " << boxes.size() << " boxes visible" << std::endl;
+
+		frustum.cull_spheres(xs.data(), ys.data(), zs.data(), radii.data(), xs.size(), masks.data());
+		for(std::size_t n{0}; n<xs.size(); ++n){
+			const auto hit{ frustum.intersects(Vector3(xs[n], ys[n], zs[n]), radii[n]) };
+			if(hit != (((masks[n/32] >> (n%32)) & 1u) != 0)) return false;
+		}
+
+		auto bvh{ drop::math::Bvh3(boxes.data(), boxes.size()) };
+		std::vector<char> seen(boxes.size(), 0);
+		std::size_t reported{ 0 };
+		frustum.for_each_visible(bvh, [&](std::uint32_t index){ seen[index] = 1; ++reported; });
+		if(reported != expected) return false;
+		for(std::size_t n{0}; n<boxes.size(); ++n)
+			if(seen[n] != (frustum.classify(boxes[n]) != Containment::outside)) return false;
+
+		auto octree{ drop::math::Loose_Octree(AABB3(Vector3(-600.f, -600.f, -600.f), Vector3(600.f, 600.f, 20.f))) };
+		for(auto& b : boxes) octree.insert(b);
+		reported = 0;
+		frustum.for_each_visible(octree, [&](std::uint32_t){ ++reported; });
+		if(reported != expected) return false;
+	}
+	{
+		using Vector3 = drop::math::Vector3;
+		using Line3 = drop::math::Line3;
+		auto mesh_test{ Timer("Triangle Mesh Raycast (80k triangles)") };
+
+		// height field terrain, two triangles per grid cell
+		constexpr int side{ 201 };
+		std::vector<Vector3> vertices;
+		for(int z{0}; z<side; ++z)
+			for(int x{0}; x<side; ++x)
+				vertices.emplace_back(x*1.f, std::sin(x*0.1f)*std::cos(z*0.13f)*5.f, z*1.f);
+		std::vector<std::uint32_t> indices;
+		for(int z{0}; z+1<side; ++z)
+			for(int x{0}; x+1<side; ++x){
+				const auto i{ static_cast<std::uint32_t>(z*side+x) };
+				indices.insert(indices.end(), { i, i+1, i+side, i+1, i+side+1, i+side });
+			}
+		auto mesh{ drop::math::Triangle_Mesh(vertices.data(), indices.data(), indices.size()/3) };
+
+		auto check{ Line3(Vector3(0.2f, 10.f, 0.3f), Vector3(0.2f, -10.f, 0.3f)) };
+		const auto t{ check.intersect_fraction(vertices[0], vertices[1], vertices[side]) };
+		if(std::fabs(t-0.5f) > 0.01f) return false;
+
+		// a millimetre triangle and a 10 cm segment through its middle
+		const Vector3 tiny[]{ Vector3(0.f, 0.f, 0.f), Vector3(0.001f, 0.f, 0.f), Vector3(0.f, 0.f, 0.001f) };
+		const std::uint32_t tiny_index[]{ 0, 1, 2 };
+		const auto probe{ Line3(Vector3(0.0002f, 0.05f, 0.0002f), Vector3(0.0002f, -0.05f, 0.0002f)) };
+		if(std::fabs(probe.intersect_fraction(tiny[0], tiny[1], tiny[2])-0.5f) > 0.001f) return false;
+		auto tiny_mesh{ drop::math::Triangle_Mesh(tiny, tiny_index, 1) };
+		const auto tiny_hit{ tiny_mesh.raycast(probe) };
+		if(tiny_hit.index != 0 || std::fabs(tiny_hit.fraction-0.5f) > 0.001f) return false;
+
+		std::vector<Line3> shots;
+		for(int n{0}; n<300; ++n)
+			shots.emplace_back(
+				Vector3(rand()%2000*0.1f, 20.f, rand()%2000*0.1f),
+				Vector3(rand()%2000*0.1f, -20.f+rand()%10, rand()%2000*0.1f)
+			);
+		std::vector<drop::math::Triangle_Hit> hits(shots.size());
+		mesh.raycast_batch(shots.data(), shots.size(), hits.data(), 4);
+
+		for(std::size_t n{0}; n<shots.size(); n += 3){
+			auto best{ drop::math::inf };
+			for(std::size_t tri{0}; tri<indices.size()/3; ++tri)
+				best = std::min(best, shots[n].intersect_fraction(vertices[indices[3*tri]],
+							vertices[indices[3*tri+1]], vertices[indices[3*tri+2]]));
+			if(std::fabs(best-hits[n].fraction) > 0.0001f) return false;
+			if(hits[n].index == drop::math::Triangle_Hit::npos) continue;
+
+			const auto& v0{ vertices[indices[3*hits[n].index]] };
+			const auto& v1{ vertices[indices[3*hits[n].index+1]] };
+			const auto& v2{ vertices[indices[3*hits[n].index+2]] };
+			const auto on_mesh{ v0*(1.f-hits[n].u-hits[n].v) + v1*hits[n].u + v2*hits[n].v };
+			const auto on_ray{ shots[n].getFrom() + shots[n].getDir()*hits[n].fraction };
+			if((on_mesh-on_ray).length() > 0.01f) return false;
+		}
+		std::cout << "First shot hit triangle " << hits[0].index
+				  << " at " << shots[0].intersect_point(
+						vertices[indices[3*hits[0].index]], vertices[indices[3*hits[0].index+1]],
+						vertices[indices[3*hits[0].index+2]]) << std::endl;
+	}
+	return true;
+}
@@ -8,6 +8,10 @@
 #include "line_box_tests.hpp"
 #include "PowZ_tests.hpp"
 #include "general_tests.hpp"
+#include "spatial_tests.hpp"
+#include "collision_tests.hpp"
+#include "geometry_tests.hpp"
+#include "curve_tests.hpp"
 
 int main(){
 	std::cout << "dropMath Version: " << drop_math_test_VERSION_MAJOR
@@ -38,4 +42,24 @@ int main(){
 		return 5;
 	}
 
+	if(!spatial_tests()){
+		std::cerr << "Spatial tests failed!" << std::endl;
+		return 6;
+	}
+
+	if(!collision_tests()){
+		std::cerr << "Collision tests failed!" << std::endl;
+		return 7;
+	}
+
+	if(!geometry_tests()){
+		std::cerr << "Geometry tests failed!" << std::endl;
+		return 8;
+	}
+
+	if(!curve_tests()){
+		std::cerr << "Curve tests failed!" << std::endl;
+		return 9;
+	}
+
 }